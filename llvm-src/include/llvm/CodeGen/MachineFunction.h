@@ -322,6 +322,9 @@ class MachineFunction {
   /// CodeView label annotations.
   std::vector<std::pair<MCSymbol *, MDNode *>> CodeViewAnnotations;
 
+  /// [OS-CFI] Call-site labels of the calls of the function.
+  DenseMap<const MachineInstr *, const MDNode *> CallSiteLabels;
+
   bool CallsEHReturn = false;
   bool CallsUnwindInit = false;
   bool HasEHScopes = false;
@@ -855,6 +858,28 @@ public:
     return CodeViewAnnotations;
   }
 
+  /// [OS-CFI] Record the call-site label of a call instruction.
+  void addCallSiteLabel(const MachineInstr *MI, const MDNode *Label) {
+    CallSiteLabels[MI] = Label;
+  }
+
+  /// [OS-CFI] Return the call-site label of a call instruction, or null. The
+  /// label holds the global whose symbol is the return address of the call.
+  const MDNode *getCallSiteLabel(const MachineInstr *MI) const {
+    return CallSiteLabels.lookup(MI);
+  }
+
+  /// [OS-CFI] Move the call-site label of a call to the instruction that
+  /// replaces it, e.g. when a load is folded into the call.
+  void moveCallSiteLabel(const MachineInstr *Old, const MachineInstr *New) {
+    auto It = CallSiteLabels.find(Old);
+    if (It == CallSiteLabels.end())
+      return;
+    const MDNode *Label = It->second;
+    CallSiteLabels.erase(It);
+    CallSiteLabels[New] = Label;
+  }
+
   /// Return a reference to the C++ typeinfo for the current function.
   const std::vector<const GlobalValue *> &getTypeInfos() const {
     return TypeInfos;
@@ -268,6 +268,10 @@ class SelectionDAG {
   /// Tracks dbg_value and dbg_label information through SDISel.
   SDDbgInfo *DbgInfo;
 
+  /// [OS-CFI] Call-site labels of call nodes, handed to the MachineFunction
+  /// when the nodes are emitted.
+  DenseMap<const SDNode *, const MDNode *> CallSiteLabels;
+
   uint16_t NextPersistentId = 0;
 
 public:
@@ -1350,6 +1354,16 @@ public:
     return DbgInfo->getSDDbgValues(SD);
   }
 
+  /// [OS-CFI] Record the call-site label of a call node.
+  void addCallSiteLabel(const SDNode *Node, const MDNode *Label) {
+    CallSiteLabels[Node] = Label;
+  }
+
+  /// [OS-CFI] Return the call-site label of a call node, or null.
+  const MDNode *getCallSiteLabel(const SDNode *Node) const {
+    return CallSiteLabels.lookup(Node);
+  }
+
 public:
   /// Return true if there are any SDDbgValue nodes associated
   /// with this SelectionDAG.
@@ -21,6 +21,7 @@
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
@@ -65,6 +66,7 @@
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/GlobalAlias.h"
 #include "llvm/IR/GlobalIFunc.h"
@@ -1024,6 +1026,70 @@ static bool needFuncLabelsForEHOrDebugInfo(const MachineFunction &MF,
       classifyEHPersonality(MF.getFunction().getPersonalityFn()));
 }
 
+/// [OS-CFI] The global whose symbol a call-site label defines.
+static const GlobalValue *getCallSiteLabelGlobal(const MDNode *Label) {
+  if (Label->getNumOperands() == 0)
+    return nullptr;
+  return mdconst::dyn_extract_or_null<GlobalValue>(Label->getOperand(0));
+}
+
+/// [OS-CFI] Whether the block of an instruction is reachable from the entry
+/// of its function.
+static bool isReachableFromEntry(const Instruction *I) {
+  const BasicBlock *BB = I->getParent();
+  const BasicBlock *Entry = &BB->getParent()->getEntryBlock();
+  for (const BasicBlock *Reached : depth_first(Entry))
+    if (Reached == BB)
+      return true;
+  return false;
+}
+
+/// [OS-CFI] Set the call-site labels no return address defined to null. The
+/// monitors then reject every context through the call, so a null label is
+/// only silent when its call is gone or unreachable. Only X86 call lowering
+/// defines labels, other targets get a single warning.
+static void emitUndefinedCallSiteLabels(AsmPrinter &AP, Module &M) {
+  const NamedMDNode *Labels = M.getNamedMetadata("oscfi.cs.labels");
+  if (!Labels)
+    return;
+
+  DenseMap<const MDNode *, const Instruction *> LabeledCalls;
+  for (const Function &F : M)
+    for (const BasicBlock &BB : F)
+      for (const Instruction &I : BB)
+        if (const MDNode *Label = I.getMetadata("oscfi.cs.label"))
+          LabeledCalls[Label] = &I;
+
+  bool DefinesLabels = AP.TM.getTargetTriple().getArch() == Triple::x86 ||
+                       AP.TM.getTargetTriple().getArch() == Triple::x86_64;
+  if (!DefinesLabels && !LabeledCalls.empty()) {
+    const Instruction *Call = LabeledCalls.begin()->second;
+    M.getContext().diagnose(DiagnosticInfoUnsupported(
+        *Call->getFunction(),
+        "call-site labels are only defined by X86 call lowering, all "
+        "return address labels are null",
+        DiagnosticLocation(), DS_Warning));
+  }
+
+  for (const MDNode *Label : Labels->operands()) {
+    const GlobalValue *GV = getCallSiteLabelGlobal(Label);
+    if (!GV)
+      continue;
+    MCSymbol *Sym = AP.getSymbol(GV);
+    if (!Sym->isUndefined())
+      continue;
+    const Instruction *Call = LabeledCalls.lookup(Label);
+    if (DefinesLabels && Call && isReachableFromEntry(Call))
+      M.getContext().diagnose(DiagnosticInfoUnsupported(
+          *Call->getFunction(),
+          "call-site label " + GV->getName() +
+              " lost its call during code generation, it is null",
+          DiagnosticLocation(Call->getDebugLoc()), DS_Warning));
+    AP.OutStreamer->EmitAssignment(Sym,
+                                   MCConstantExpr::create(0, AP.OutContext));
+  }
+}
+
 /// EmitFunctionBody - This method emits the body and trailer for a
 /// function.
 void AsmPrinter::EmitFunctionBody() {
@@ -1114,6 +1180,13 @@ void AsmPrinter::EmitFunctionBody() {
         break;
       default:
         EmitInstruction(&MI);
+        // [OS-CFI] the label of a call-site is its return address
+        if (const MDNode *Label = MF->getCallSiteLabel(&MI))
+          if (const GlobalValue *GV = getCallSiteLabelGlobal(Label)) {
+            MCSymbol *Sym = getSymbol(GV);
+            if (Sym->isUndefined())
+              OutStreamer->EmitLabel(Sym);
+          }
         break;
       }
 
@@ -1357,6 +1430,10 @@ bool AsmPrinter::doFinalization(Module &M) {
   for (const auto &G : M.globals())
     EmitGlobalVariable(&G);
 
+  // [OS-CFI] a labeled call-site the code generator removed is never a return
+  // address, its label is null
+  emitUndefinedCallSiteLabels(*this, M);
+
   // Emit remaining GOT equivalent globals.
   emitGlobalGOTEquivs();
 
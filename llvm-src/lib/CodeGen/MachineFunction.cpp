@@ -342,6 +342,8 @@ MachineFunction::DeleteMachineInstr(MachineInstr *MI) {
   // independently recyclable.
   if (MI->Operands)
     deallocateOperandArray(MI->CapOperands, MI->Operands);
+  // [OS-CFI] the recycled instruction must not inherit the label.
+  CallSiteLabels.erase(MI);
   // Don't call ~MachineInstr() which must be trivial anyway because
   // ~MachineFunction drops whole lists of MachineInstrs wihout calling their
   // destructors.
@@ -412,6 +412,13 @@ bool MachineInstr::isIdenticalTo(const MachineInstr &Other,
       Other.getNumOperands() != getNumOperands())
     return false;
 
+  // [OS-CFI] calls with different call-site labels must keep their own
+  // return addresses.
+  if (isCall() && getParent() && Other.getParent() &&
+      getMF()->getCallSiteLabel(this) !=
+          Other.getMF()->getCallSiteLabel(&Other))
+    return false;
+
   if (isBundle()) {
     // We have passed the test above that both instructions have the same
     // opcode, so we know that both instructions are bundles here. Let's compare
@@ -1601,6 +1601,10 @@ bool FastISel::selectInstruction(const Instruction *I) {
     if (F && F->getIntrinsicID() == Intrinsic::trap &&
         Call->hasFnAttr("trap-func-name"))
       return false;
+
+    // [OS-CFI] SelectionDAG carries the call-site label to the call.
+    if (Call->getMetadata("oscfi.cs.label"))
+      return false;
   }
 
   // First, try doing target-independent selection.
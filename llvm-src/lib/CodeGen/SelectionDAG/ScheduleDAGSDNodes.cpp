@@ -805,6 +805,26 @@ EmitSchedule(MachineBasicBlock::iterator &InsertPos) {
   SmallSet<unsigned, 8> Seen;
   bool HasDbg = DAG->hasDebugValues();
 
+  // [OS-CFI] emit a node, the call of a labeled call node takes the label
+  auto EmitNode = [&](SDNode *Node, bool IsClone, bool IsCloned) {
+    const MDNode *Label = DAG->getCallSiteLabel(Node);
+    MachineBasicBlock *MBB = Emitter.getBlock();
+    MachineBasicBlock::iterator Pos = Emitter.getInsertPos();
+    bool AtBegin = Pos == MBB->begin();
+    MachineBasicBlock::iterator Prev = AtBegin ? MBB->end() : std::prev(Pos);
+    Emitter.EmitNode(Node, IsClone, IsCloned, VRBaseMap);
+    if (!Label || Emitter.getBlock() != MBB)
+      return;
+    for (MachineBasicBlock::iterator I = AtBegin ? MBB->begin()
+                                                 : std::next(Prev);
+         I != Emitter.getInsertPos(); ++I) {
+      if (I->isCall()) {
+        MF.addCallSiteLabel(&*I, Label);
+        break;
+      }
+    }
+  };
+
   // If this is the first BB, emit byval parameter dbg_value's.
   if (HasDbg && BB->getParent()->begin() == MachineFunction::iterator(BB)) {
     SDDbgInfo::DbgIterator PDI = DAG->ByvalParmDbgBegin();
@@ -837,14 +857,13 @@ EmitSchedule(MachineBasicBlock::iterator &InsertPos) {
       GluedNodes.push_back(N);
     while (!GluedNodes.empty()) {
       SDNode *N = GluedNodes.back();
-      Emitter.EmitNode(N, SU->OrigNode != SU, SU->isCloned, VRBaseMap);
+      EmitNode(N, SU->OrigNode != SU, SU->isCloned);
       // Remember the source order of the inserted instruction.
       if (HasDbg)
         ProcessSourceNode(N, DAG, Emitter, VRBaseMap, Orders, Seen);
       GluedNodes.pop_back();
     }
-    Emitter.EmitNode(SU->getNode(), SU->OrigNode != SU, SU->isCloned,
-                     VRBaseMap);
+    EmitNode(SU->getNode(), SU->OrigNode != SU, SU->isCloned);
     // Remember the source order of the inserted instruction.
     if (HasDbg)
       ProcessSourceNode(SU->getNode(), DAG, Emitter, VRBaseMap, Orders,
@@ -607,6 +607,10 @@ bool TailDuplicator::shouldTailDuplicate(bool IsSimple,
     if (MI.isConvergent())
       return false;
 
+    // [OS-CFI] a call-site label is defined at a single return address.
+    if (MI.isCall() && TailBB.getParent()->getCallSiteLabel(&MI))
+      return false;
+
     // Do not duplicate 'return' instructions if this is a pre-regalloc run.
     // A return may expand into a lot more instructions (e.g. reload of callee
     // saved registers) after PEI.
@@ -584,6 +584,8 @@ MachineInstr *TargetInstrInfo::foldMemoryOperand(MachineInstr &MI,
   }
 
   if (NewMI) {
+    // [OS-CFI] the folded call keeps the return address label.
+    MF.moveCallSiteLabel(&MI, NewMI);
     NewMI->setMemRefs(MI.memoperands_begin(), MI.memoperands_end());
     // Add a memory operand, foldMemoryOperandImpl doesn't do that.
     assert((!(Flags & MachineMemOperand::MOStore) ||
@@ -651,6 +653,8 @@ MachineInstr *TargetInstrInfo::foldMemoryOperand(MachineInstr &MI,
 
   if (!NewMI)
     return nullptr;
+  // [OS-CFI] the folded call keeps the return address label.
+  MF.moveCallSiteLabel(&MI, NewMI);
 
   // Copy the memoperands from the load to the folded instruction.
   if (MI.memoperands_empty()) {
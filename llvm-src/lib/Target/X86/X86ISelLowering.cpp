@@ -3460,11 +3460,14 @@ X86TargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
       (CI && CI->doesNoCfCheck()) || (II && II->doesNoCfCheck());
   const Module *M = MF.getMMI().getModule();
   Metadata *IsCFProtectionSupported = M->getModuleFlag("cf-protection-branch");
+  // [OS-CFI] the return address of a labeled call-site is its label
+  const MDNode *CSLabel =
+      CLI.CS ? CLI.CS.getInstruction()->getMetadata("oscfi.cs.label") : nullptr;
 
   if (CallConv == CallingConv::X86_INTR)
     report_fatal_error("X86 interrupts may not be called directly");
 
-  if (Attr.getValueAsString() == "true")
+  if (Attr.getValueAsString() == "true" || CSLabel)
     isTailCall = false;
 
   if (Subtarget.isPICStyleGOT() &&
@@ -3949,6 +3952,8 @@ X86TargetLowering::LowerCall(TargetLowering::CallLoweringInfo &CLI,
     Chain = DAG.getNode(X86ISD::CALL, dl, NodeTys, Ops);
   }
   InFlag = Chain.getValue(1);
+  if (CSLabel)
+    DAG.addCallSiteLabel(Chain.getNode(), CSLabel);
 
   // Create the CALLSEQ_END node.
   unsigned NumBytesForCalleeToPop;
@@ -908,8 +908,12 @@ void X86SpeculativeLoadHardeningPass::unfoldCallAndJumpLoads(
         assert(Unfolded &&
                "Computed unfolded register class but failed to unfold");
         // Now stitch the new instructions into place and erase the old one.
-        for (auto *NewMI : NewMIs)
+        for (auto *NewMI : NewMIs) {
           MBB.insert(MI.getIterator(), NewMI);
+          // [OS-CFI] the unfolded call keeps the return address label.
+          if (NewMI->isCall())
+            MF.moveCallSiteLabel(&MI, NewMI);
+        }
         MI.eraseFromParent();
         LLVM_DEBUG({
           dbgs() << "Unfolded load successfully into:\n";
@@ -0,0 +1,454 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/Utils/Local.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "check-elim"
+
+STATISTIC(NumRemoved, "Number of dominated duplicate checks removed");
+STATISTIC(NumHoisted, "Number of loop invariant checks hoisted");
+
+// [OS-CFI] the monitors a call-point may call once INSTCFG ran. The verdict
+// of each one only depends on its arguments, the metadata of the pointer
+// address and the frame of its caller; the target of a vcall monitor is only
+// reported
+static const char *monitorNames[] = {
+    "pcall_reference_monitor",
+    "vcall_reference_monitor",
+    "oscfi_pcall_reference_monitor",
+    "oscfi_pcall_ctx_reference_monitor",
+    "oscfi_pcall_tl_reference_monitor",
+    "oscfi_pcall_ctx_tl_reference_monitor",
+    "oscfi_pcall_reference_monitor_d0",
+    "oscfi_pcall_reference_monitor_d1",
+    "oscfi_pcall_reference_monitor_d2",
+    "oscfi_pcall_reference_monitor_d3",
+    "oscfi_vcall_reference_monitor",
+    "oscfi_vcall_tl_reference_monitor",
+    "static_vcall_reference_monitor"};
+static const char *updateNames[] = {"update_mpx_table", "update_tl_table"};
+
+// how deep the address and pointer of a check are followed
+static const unsigned maxDepth = 8;
+
+typedef std::pair<Function *, Value *> checkKey;
+typedef std::pair<LoadInst *, LoadInst *> loadPair;
+
+class CHECKELIM : public FunctionPass {
+private:
+  bool isCallTo(const Instruction *inst,
+                const std::set<Function *> &callees) const {
+    const CallInst *call = dyn_cast<CallInst>(inst);
+    return call && call->getCalledFunction() &&
+           callees.count(call->getCalledFunction());
+  }
+
+  // the address arguments are ptrtoint of the pointer
+  static Value *getAddrPointer(Value *val) {
+    if (PtrToIntInst *cast = dyn_cast<PtrToIntInst>(val))
+      val = cast->getOperand(0);
+    else if (ConstantExpr *ce = dyn_cast<ConstantExpr>(val))
+      if (ce->getOpcode() == Instruction::PtrToInt)
+        val = ce->getOperand(0);
+    return val->stripPointerCasts();
+  }
+
+  // a vcall monitor gets the vtable slot it calls through as its last
+  // argument, that one only shows up in the report
+  static unsigned getNumCheckedArgs(CallInst *check) {
+    return check->getNumArgOperands() == 4 ? 3 : check->getNumArgOperands();
+  }
+
+  // an alloca only read, written and handed to the monitors is never
+  // written by a call, whatever alias analysis makes of the ptrtoint
+  bool isLocalSlot(const Value *ptr) {
+    const Value *obj = GetUnderlyingObject(ptr, *DL);
+    if (!isa<AllocaInst>(obj))
+      return false;
+    std::map<const Value *, bool>::iterator it = localSlots.find(obj);
+    if (it != localSlots.end())
+      return it->second;
+
+    bool local = true;
+    std::vector<const Value *> work(1, obj);
+    std::set<const Value *> seen;
+    while (local && !work.empty()) {
+      const Value *val = work.back();
+      work.pop_back();
+      if (!seen.insert(val).second)
+        continue;
+      for (const User *user : val->users()) {
+        if (isa<LoadInst>(user))
+          continue;
+        if (const StoreInst *store = dyn_cast<StoreInst>(user)) {
+          local = store->getValueOperand() != val;
+        } else if (isa<BitCastInst>(user) || isa<GetElementPtrInst>(user)) {
+          work.push_back(user);
+        } else if (isa<PtrToIntInst>(user)) {
+          for (const User *intUser : user->users()) {
+            const Instruction *inst = dyn_cast<Instruction>(intUser);
+            if (!inst ||
+                (!isCallTo(inst, monitors) && !isCallTo(inst, updates)))
+              local = false;
+          }
+        } else if (const IntrinsicInst *intr = dyn_cast<IntrinsicInst>(user)) {
+          local = intr->getIntrinsicID() == Intrinsic::lifetime_start ||
+                  intr->getIntrinsicID() == Intrinsic::lifetime_end;
+        } else {
+          local = false;
+        }
+        if (!local)
+          break;
+      }
+    }
+    localSlots[obj] = local;
+    return local;
+  }
+
+  // whether inst may change the memory read by a check or the metadata of
+  // its address
+  bool isClobber(Instruction *inst, ArrayRef<MemoryLocation> locs,
+                 Value *mdAddr) {
+    if (isCallTo(inst, monitors))
+      return false;
+    if (isCallTo(inst, updates)) {
+      Value *addr = getAddrPointer(cast<CallInst>(inst)->getArgOperand(0));
+      return mdAddr && !AA->isNoAlias(MemoryLocation(addr),
+                                      MemoryLocation(mdAddr));
+    }
+    if (!inst->mayWriteToMemory())
+      return false;
+    bool isCall = isa<CallInst>(inst) || isa<InvokeInst>(inst);
+    for (const MemoryLocation &loc : locs) {
+      if (isCall && isLocalSlot(loc.Ptr))
+        continue;
+      if (isModSet(AA->getModRefInfo(inst, loc)))
+        return true;
+    }
+    return false;
+  }
+
+  // whether an instruction on a path from `from` to `to` that does not run
+  // `from` again is a clobber, `from` dominates `to`
+  bool isClobberedBetween(Instruction *from, Instruction *to,
+                          ArrayRef<MemoryLocation> locs, Value *mdAddr) {
+    BasicBlock *fromBB = from->getParent();
+    BasicBlock *toBB = to->getParent();
+    BasicBlock::iterator it = std::next(from->getIterator());
+    if (fromBB == toBB) {
+      for (; &*it != to; ++it)
+        if (isClobber(&*it, locs, mdAddr))
+          return true;
+      return false;
+    }
+    for (; it != fromBB->end(); ++it)
+      if (isClobber(&*it, locs, mdAddr))
+        return true;
+    for (it = toBB->begin(); &*it != to; ++it)
+      if (isClobber(&*it, locs, mdAddr))
+        return true;
+
+    SmallPtrSet<BasicBlock *, 32> reached, between;
+    SmallVector<BasicBlock *, 32> work(succ_begin(fromBB), succ_end(fromBB));
+    while (!work.empty()) {
+      BasicBlock *bb = work.pop_back_val();
+      if (bb == fromBB || !reached.insert(bb).second)
+        continue;
+      work.append(succ_begin(bb), succ_end(bb));
+    }
+    work.append(pred_begin(toBB), pred_end(toBB));
+    while (!work.empty()) {
+      BasicBlock *bb = work.pop_back_val();
+      if (!reached.count(bb) || !between.insert(bb).second)
+        continue;
+      work.append(pred_begin(bb), pred_end(bb));
+    }
+    for (BasicBlock *bb : between)
+      for (Instruction &inst : *bb)
+        if (isClobber(&inst, locs, mdAddr))
+          return true;
+    return false;
+  }
+
+  // a and b compute the same value if the memory their loads read is not
+  // written in between, the loads are paired up
+  bool isEquivalent(Value *a, Value *b, std::vector<loadPair> &loads,
+                    unsigned depth) {
+    if (a == b)
+      return true;
+    Instruction *ia = dyn_cast<Instruction>(a);
+    Instruction *ib = dyn_cast<Instruction>(b);
+    if (!ia || !ib || depth > maxDepth || ia->getOpcode() != ib->getOpcode() ||
+        ia->getType() != ib->getType() ||
+        ia->getNumOperands() != ib->getNumOperands())
+      return false;
+    if (LoadInst *la = dyn_cast<LoadInst>(ia)) {
+      if (!la->isSimple() || !cast<LoadInst>(ib)->isSimple())
+        return false;
+      loads.push_back(loadPair(la, cast<LoadInst>(ib)));
+    } else if (GetElementPtrInst *ga = dyn_cast<GetElementPtrInst>(ia)) {
+      if (ga->getSourceElementType() !=
+          cast<GetElementPtrInst>(ib)->getSourceElementType())
+        return false;
+    } else if (!isa<CastInst>(ia)) {
+      return false;
+    }
+    for (unsigned i = 0; i < ia->getNumOperands(); i++)
+      if (!isEquivalent(ia->getOperand(i), ib->getOperand(i), loads,
+                        depth + 1))
+        return false;
+    return true;
+  }
+
+  // check passes whenever dom passed: both check the same pointer under the
+  // same metadata and nothing in between changes either
+  bool isRedundant(CallInst *dom, CallInst *check) {
+    std::vector<loadPair> loads;
+    for (unsigned i = 0; i < getNumCheckedArgs(check); i++)
+      if (!isEquivalent(dom->getArgOperand(i), check->getArgOperand(i), loads,
+                        0))
+        return false;
+
+    SmallVector<MemoryLocation, 4> locs;
+    for (const loadPair &pair : loads) {
+      MemoryLocation domLoc = MemoryLocation::get(pair.first);
+      MemoryLocation checkLoc = MemoryLocation::get(pair.second);
+      if (isClobberedBetween(pair.first, dom, domLoc, nullptr) ||
+          isClobberedBetween(pair.second, check, checkLoc, nullptr))
+        return false;
+      locs.push_back(domLoc);
+      locs.push_back(checkLoc);
+    }
+    return !isClobberedBetween(dom, check, locs,
+                               getAddrPointer(check->getArgOperand(1)));
+  }
+
+  // whether val can be computed in the preheader: loop invariant, or a cast,
+  // GEP or load of such values. Loads of the vtable roBase are read-only,
+  // the others are collected for the caller
+  bool isHoistable(Value *val, Loop *L, Value *roBase,
+                   SmallVectorImpl<MemoryLocation> &locs, unsigned depth) {
+    if (L->isLoopInvariant(val))
+      return true;
+    Instruction *inst = dyn_cast<Instruction>(val);
+    if (!inst || depth > maxDepth)
+      return false;
+    if (LoadInst *load = dyn_cast<LoadInst>(inst)) {
+      if (!load->isSimple())
+        return false;
+      if (!roBase || GetUnderlyingObject(load->getPointerOperand(), *DL) !=
+                         roBase)
+        locs.push_back(MemoryLocation::get(load));
+    } else if (!isa<CastInst>(inst) && !isa<GetElementPtrInst>(inst)) {
+      return false;
+    }
+    for (Value *op : inst->operands())
+      if (!isHoistable(op, L, roBase, locs, depth + 1))
+        return false;
+    return true;
+  }
+
+  Value *hoist(Value *val, Loop *L, Instruction *insertPt,
+               std::map<Value *, Value *> &clones) {
+    if (L->isLoopInvariant(val))
+      return val;
+    std::map<Value *, Value *>::iterator it = clones.find(val);
+    if (it != clones.end())
+      return it->second;
+    Instruction *inst = cast<Instruction>(val);
+    Instruction *clone = inst->clone();
+    for (unsigned i = 0; i < inst->getNumOperands(); i++)
+      clone->setOperand(i, hoist(inst->getOperand(i), L, insertPt, clones));
+    clone->insertBefore(insertPt);
+    clones[val] = clone;
+    return clone;
+  }
+
+  // the first iteration reaches check: nothing before it leaves the loop,
+  // goes back to the header or may stop the program
+  bool runsOnFirstIteration(CallInst *check, Loop *L) {
+    BasicBlock *checkBB = check->getParent();
+    for (Instruction &inst : *checkBB) {
+      if (&inst == check)
+        break;
+      if (!isCallTo(&inst, monitors) && !isCallTo(&inst, updates) &&
+          !isGuaranteedToTransferExecutionToSuccessor(&inst))
+        return false;
+    }
+
+    SmallPtrSet<BasicBlock *, 32> seen;
+    SmallVector<BasicBlock *, 32> work(1, L->getHeader());
+    while (!work.empty()) {
+      BasicBlock *bb = work.pop_back_val();
+      if (bb == checkBB || !seen.insert(bb).second)
+        continue;
+      for (Instruction &inst : *bb)
+        if (!isCallTo(&inst, monitors) && !isCallTo(&inst, updates) &&
+            !isGuaranteedToTransferExecutionToSuccessor(&inst))
+          return false;
+      for (BasicBlock *succ : successors(bb)) {
+        if (!L->contains(succ) || succ == L->getHeader())
+          return false;
+        work.push_back(succ);
+      }
+    }
+    return true;
+  }
+
+  bool hoistChecks(Loop *L) {
+    BasicBlock *preheader = L->getLoopPreheader();
+    if (!preheader)
+      return false;
+
+    std::vector<CallInst *> checks;
+    for (BasicBlock *bb : L->blocks())
+      for (Instruction &inst : *bb)
+        if (isCallTo(&inst, monitors))
+          checks.push_back(cast<CallInst>(&inst));
+
+    bool changed = false;
+    for (CallInst *check : checks) {
+      unsigned numArgs = check->getNumArgOperands();
+      Value *roBase =
+          numArgs == 4 ? getAddrPointer(check->getArgOperand(2)) : nullptr;
+      SmallVector<MemoryLocation, 4> locs;
+      bool hoistable = runsOnFirstIteration(check, L);
+      for (unsigned i = 0; hoistable && i < numArgs; i++)
+        hoistable = isHoistable(check->getArgOperand(i), L,
+                                i == 3 ? roBase : nullptr, locs, 0);
+      if (!hoistable)
+        continue;
+
+      Value *mdAddr = getAddrPointer(check->getArgOperand(1));
+      for (BasicBlock *bb : L->blocks())
+        for (Instruction &inst : *bb)
+          if (hoistable && isClobber(&inst, locs, mdAddr))
+            hoistable = false;
+      if (!hoistable)
+        continue;
+
+      Instruction *insertPt = preheader->getTerminator();
+      std::map<Value *, Value *> clones;
+      std::vector<Value *> oldArgs;
+      for (unsigned i = 0; i < numArgs; i++) {
+        oldArgs.push_back(check->getArgOperand(i));
+        check->setArgOperand(
+            i, hoist(check->getArgOperand(i), L, insertPt, clones));
+      }
+      check->moveBefore(insertPt);
+      for (Value *arg : oldArgs)
+        RecursivelyDeleteTriviallyDeadInstructions(arg);
+      NumHoisted++;
+      changed = true;
+    }
+    return changed;
+  }
+
+  bool removeDuplicates(Function &F) {
+    std::map<checkKey, std::vector<CallInst *>> groups;
+    for (BasicBlock &bb : F)
+      for (Instruction &inst : bb)
+        if (isCallTo(&inst, monitors)) {
+          CallInst *check = cast<CallInst>(&inst);
+          if (isa<ConstantInt>(check->getArgOperand(0)))
+            groups[checkKey(check->getCalledFunction(),
+                            check->getArgOperand(0))]
+                .push_back(check);
+        }
+
+    bool changed = false;
+    for (auto &group : groups) {
+      std::vector<CallInst *> &checks = group.second;
+      std::set<CallInst *> removed;
+      for (CallInst *check : checks) {
+        for (CallInst *dom : checks) {
+          if (dom == check || removed.count(dom) ||
+              !DT->dominates(dom, check) || !isRedundant(dom, check))
+            continue;
+          removed.insert(check);
+          break;
+        }
+      }
+      for (CallInst *check : removed) {
+        std::vector<Value *> args(check->arg_begin(), check->arg_end());
+        check->eraseFromParent();
+        for (Value *arg : args)
+          RecursivelyDeleteTriviallyDeadInstructions(arg);
+        NumRemoved++;
+        changed = true;
+      }
+    }
+    return changed;
+  }
+
+public:
+  static char ID;
+  CHECKELIM() : FunctionPass(ID) {}
+
+  virtual inline void getAnalysisUsage(llvm::AnalysisUsage &au) const {
+    au.addRequired<AAResultsWrapperPass>();
+    au.addRequired<DominatorTreeWrapperPass>();
+    au.addRequired<LoopInfoWrapperPass>();
+    au.setPreservesCFG();
+  }
+
+  bool doInitialization(Module &M) override {
+    for (const char *name : monitorNames)
+      if (Function *fn = M.getFunction(name))
+        monitors.insert(fn);
+    for (const char *name : updateNames)
+      if (Function *fn = M.getFunction(name))
+        updates.insert(fn);
+    return false;
+  }
+
+  // [OS-CFI] loop invariant checks are hoisted first, innermost loops
+  // first, so that a hoisted check may dominate a duplicate after the loop
+  bool runOnFunction(Function &F) override {
+    if (monitors.empty() || F.isDeclaration() || monitors.count(&F))
+      return false;
+    DL = &F.getParent()->getDataLayout();
+    AA = &getAnalysis<AAResultsWrapperPass>().getAAResults();
+    DT = &getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+    LoopInfo &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+    localSlots.clear();
+
+    bool changed = false;
+    SmallVector<Loop *, 4> loops = LI.getLoopsInPreorder();
+    for (auto it = loops.rbegin(); it != loops.rend(); ++it)
+      changed |= hoistChecks(*it);
+    changed |= removeDuplicates(F);
+    return changed;
+  }
+
+private:
+  std::set<Function *> monitors;
+  std::set<Function *> updates;
+  const DataLayout *DL = nullptr;
+  AAResults *AA = nullptr;
+  DominatorTree *DT = nullptr;
+  std::map<const Value *, bool> localSlots;
+};
+
+char CHECKELIM::ID = 0;
+static RegisterPass<CHECKELIM>
+    Elim("llvm-check-elim",
+         "Remove dominated duplicate and hoist loop invariant CFI checks");
@@ -1,8 +1,11 @@
+#include "llvm/ADT/Statistic.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/CallPromotionUtils.h"
 #include <llvm/Bitcode/BitcodeReader.h> /// for isBitcode
 #include <llvm/IRReader/IRReader.h>     /// for isIRFile
 
@@ -13,10 +16,23 @@
 
 using namespace llvm;
 
+#define DEBUG_TYPE "llvm-inst-cfg"
+
+STATISTIC(NumSingleTarget, "Number of single target pcall-points");
+STATISTIC(NumDevirt, "Number of single target pcall-points devirtualized");
+
 static cl::opt<std::string> dirPath("DIR_PATH",
                                     cl::desc("give the program path directory"),
                                     cl::value_desc("directory path"));
 
+static cl::opt<bool> symbolicCFG(
+    "symbolic-cfg", cl::init(false),
+    cl::desc("CFG tables hold label ids, emit them as relocations"));
+
+static cl::opt<bool> devirtCFG(
+    "devirt-cfg", cl::init(false),
+    cl::desc("Turn pcall-points allowed a single target into direct calls"));
+
 typedef std::vector<unsigned long> contextList;
 typedef std::vector<unsigned long>::iterator contextListIt;
 typedef std::pair<unsigned long, contextList> ctxToTargetPair;
@@ -26,6 +42,8 @@ typedef std::map<unsigned long, ctxToTargetSet> pointToECMap;
 typedef std::map<unsigned long, ctxToTargetSet>::iterator pointToECMapIt;
 typedef std::map<unsigned long, int> pointToType;
 typedef std::map<unsigned long, int>::iterator pointToTypeIt;
+typedef std::map<unsigned long, Constant *> idToLabelMap;
+typedef std::set<unsigned long> idSet;
 
 typedef enum TARGET_TYPE {
   V_OS = 1,
@@ -62,6 +80,127 @@ private:
     New->setSection(Old->getSection());
   }
 
+  // collect the (tag, label) pairs DDAPass emitted into cfg_label_tracker:
+  // GL_TABLE maps target ids to functions and vtables, every
+  // <function>@labelTracker maps call-site ids to return address labels
+  void collectLabels(Module &M) {
+    for (GlobalVariable &G : M.globals()) {
+      if (G.getSection() != "cfg_label_tracker" || !G.hasInitializer())
+        continue;
+      ConstantArray *arr = dyn_cast<ConstantArray>(G.getInitializer());
+      if (!arr)
+        continue;
+      idToLabelMap &labels = (G.getName() == "GL_TABLE") ? mapIDTarget
+                                                         : mapIDLabel;
+      for (unsigned i = 0; i + 1 < arr->getNumOperands(); i += 2) {
+        ConstantExpr *tag = dyn_cast<ConstantExpr>(arr->getOperand(i));
+        if (!tag || tag->getOpcode() != Instruction::IntToPtr)
+          continue;
+        ConstantInt *id = dyn_cast<ConstantInt>(tag->getOperand(0));
+        if (!id)
+          continue;
+        labels[id->getZExtValue()] =
+            cast<Constant>(arr->getOperand(i + 1)->stripPointerCasts());
+      }
+    }
+  }
+
+  // vtable entries are checked against the loaded vptr, i.e. the address
+  // point right after the RTTI slot
+  Constant *getVTableAddressPoint(GlobalVariable *vt, const DataLayout &DL) {
+    LLVMContext &C = vt->getContext();
+    uint64_t ap = 2;
+    Constant *init = vt->hasInitializer() ? vt->getInitializer() : nullptr;
+    if (init && isa<ConstantStruct>(init))
+      init = init->getAggregateElement(0U);
+    if (init && isa<ConstantArray>(init)) {
+      for (unsigned i = 0; i < init->getNumOperands(); i++) {
+        const Value *slot = init->getOperand(i)->stripPointerCasts();
+        if (slot->getName().startswith("_ZTI")) {
+          ap = i + 1;
+          break;
+        }
+      }
+    }
+    Constant *base = ConstantExpr::getBitCast(vt, Type::getInt8PtrTy(C));
+    Constant *offset = ConstantInt::get(Type::getInt64Ty(C),
+                                        ap * DL.getPointerSize(), false);
+    return ConstantExpr::getInBoundsGetElementPtr(Type::getInt8Ty(C), base,
+                                                  offset);
+  }
+
+  // a numeric table entry (call-point id, origin id, or a final address)
+  Constant *getIDConstant(unsigned long id, PointerType *ty) {
+    Constant *cID = ConstantInt::get(Type::getInt32Ty(ty->getContext()), id,
+                                     false);
+    return ConstantFolder().CreateIntToPtr(cID, ty);
+  }
+
+  // target entry: relocation against the function or vtable symbol
+  Constant *getTargetConstant(unsigned long id, PointerType *ty,
+                              const DataLayout &DL) {
+    if (!symbolicCFG || mapIDTarget.find(id) == mapIDTarget.end())
+      return getIDConstant(id, ty);
+    Constant *target = mapIDTarget[id];
+    if (GlobalVariable *vt = dyn_cast<GlobalVariable>(target))
+      target = getVTableAddressPoint(vt, DL);
+    return ConstantExpr::getBitCast(target, ty);
+  }
+
+  // call-site context entry: relocation against the return address label
+  Constant *getLabelConstant(unsigned long id, PointerType *ty) {
+    if (!symbolicCFG || mapIDLabel.find(id) == mapIDLabel.end())
+      return getIDConstant(id, ty);
+    return ConstantExpr::getBitCast(mapIDLabel[id], ty);
+  }
+
+  // [OS-CFI] the single target a pcall-point is allowed under every EC of
+  // its policy, nullptr if there are more or it is not a function
+  Function *getSingleTarget(unsigned long callID) {
+    pointToECMapIt pIt = mapPEC.find(callID);
+    if (pIt == mapPEC.end() || mapPD[callID] == V_OS || mapPD[callID] == V_CI)
+      return nullptr;
+    unsigned long target = pIt->second.begin()->first;
+    for (ctxToTargetSetIt tIt = pIt->second.begin(); tIt != pIt->second.end();
+         ++tIt) {
+      if (tIt->first != target)
+        return nullptr;
+    }
+    if (mapIDTarget.find(target) == mapIDTarget.end())
+      return nullptr;
+    return dyn_cast<Function>(mapIDTarget[target]);
+  }
+
+  // [OS-CFI] the indirect call the monitor checks is turned into a direct
+  // call to target when the pointer equals it; the monitor is left on the
+  // other path only, where it reports the violation. A call-site labeled as
+  // a CS context keeps its single return address and is left alone
+  bool devirtualize(CallInst *monitor, Function *target) {
+    Value *ptr = monitor->getArgOperand(2);
+    if (PtrToIntInst *cast = dyn_cast<PtrToIntInst>(ptr))
+      ptr = cast->getOperand(0);
+    ptr = ptr->stripPointerCasts();
+
+    Instruction *iCall = nullptr;
+    for (Instruction *inst = monitor->getNextNode(); inst;
+         inst = inst->getNextNode()) {
+      CallSite cs(inst);
+      if (cs && cs.getCalledValue()->stripPointerCasts() == ptr) {
+        iCall = inst;
+        break;
+      }
+    }
+    if (!iCall || iCall->getMetadata("oscfi.cs.label") ||
+        !isLegalToPromote(CallSite(iCall), target))
+      return false;
+
+    MDNode *weights =
+        MDBuilder(iCall->getContext()).createBranchWeights(2000, 1);
+    promoteCallWithIfThenElse(CallSite(iCall), target, weights);
+    monitor->moveBefore(iCall);
+    return true;
+  }
+
 public:
   static char ID;
   INSTCFG() : ModulePass(ID) {
@@ -153,6 +292,30 @@ public:
       }
     }
     initcallfd.close();
+
+    // [OS-CFI] origins (1) and call-points (2) whose pointers never leave
+    // their thread, the kinds of MDPlacement. A file with any other kind or
+    // a malformed line is ignored as a whole, every pointer then keeps its
+    // metadata in the shared store
+    path = dirPath + "/tlMD.bin";
+    initcallfd.open(path.c_str());
+    if (initcallfd.is_open()) {
+      bool valid = true;
+      while (valid && initcallfd >> ty >> p) {
+        if (ty == 1)
+          tlOrigins.insert(p);
+        else if (ty == 2)
+          tlPoints.insert(p);
+        else
+          valid = false;
+      }
+      if (!valid || !initcallfd.eof()) {
+        errs() << "[OS-CFI] " << path << " is malformed, it is ignored\n";
+        tlOrigins.clear();
+        tlPoints.clear();
+      }
+    }
+    initcallfd.close();
   }
 
   virtual inline void getAnalysisUsage(llvm::AnalysisUsage &au) const {
@@ -167,14 +330,15 @@ public:
     std::vector<Constant *> list_P_CI, list_P_CS1, list_P_CS2, list_P_CS3,
         list_P_OS, list_V_CI, list_V_OS;
 
+    const DataLayout &DL = M.getDataLayout();
+    if (symbolicCFG || devirtCFG)
+      collectLabels(M);
+
     for (pointToECMapIt pIt = mapPEC.begin(); pIt != mapPEC.end(); ++pIt) {
-      Constant *cPoint_t = ConstantInt::get(int32Ty, pIt->first, false);
-      Constant *cPoint = ConstantFolder().CreateIntToPtr(cPoint_t, int32PtTy);
+      Constant *cPoint = getIDConstant(pIt->first, int32PtTy);
       for (ctxToTargetSetIt tIt = pIt->second.begin(); tIt != pIt->second.end();
            ++tIt) {
-        Constant *cTarget_t = ConstantInt::get(int32Ty, tIt->first, false);
-        Constant *cTarget =
-            ConstantFolder().CreateIntToPtr(cTarget_t, int32PtTy);
+        Constant *cTarget = getTargetConstant(tIt->first, int32PtTy, DL);
         if (mapPD[pIt->first] == P_CI) {
           list_P_CI.push_back(cPoint);
           list_P_CI.push_back(cTarget);
@@ -186,51 +350,33 @@ public:
           list_P_CS1.push_back(cTarget);
           for (auto cIt = (tIt->second).begin(); cIt != (tIt->second).end();
                ++cIt) {
-            Constant *cContext_t = ConstantInt::get(int32Ty, *cIt, false);
-            Constant *cContext =
-                ConstantFolder().CreateIntToPtr(cContext_t, int32PtTy);
-            list_P_CS1.push_back(cContext);
+            list_P_CS1.push_back(getLabelConstant(*cIt, int32PtTy));
           }
         } else if (mapPD[pIt->first] == P_CS2) {
           list_P_CS2.push_back(cPoint);
           list_P_CS2.push_back(cTarget);
           for (auto cIt = (tIt->second).begin(); cIt != (tIt->second).end();
                ++cIt) {
-            Constant *cContext_t = ConstantInt::get(int32Ty, *cIt, false);
-            Constant *cContext =
-                ConstantFolder().CreateIntToPtr(cContext_t, int32PtTy);
-            list_P_CS2.push_back(cContext);
+            list_P_CS2.push_back(getLabelConstant(*cIt, int32PtTy));
           }
         } else if (mapPD[pIt->first] == P_CS3) {
           list_P_CS3.push_back(cPoint);
           list_P_CS3.push_back(cTarget);
           for (auto cIt = (tIt->second).begin(); cIt != (tIt->second).end();
                ++cIt) {
-            Constant *cContext_t = ConstantInt::get(int32Ty, *cIt, false);
-            Constant *cContext =
-                ConstantFolder().CreateIntToPtr(cContext_t, int32PtTy);
-            list_P_CS3.push_back(cContext);
+            list_P_CS3.push_back(getLabelConstant(*cIt, int32PtTy));
           }
         } else if (mapPD[pIt->first] == P_OS) {
+          // origin id followed by the origin context call-site
           list_P_OS.push_back(cPoint);
           list_P_OS.push_back(cTarget);
-          for (auto cIt = (tIt->second).begin(); cIt != (tIt->second).end();
-               ++cIt) {
-            Constant *cContext_t = ConstantInt::get(int32Ty, *cIt, false);
-            Constant *cContext =
-                ConstantFolder().CreateIntToPtr(cContext_t, int32PtTy);
-            list_P_OS.push_back(cContext);
-          }
+          list_P_OS.push_back(getIDConstant(tIt->second[0], int32PtTy));
+          list_P_OS.push_back(getLabelConstant(tIt->second[1], int32PtTy));
         } else if (mapPD[pIt->first] == V_OS) {
           list_V_OS.push_back(cPoint);
           list_V_OS.push_back(cTarget);
-          for (auto cIt = (tIt->second).begin(); cIt != (tIt->second).end();
-               ++cIt) {
-            Constant *cContext_t = ConstantInt::get(int32Ty, *cIt, false);
-            Constant *cContext =
-                ConstantFolder().CreateIntToPtr(cContext_t, int32PtTy);
-            list_V_OS.push_back(cContext);
-          }
+          list_V_OS.push_back(getIDConstant(tIt->second[0], int32PtTy));
+          list_V_OS.push_back(getLabelConstant(tIt->second[1], int32PtTy));
         }
       }
     }
@@ -380,6 +526,17 @@ public:
     Function *CS_D2_REF = M.getFunction("oscfi_pcall_reference_monitor_d2");
     Function *CS_D3_REF = M.getFunction("oscfi_pcall_reference_monitor_d3");
 
+    // [OS-CFI] per-thread metadata store, used only if the runtime has it
+    Function *U_TL = M.getFunction("update_tl_table");
+    Function *OSCFI_P_CTX_TL_REF =
+        M.getFunction("oscfi_pcall_ctx_tl_reference_monitor");
+    Function *OSCFI_P_TL_REF =
+        M.getFunction("oscfi_pcall_tl_reference_monitor");
+    Function *OSCFI_V_TL_REF =
+        M.getFunction("oscfi_vcall_tl_reference_monitor");
+    bool hasTL = U_TL && OSCFI_P_CTX_TL_REF && OSCFI_P_TL_REF && OSCFI_V_TL_REF;
+
+    std::vector<std::pair<CallInst *, Function *>> devirtList;
     unsigned long callID, originID;
     IntegerType *int64Ty = Type::getInt64Ty(M.getContext());
     for (Function &Fn : M) {
@@ -398,16 +555,22 @@ public:
 
                 if (mapPD.find(callID) != mapPD.end()) {
                   int d = mapPD[callID];
+                  bool tl = hasTL && tlPoints.find(callID) != tlPoints.end();
+                  Function *single =
+                      devirtCFG ? getSingleTarget(callID) : nullptr;
+                  if (single)
+                    devirtList.push_back(std::make_pair(call, single));
                   if (d == P_CI) {
                     call->setCalledFunction(CI_P_REF);
                   } else if (d == V_CI) {
                     call->setCalledFunction(CI_V_REF);
                   } else if (d == P_OS_CTX) {
-                    call->setCalledFunction(OSCFI_P_CTX_REF);
+                    call->setCalledFunction(tl ? OSCFI_P_CTX_TL_REF
+                                               : OSCFI_P_CTX_REF);
                   } else if (d == P_OS) {
-                    call->setCalledFunction(OSCFI_P_REF);
+                    call->setCalledFunction(tl ? OSCFI_P_TL_REF : OSCFI_P_REF);
                   } else if (d == V_OS) {
-                    call->setCalledFunction(OSCFI_V_REF);
+                    call->setCalledFunction(tl ? OSCFI_V_TL_REF : OSCFI_V_REF);
                   } else if (d == P_CS1) {
                     call->setCalledFunction(CS_D1_REF);
                   } else if (d == P_CS2) {
@@ -423,6 +586,8 @@ public:
               if (isa<ConstantInt>(idValue)) {
                 ConstantInt *cint = dyn_cast<ConstantInt>(idValue);
                 originID = cint->getZExtValue();
+                if (hasTL && tlOrigins.find(originID) != tlOrigins.end())
+                  call->setCalledFunction(U_TL);
                 if (find(originList.begin(), originList.end(), originID) ==
                     originList.end()) {
                   Constant *rm_id = ConstantInt::get(int64Ty, 0, false);
@@ -435,6 +600,12 @@ public:
       }
     }
 
+    NumSingleTarget += devirtList.size();
+    for (auto &item : devirtList) {
+      if (devirtualize(item.first, item.second))
+        NumDevirt++;
+    }
+
     return true; // must return true if module is modified
   }
 
@@ -442,6 +613,10 @@ private:
   pointToECMap mapPEC;
   pointToType mapPD;
   contextList originList;
+  idSet tlOrigins; // [OS-CFI] origins updating the per-thread store
+  idSet tlPoints;  // [OS-CFI] call-points reading the per-thread store
+  idToLabelMap mapIDTarget; // [OS-CFI] symbolic mode: target id -> symbol
+  idToLabelMap mapIDLabel;  // [OS-CFI] symbolic mode: call-site id -> label
 };
 
 char INSTCFG::ID = 0;
@@ -1975,6 +1975,10 @@ RValue CodeGenFunction::EmitBuiltinExpr(const FunctionDecl *FD,
                         E->getArg(0)->getExprLoc(), FD, 0);
     EmitNonNullArgCheck(RValue::get(Src.getPointer()), E->getArg(1)->getType(),
                         E->getArg(1)->getExprLoc(), FD, 1);
+    // [OS-CFI] the copy of a code pointer takes its origin metadata along
+    if (pointsToCodePointer(E->getArg(0)) || pointsToCodePointer(E->getArg(1)))
+      return RValue::get(EmitOSCFIMemCall(
+          "oscfi_memcpy", {Dest.getPointer(), Src.getPointer(), SizeVal}));
     Builder.CreateMemCpy(Dest, Src, SizeVal, false);
     return RValue::get(Dest.getPointer());
   }
@@ -2031,9 +2035,28 @@ RValue CodeGenFunction::EmitBuiltinExpr(const FunctionDecl *FD,
                         E->getArg(0)->getExprLoc(), FD, 0);
     EmitNonNullArgCheck(RValue::get(Src.getPointer()), E->getArg(1)->getType(),
                         E->getArg(1)->getExprLoc(), FD, 1);
+    // [OS-CFI] the copy of a code pointer takes its origin metadata along
+    if (pointsToCodePointer(E->getArg(0)) || pointsToCodePointer(E->getArg(1)))
+      return RValue::get(EmitOSCFIMemCall(
+          "oscfi_memmove", {Dest.getPointer(), Src.getPointer(), SizeVal}));
     Builder.CreateMemMove(Dest, Src, SizeVal, false);
     return RValue::get(Dest.getPointer());
   }
+  case Builtin::BIrealloc:
+    // [OS-CFI] a moved block takes the origin metadata of its code pointers
+    if (!pointsToCodePointer(E->getArg(0)))
+      break;
+    return RValue::get(EmitOSCFIMemCall(
+        "oscfi_realloc",
+        {EmitScalarExpr(E->getArg(0)), EmitScalarExpr(E->getArg(1))}));
+  case Builtin::BIfree:
+    // [OS-CFI] the metadata of the code pointers of a large block is dropped
+    // before the block can be handed out again
+    if (!pointsToCodePointer(E->getArg(0)))
+      break;
+    EmitOSCFIMemCall("oscfi_free", {EmitScalarExpr(E->getArg(0))},
+                     CGM.VoidTy);
+    return RValue::get(nullptr);
   case Builtin::BImemset:
   case Builtin::BI__builtin_memset: {
     Address Dest = EmitPointerWithAlignment(E->getArg(0));
@@ -3648,6 +3648,54 @@ CodeGenFunction::EmitNounwindRuntimeCall(llvm::Value *callee,
   return call;
 }
 
+/// [OS-CFI] Emits a call to an OS-CFI runtime function taking 64-bit words.
+/// The monitors and metadata updates are preserve_most, so the caller does
+/// not spill around a check. They are never inlined nor tail called, INSTCFG
+/// retargets the calls and the call-site sensitive monitors read the return
+/// address of their caller. No memory attribute is given: the runtime is
+/// LTO-linked into the module and reads and writes program memory.
+llvm::CallInst *
+CodeGenFunction::EmitOSCFIRuntimeCall(StringRef name,
+                                      ArrayRef<llvm::Value *> args) {
+  SmallVector<llvm::Type *, 4> argTys(args.size(), CGM.Int64Ty);
+  llvm::FunctionType *fnTy =
+      llvm::FunctionType::get(CGM.VoidTy, argTys, /*isVarArg=*/false);
+  llvm::AttributeList attrs = llvm::AttributeList::get(
+      getLLVMContext(), llvm::AttributeList::FunctionIndex,
+      {llvm::Attribute::NoUnwind, llvm::Attribute::NoInline});
+  llvm::Constant *fn = CGM.CreateRuntimeFunction(fnTy, name, attrs);
+  if (auto *F = dyn_cast<llvm::Function>(fn))
+    if (F->empty())
+      F->setCallingConv(llvm::CallingConv::PreserveMost);
+
+  llvm::CallInst *call = Builder.CreateCall(fn, args);
+  call->setCallingConv(llvm::CallingConv::PreserveMost);
+  call->setAttributes(attrs);
+  call->setTailCallKind(llvm::CallInst::TCK_NoTail);
+  return call;
+}
+
+/// [OS-CFI] Emits a call to an OS-CFI wrapper of a libc memory function,
+/// which moves the metadata of the copied code pointers along with the data.
+/// The wrappers follow the C convention and return what libc returns, a
+/// void * unless retTy is given.
+llvm::Value *CodeGenFunction::EmitOSCFIMemCall(StringRef name,
+                                               ArrayRef<llvm::Value *> args,
+                                               llvm::Type *retTy) {
+  SmallVector<llvm::Value *, 3> castArgs;
+  SmallVector<llvm::Type *, 3> argTys;
+  for (llvm::Value *arg : args) {
+    if (arg->getType()->isPointerTy())
+      arg = Builder.CreateBitCast(arg, CGM.Int8PtrTy);
+    castArgs.push_back(arg);
+    argTys.push_back(arg->getType());
+  }
+  llvm::FunctionType *fnTy = llvm::FunctionType::get(
+      retTy ? retTy : CGM.Int8PtrTy, argTys, /*isVarArg=*/false);
+  llvm::Constant *fn = CGM.CreateRuntimeFunction(fnTy, name);
+  return EmitNounwindRuntimeCall(fn, castArgs);
+}
+
 /// Emits a simple call (never an invoke) to the given no-arguments
 /// runtime function.
 llvm::CallInst *CodeGenFunction::EmitRuntimeCall(llvm::Value *callee,
@@ -4305,15 +4353,9 @@ RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
         llvm::Value *calleePtrVal =
             Builder.CreatePtrToInt(CalleePtr, CGM.Int64Ty);
 
-        // prepare to call reference monitor
-        llvm::FunctionType *preftype = llvm::FunctionType::get(
-            CGM.VoidTy, {CGM.Int64Ty, CGM.Int64Ty, CGM.Int64Ty}, false);
-        llvm::Constant *rf =
-            CGM.CreateRuntimeFunction(preftype, "pcall_reference_monitor");
-
-        llvm::CallInst *rfcall = Builder.CreateCall(
-            rf, {id_value_64, calleePtrAddrVal, calleePtrVal});
-        rfcall->setTailCallKind(llvm::CallInst::TailCallKind::TCK_NoTail);
+        // call reference monitor
+        EmitOSCFIRuntimeCall("pcall_reference_monitor",
+                             {id_value_64, calleePtrAddrVal, calleePtrVal});
         if (!InvokeDest) {
           CS = Builder.CreateCall(CalleePtr, IRCallArgs, BundleList);
         } else {
@@ -4398,15 +4440,9 @@ RValue CodeGenFunction::EmitCall(const CGFunctionInfo &CallInfo,
         llvm::Value *calleePtrVal =
             Builder.CreatePtrToInt(CalleePtr, CGM.Int64Ty);
 
-        // prepare to call reference monitor
-        llvm::FunctionType *preftype = llvm::FunctionType::get(
-            CGM.VoidTy, {CGM.Int64Ty, CGM.Int64Ty, CGM.Int64Ty}, false);
-        llvm::Constant *rf =
-            CGM.CreateRuntimeFunction(preftype, "pcall_reference_monitor");
-
-        llvm::CallInst *rfcall = Builder.CreateCall(
-            rf, {id_value_64, phiCalleePtrAddrVal, calleePtrVal});
-        rfcall->setTailCallKind(llvm::CallInst::TailCallKind::TCK_NoTail);
+        // call reference monitor
+        EmitOSCFIRuntimeCall("pcall_reference_monitor",
+                             {id_value_64, phiCalleePtrAddrVal, calleePtrVal});
         if (!InvokeDest) {
           CS = Builder.CreateCall(CalleePtr, IRCallArgs, BundleList);
         } else {
@@ -2449,14 +2449,8 @@ void CodeGenFunction::entryObjOrigin(Address thisPtr, llvm::Value *vTable) {
         Builder.CreateBitCast(thisPtr.getPointer(), CGM.VoidPtrTy);
     llvm::Value *thisPtrAddrVal = Builder.CreatePtrToInt(thisPtrAddr, CGM.Int64Ty);
 
-    llvm::FunctionType *uptype = llvm::FunctionType::get(
-        CGM.VoidTy, {CGM.Int64Ty, CGM.Int64Ty, CGM.Int64Ty, CGM.Int64Ty},
-        false);
-    llvm::Constant *up = CGM.CreateRuntimeFunction(uptype, "update_mpx_table");
-
-    llvm::CallInst *upcall = Builder.CreateCall(
-        up, {thisPtrAddrVal, vTableAddr, objOrigin_64, objOrigin_64});
-    upcall->setTailCallKind(llvm::CallInst::TailCallKind::TCK_NoTail);
+    EmitOSCFIRuntimeCall("update_mpx_table", {thisPtrAddrVal, vTableAddr,
+                                              objOrigin_64, objOrigin_64});
 
     // inactive path will avoid the update to mpx table
     EmitBlock(inactivePath);
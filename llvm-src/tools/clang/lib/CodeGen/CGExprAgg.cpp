@@ -1914,6 +1914,15 @@ void CodeGenFunction::EmitAggregateCopy(LValue Dest, LValue Src, QualType Ty,
     }
   }
 
+  // [OS-CFI] the copy of a code pointer takes its origin metadata along. The
+  // runtime copies with plain accesses, so a volatile copy stays a volatile
+  // memcpy and its pointers are left without metadata
+  if (!isVolatile && containsCodePointer(Ty)) {
+    EmitOSCFIMemCall("oscfi_memcpy",
+                     {DestPtr.getPointer(), SrcPtr.getPointer(), SizeVal});
+    return;
+  }
+
   auto Inst = Builder.CreateMemCpy(DestPtr, SrcPtr, SizeVal, isVolatile);
 
   // Determine the metadata to describe the position of any padding in this
@@ -25,6 +25,10 @@
 using namespace clang;
 using namespace CodeGen;
 
+/// [OS-CFI] SHADOW_RECLAIM_SIZE of the runtime, the smallest freed block whose
+/// metadata is dropped
+static const int64_t OSCFIReclaimSize = 16384;
+
 namespace {
 struct MemberCallInfo {
   RequiredArgs ReqArgs;
@@ -1813,6 +1817,24 @@ void CodeGenFunction::EmitDeleteCall(const FunctionDecl *DeleteFD,
   assert(ParamTypeIt == DeleteFTy->param_type_end() &&
          "unknown parameter to usual delete function");
 
+  // [OS-CFI] Drop the metadata of the code pointers of the deleted memory,
+  // the runtime only does so for large blocks, so a single object smaller
+  // than that is left alone here.
+  if (containsCodePointer(DeleteTy)) {
+    CharUnits DeleteTypeSize = getContext().getTypeSizeInChars(DeleteTy);
+    if (NumElements || DeleteTypeSize.getQuantity() >= OSCFIReclaimSize) {
+      llvm::Value *Size =
+          llvm::ConstantInt::get(SizeTy, DeleteTypeSize.getQuantity());
+      if (NumElements)
+        Size = Builder.CreateMul(
+            Size, Builder.CreateZExtOrTrunc(NumElements, SizeTy));
+      if (!CookieSize.isZero())
+        Size = Builder.CreateAdd(
+            Size, llvm::ConstantInt::get(SizeTy, CookieSize.getQuantity()));
+      EmitOSCFIMemCall("oscfi_reclaim", {Ptr, Size}, CGM.VoidTy);
+    }
+  }
+
   // Emit the call to delete.
   EmitNewDeleteCall(*this, DeleteFD, DeleteFTy, DeleteArgs);
 }
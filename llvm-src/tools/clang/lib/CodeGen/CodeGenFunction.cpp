@@ -180,13 +180,8 @@ llvm::StoreInst *CodeGenFunction::EmitStoreToMetadata(llvm::Value *Val,
 
     // active will update mpx table
     EmitBlock(activePath);
-    llvm::FunctionType *uptype = llvm::FunctionType::get(
-        CGM.VoidTy, {CGM.Int64Ty, CGM.Int64Ty, CGM.Int64Ty, CGM.Int64Ty},
-        false);
-    llvm::Constant *up = CGM.CreateRuntimeFunction(uptype, "update_mpx_table");
-    llvm::CallInst *upcall =
-        Builder.CreateCall(up, {ptrAddrVal, ptrValue, p_origin_64, ctx_val_64});
-    upcall->setTailCallKind(llvm::CallInst::TailCallKind::TCK_NoTail);
+    EmitOSCFIRuntimeCall("update_mpx_table",
+                         {ptrAddrVal, ptrValue, p_origin_64, ctx_val_64});
 
     // inactive path will avoid the update to mpx table
     EmitBlock(inactivePath);
@@ -195,6 +190,42 @@ llvm::StoreInst *CodeGenFunction::EmitStoreToMetadata(llvm::Value *Val,
   return Store;
 }
 
+/// [OS-CFI] Whether an object of the type holds a function pointer, a member
+/// function pointer or a vtable pointer, whose metadata has to follow a copy
+/// of the object.
+bool CodeGenFunction::containsCodePointer(QualType Ty) {
+  Ty = getContext().getBaseElementType(Ty);
+  if (Ty->isFunctionPointerType() || Ty->isMemberFunctionPointerType())
+    return true;
+
+  const RecordType *RT = Ty->getAs<RecordType>();
+  if (!RT)
+    return false;
+  const RecordDecl *RD = RT->getDecl()->getDefinition();
+  if (!RD)
+    return false;
+  if (const auto *CXXRD = dyn_cast<CXXRecordDecl>(RD)) {
+    if (CXXRD->isDynamicClass())
+      return true;
+    for (const auto &Base : CXXRD->bases())
+      if (containsCodePointer(Base.getType()))
+        return true;
+  }
+  for (const auto *Field : RD->fields())
+    if (containsCodePointer(Field->getType()))
+      return true;
+  return false;
+}
+
+/// [OS-CFI] Same for the object a pointer argument of a libc call points to,
+/// the type is the one before the conversion to void *.
+bool CodeGenFunction::pointsToCodePointer(const Expr *E) {
+  QualType Ty = E->IgnoreParenImpCasts()->getType();
+  if (const PointerType *PT = Ty->getAs<PointerType>())
+    return containsCodePointer(PT->getPointeeType());
+  return Ty->isArrayType() && containsCodePointer(Ty);
+}
+
 CharUnits CodeGenFunction::getNaturalPointeeTypeAlignment(
     QualType T, LValueBaseInfo *BaseInfo, TBAAAccessInfo *TBAAInfo) {
   return getNaturalTypeAlignment(T->getPointeeType(), BaseInfo, TBAAInfo,
@@ -1583,6 +1583,8 @@ public:
   ~CodeGenFunction();
   llvm::StoreInst *EmitStoreToMetadata(llvm::Value *Val, Address Addr,
                                        bool IsVolatile = false);
+  bool containsCodePointer(QualType Ty);
+  bool pointsToCodePointer(const Expr *E);
 
   CodeGenTypes &getTypes() const { return CGM.getTypes(); }
   ASTContext &getContext() const { return CGM.getContext(); }
@@ -3555,6 +3557,10 @@ public:
   llvm::CallInst *EmitNounwindRuntimeCall(llvm::Value *callee,
                                           ArrayRef<llvm::Value *> args,
                                           const Twine &name = "");
+  llvm::CallInst *EmitOSCFIRuntimeCall(StringRef name,
+                                       ArrayRef<llvm::Value *> args);
+  llvm::Value *EmitOSCFIMemCall(StringRef name, ArrayRef<llvm::Value *> args,
+                                llvm::Type *retTy = nullptr);
 
   SmallVector<llvm::OperandBundleDef, 1>
   getBundlesForFunclet(llvm::Value *Callee);
@@ -1853,16 +1853,10 @@ CGCallee ItaniumCXXABI::getVirtualFunctionPointer(CodeGenFunction &CGF,
     llvm::Value *calleePtrValInt =
         CGF.Builder.CreatePtrToInt(calleePtrVal, CGM.Int64Ty);
 
-    // prepare to call reference monitor
-    llvm::FunctionType *vreftype = llvm::FunctionType::get(
-        CGM.VoidTy, {CGM.Int64Ty, CGM.Int64Ty, CGM.Int64Ty, CGM.Int64Ty},
-        false);
-    llvm::Constant *rf =
-        CGM.CreateRuntimeFunction(vreftype, "vcall_reference_monitor");
-
-    llvm::CallInst *rfcall = CGF.Builder.CreateCall(
-        rf, {id_value_64, thisPtrAddrVal, vTableAddr, calleePtrValInt});
-    rfcall->setTailCallKind(llvm::CallInst::TailCallKind::TCK_NoTail);
+    // call reference monitor
+    CGF.EmitOSCFIRuntimeCall(
+        "vcall_reference_monitor",
+        {id_value_64, thisPtrAddrVal, vTableAddr, calleePtrValInt});
     /*
      * OS-CFI clang codegen modification to instrument reference monitor for
      * virtual function indirect call
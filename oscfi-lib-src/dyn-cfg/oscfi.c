@@ -8,15 +8,19 @@
  */
 
 #include "mpxrt.h"
+#include <malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 
 // will be used for statistical purpose
-unsigned long stats[10] = {0};
-char *stats_name[10] = {
+unsigned long stats[12] = {0};
+char *stats_name[12] = {
     "update_mpx: ",      "get_entry: ",      "oscfi_vcall: ",   "oscfi_pcall: ",
     "oscfi_pcall_0: ",   "oscfi_pcall_1: ",  "oscfi_pcall_2: ", "oscfi_pcall_3",
-    "oscfi_pcall_fix: ", "oscfi_vcall_fix: "};
+    "oscfi_pcall_fix: ", "oscfi_vcall_fix: ", "shadow_copy: ",
+    "shadow_reclaim: "};
 
 // the fixer for SUPA, a address-taken type check CFG
 // Format: ref_id, target
@@ -59,7 +63,7 @@ pcallItem *PCALL_HASH_TABLE[HASH_KEY_RANGE] = {NULL};
 staticItem *STATIC_HASH_TABLE[HASH_KEY_RANGE] = {NULL};
 
 // update mpx table
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 update_mpx_table(unsigned long ptr_addr, unsigned long ptr_val,
                  unsigned long origin, unsigned long originCtx) {
   __asm__ __volatile__("bndmk (%0,%1), %%bnd0;\
@@ -89,6 +93,191 @@ get_entry_mpx_table(unsigned long ptr_addr, unsigned long ptr_val) {
   return entry;
 }
 
+// move the metadata of a pointer stored at from to the same pointer stored at
+// to, a slot without metadata reads the INIT bounds which are not stored
+static inline __attribute__((always_inline)) void
+shadow_move(unsigned long to, unsigned long from, unsigned long val) {
+  unsigned long bnds[2];
+  __asm__ __volatile__("bndldx (%1,%2), %%bnd0;\
+      bndmov %%bnd0, %0;"
+                       : "=m"(bnds)
+                       : "r"(from), "r"(val)
+                       : "%bnd0");
+  if ((bnds[0] | bnds[1]) == 0)
+    return;
+  __asm__ __volatile__("bndmov %0, %%bnd0;\
+      bndstx %%bnd0, (%1,%2);"
+                       :
+                       : "m"(bnds), "r"(to), "r"(val)
+                       : "%bnd0");
+}
+
+// copy the metadata of the pointers in [src, src + n) to the same offsets
+// from dst, reading the pointer values at the same offsets from data. Only
+// the 8-byte aligned slots of src can hold a pointer, a null slot has no
+// metadata, and overlapping slots are walked in the direction memmove copies
+static void shadow_copy(unsigned long dst, unsigned long src, unsigned long n,
+                        unsigned long data) {
+  unsigned long first = (src + 7) & ~7UL;
+  unsigned long delta = dst - src;
+  unsigned long count, i;
+
+  if (dst == src || src + n < first + 8)
+    return;
+  count = (src + n - first) / 8;
+  for (i = 0; i < count; i++) {
+    unsigned long slot = first + 8 * (dst < src ? i : count - 1 - i);
+    unsigned long val = *(unsigned long *)(slot - src + data);
+    if (val == 0)
+      continue;
+    shadow_move(slot + delta, slot, val);
+  }
+  stats[10]++;
+}
+
+// memcpy keeping the metadata of the copied pointers
+void *__attribute__((__used__))
+oscfi_memcpy(void *dst, const void *src, unsigned long n) {
+  shadow_copy((unsigned long)dst, (unsigned long)src, n, (unsigned long)src);
+  return memcpy(dst, src, n);
+}
+
+// memmove keeping the metadata of the moved pointers, the metadata goes first
+// while the source still holds the pointers
+void *__attribute__((__used__))
+oscfi_memmove(void *dst, const void *src, unsigned long n) {
+  shadow_copy((unsigned long)dst, (unsigned long)src, n, (unsigned long)src);
+  return memmove(dst, src, n);
+}
+
+// a bound table entry per 8-byte slot of the memory a directory entry covers
+#define BT_ENTRY_SIZE (4 * sizeof(void *))
+#define BT_SIZE ((1UL << NUM_L2_BITS) * BT_ENTRY_SIZE)
+#define BT_COVER_BITS (NUM_L2_BITS + NUM_IGN_BITS)
+#define SHADOW_PAGE_SIZE 4096UL
+
+// drop the bound table entries of the slots in [start, end), the table pages
+// fully covered are given back to the kernel and read as zero again
+static void shadow_reclaim(unsigned long start, unsigned long end) {
+  unsigned long *bd = get_bd();
+  unsigned long slot = (1UL << NUM_IGN_BITS) - 1;
+  unsigned long addr = (start + slot) & ~slot;
+
+  if (bd == NULL)
+    return;
+  end &= ~slot;
+  while (addr < end) {
+    unsigned long next = ((addr >> BT_COVER_BITS) + 1) << BT_COVER_BITS;
+    unsigned long bde =
+        bd[(addr >> BT_COVER_BITS) & ((1UL << NUM_L1_BITS) - 1)];
+    if (next > end)
+      next = end;
+    if (bde & MPX_L2_VALID_MASK) {
+      unsigned long lo = (bde & MPX_L2_ADDR_MASK) +
+                         ((addr >> NUM_IGN_BITS) & ((1UL << NUM_L2_BITS) - 1)) *
+                             BT_ENTRY_SIZE;
+      unsigned long hi = lo + ((next - addr) >> NUM_IGN_BITS) * BT_ENTRY_SIZE;
+      unsigned long plo = (lo + SHADOW_PAGE_SIZE - 1) & ~(SHADOW_PAGE_SIZE - 1);
+      unsigned long phi = hi & ~(SHADOW_PAGE_SIZE - 1);
+      if (plo < phi) {
+        memset((void *)lo, 0, plo - lo);
+        if (madvise((void *)plo, phi - plo, MADV_DONTNEED) != 0)
+          memset((void *)plo, 0, phi - plo);
+        memset((void *)phi, 0, hi - phi);
+      } else {
+        memset((void *)lo, 0, hi - lo);
+      }
+    }
+    addr = next;
+  }
+}
+
+// drop the metadata of [ptr, ptr + size) of a block about to be freed, only
+// blocks of at least SHADOW_RECLAIM_SIZE are worth it. The compiler calls it
+// before operator delete of an object holding code pointers
+void __attribute__((__used__)) oscfi_reclaim(void *ptr, unsigned long size) {
+  unsigned long start = (unsigned long)ptr;
+  if (ptr == NULL || size < SHADOW_RECLAIM_SIZE)
+    return;
+  shadow_reclaim(start, start + size);
+  stats[11]++;
+}
+
+// free of a block holding code pointers, the compiler calls it instead of free
+void __attribute__((__used__)) oscfi_free(void *ptr) {
+  if (ptr != NULL)
+    oscfi_reclaim(ptr, malloc_usable_size(ptr));
+  free(ptr);
+}
+
+// realloc keeping the metadata of the pointers of a moved block. A large
+// block that grows is moved here, so its metadata is dropped before the old
+// block is freed, and a large block that shrinks drops that of its tail.
+// Otherwise the old block is freed by realloc and the pointers are read from
+// the new one
+void *__attribute__((__used__)) oscfi_realloc(void *ptr, unsigned long size) {
+  unsigned long from = (unsigned long)ptr;
+  unsigned long old = ptr ? malloc_usable_size(ptr) : 0;
+  void *res;
+  if (old >= SHADOW_RECLAIM_SIZE && size > old) {
+    res = malloc(size);
+    if (res != NULL) {
+      shadow_copy((unsigned long)res, from, old, from);
+      memcpy(res, ptr, old);
+      oscfi_free(ptr);
+    }
+    return res;
+  }
+  if (old >= SHADOW_RECLAIM_SIZE)
+    oscfi_reclaim((char *)ptr + size, old - size);
+  res = realloc(ptr, size);
+  if (res != NULL && (unsigned long)res != from && old != 0)
+    shadow_copy((unsigned long)res, from, old < size ? old : size,
+                (unsigned long)res);
+  return res;
+}
+
+static unsigned long resident_size(unsigned long addr, unsigned long len,
+                                   unsigned char *vec) {
+  unsigned long i, rss = 0;
+  if (mincore((void *)addr, len, vec) != 0)
+    return 0;
+  for (i = 0; i < len / SHADOW_PAGE_SIZE; i++) {
+    if (vec[i] & 1)
+      rss += SHADOW_PAGE_SIZE;
+  }
+  return rss;
+}
+
+// resident bytes of the bound directory and tables
+unsigned long __attribute__((__used__)) oscfi_metadata_rss() {
+  unsigned long *bd = get_bd();
+  unsigned long per_page = SHADOW_PAGE_SIZE / sizeof(unsigned long);
+  unsigned long rss = 0;
+  unsigned char *bd_vec, *bt_vec;
+  unsigned long i, j;
+
+  if (bd == NULL)
+    return rss;
+  bd_vec = malloc(MPX_L1_SIZE / SHADOW_PAGE_SIZE);
+  bt_vec = malloc(BT_SIZE / SHADOW_PAGE_SIZE);
+  if (bd_vec != NULL && bt_vec != NULL &&
+      mincore(bd, MPX_L1_SIZE, bd_vec) == 0) {
+    for (i = 0; i < MPX_L1_SIZE / SHADOW_PAGE_SIZE; i++) {
+      if (!(bd_vec[i] & 1))
+        continue;
+      rss += SHADOW_PAGE_SIZE;
+      for (j = i * per_page; j < (i + 1) * per_page; j++) {
+        if (bd[j] & MPX_L2_VALID_MASK)
+          rss += resident_size(bd[j] & MPX_L2_ADDR_MASK, BT_SIZE, bt_vec);
+      }
+    }
+  }
+  free(bd_vec);
+  free(bt_vec);
+  return rss;
+}
+
 // add new oscfiItem in the OSCFI_HASH_TABLE
 void __attribute__((__used__))
 oscfi_hash_insert(unsigned long ref_id, unsigned long target,
@@ -233,7 +422,7 @@ dyn_pcall_monitor(unsigned long ref_id, unsigned long ptr_val,
                   unsigned long site1, unsigned long site2,
                   unsigned long site3) {}
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
                         unsigned long ptr_val) {
   mEntry entry = get_entry_mpx_table(ptr_addr, ptr_val);
@@ -243,14 +432,14 @@ pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
   dyn_oscfi_monitor(ref_id, ptr_val, entry.origin, entry.originCtx);
   dyn_pcall_monitor(ref_id, ptr_val, site1, site2, site3);
 }
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
                         unsigned long vtable_addr, unsigned long vtarget) {
   mEntry entry = get_entry_mpx_table(vptr_addr, vtable_addr);
   dyn_oscfi_monitor(ref_id, vtable_addr, entry.origin, entry.originCtx);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
                               unsigned long vtable_addr, unsigned long target) {
   mEntry entry = get_entry_mpx_table(vptr_addr, vtable_addr);
@@ -280,7 +469,7 @@ oscfi_vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
           ref_id, target);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
                               unsigned long ptr_val) {
   mEntry entry = get_entry_mpx_table(ptr_addr, ptr_val);
@@ -310,7 +499,7 @@ oscfi_pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
           ref_id, ptr_val);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor_d0(unsigned long ref_id, unsigned long ptr_addr,
                                  unsigned long ptr_val) {
   unsigned long long hash_key = ((ref_id ^ ptr_val) % HASH_KEY_RANGE);
@@ -334,7 +523,7 @@ oscfi_pcall_reference_monitor_d0(unsigned long ref_id, unsigned long ptr_addr,
           ref_id, ptr_val);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor_d1(unsigned long ref_id, unsigned long ptr_addr,
                                  unsigned long ptr_val) {
   unsigned long long site1 = (unsigned long long)__builtin_return_address(1);
@@ -359,7 +548,7 @@ oscfi_pcall_reference_monitor_d1(unsigned long ref_id, unsigned long ptr_addr,
           ref_id, ptr_val);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor_d2(unsigned long ref_id, unsigned long ptr_addr,
                                  unsigned long ptr_val) {
   unsigned long long site1 = (unsigned long long)__builtin_return_address(1);
@@ -387,7 +576,7 @@ oscfi_pcall_reference_monitor_d2(unsigned long ref_id, unsigned long ptr_addr,
           ref_id, ptr_val);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor_d3(unsigned long ref_id, unsigned long ptr_addr,
                                  unsigned long ptr_val) {
   unsigned long long site1 = (unsigned long long)__builtin_return_address(1);
@@ -416,7 +605,7 @@ oscfi_pcall_reference_monitor_d3(unsigned long ref_id, unsigned long ptr_addr,
           ref_id, ptr_val);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 static_pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
                                unsigned long ptr_val) {
   unsigned long hash_key = (ref_id ^ ptr_val) % HASH_KEY_RANGE;
@@ -436,7 +625,7 @@ static_pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
           ref_id, ptr_val);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 static_vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
                                unsigned long vtable_addr,
                                unsigned long target) {
@@ -505,9 +694,10 @@ void __attribute__((__used__)) oscfi_end() {
   fprintf(
       stderr,
       "-----------------------------------------------------------------\n");
-  for (i = 0; i < 10; i++) {
+  for (i = 0; i < 12; i++) {
     fprintf(stderr, "%-20s%20lu\n", stats_name[i], stats[i]);
   }
+  fprintf(stderr, "%-20s%20lu\n", "metadata_rss: ", oscfi_metadata_rss());
   fprintf(
       stderr,
       "-----------------------------------------------------------------\n");
@@ -8,6 +8,17 @@
  */
 
 #define HASH_KEY_RANGE 1000000
+// smallest freed block whose metadata is dropped, a page of bound table
+// covers 1KB of memory. OSCFIReclaimSize of clang's CodeGen is the same
+#define SHADOW_RECLAIM_SIZE 16384
+
+// calling convention of every runtime entry point instrumented code calls,
+// the caller keeps its registers live across the check
+#if defined(__clang__)
+#define OSCFI_CC __attribute__((preserve_most))
+#else
+#define OSCFI_CC
+#endif
 
 // hash table for SUPA failure call-points
 // build from STATIC_TABLE
@@ -43,42 +54,58 @@ typedef struct MPX_ENTRY {
 } mEntry;
 
 // (pointer_addr, pointer_val, origin, origin_ctx)
-void update_mpx_table(unsigned long, unsigned long, unsigned long,
-                      unsigned long);
+void OSCFI_CC update_mpx_table(unsigned long, unsigned long, unsigned long,
+                               unsigned long);
 // (pointer_addr, pointer_val)
 mEntry get_entry_mpx_table(unsigned long, unsigned long);
 
+// libc memory functions also moving the metadata of the copied pointers
+// (dst, src, size)
+void *oscfi_memcpy(void *, const void *, unsigned long);
+// (dst, src, size)
+void *oscfi_memmove(void *, const void *, unsigned long);
+// (ptr, size)
+void *oscfi_realloc(void *, unsigned long);
+// (ptr), free dropping the metadata of a large block
+void oscfi_free(void *);
+// (ptr, size), drop the metadata of a large block before it is freed
+void oscfi_reclaim(void *, unsigned long);
+// resident bytes of the metadata
+unsigned long oscfi_metadata_rss();
+
 // (ref_id, pointer_addr, pointer_val)
-void pcall_reference_monitor(unsigned long, unsigned long, unsigned long);
+void OSCFI_CC pcall_reference_monitor(unsigned long, unsigned long,
+                                      unsigned long);
 // (ref_id, vptr_addr, vtable_addr, vtarget)
-void vcall_reference_monitor(unsigned long, unsigned long, unsigned long,
-                             unsigned long);
+void OSCFI_CC vcall_reference_monitor(unsigned long, unsigned long,
+                                      unsigned long, unsigned long);
 
 // (ref_id, pointer_addr, pointer_val)
-void oscfi_pcall_reference_monitor(unsigned long, unsigned long, unsigned long);
+void OSCFI_CC oscfi_pcall_reference_monitor(unsigned long, unsigned long,
+                                            unsigned long);
 // (ref_id, pointer_addr, pointer_val)
-void oscfi_pcall_reference_monitor_d0(unsigned long, unsigned long,
-                                      unsigned long);
+void OSCFI_CC oscfi_pcall_reference_monitor_d0(unsigned long, unsigned long,
+                                               unsigned long);
 // (ref_id, pointer_addr, pointer_val)
-void oscfi_pcall_reference_monitor_d1(unsigned long, unsigned long,
-                                      unsigned long);
+void OSCFI_CC oscfi_pcall_reference_monitor_d1(unsigned long, unsigned long,
+                                               unsigned long);
 // (ref_id, pointer_addr, pointer_val)
-void oscfi_pcall_reference_monitor_d2(unsigned long, unsigned long,
-                                      unsigned long);
+void OSCFI_CC oscfi_pcall_reference_monitor_d2(unsigned long, unsigned long,
+                                               unsigned long);
 // (ref_id, pointer_addr, pointer_val)
-void oscfi_pcall_reference_monitor_d3(unsigned long, unsigned long,
-                                      unsigned long);
+void OSCFI_CC oscfi_pcall_reference_monitor_d3(unsigned long, unsigned long,
+                                               unsigned long);
 
 // (ref_id, vptr_addr, vtable_addr, vtarget)
-void oscfi_vcall_reference_monitor(unsigned long, unsigned long, unsigned long,
-                                   unsigned long);
+void OSCFI_CC oscfi_vcall_reference_monitor(unsigned long, unsigned long,
+                                            unsigned long, unsigned long);
 
 // (ref_id, pointer_addr, pointer_val)
-void static_pcall_reference_monitor(unsigned long, unsigned long,
-                                    unsigned long);
+void OSCFI_CC static_pcall_reference_monitor(unsigned long, unsigned long,
+                                             unsigned long);
 // (ref_id, vptr_addr, vtable_addr, vtarget)
-void static_vcall_reference_monitor(unsigned long, unsigned long, unsigned long,
-                                    unsigned long);
+void OSCFI_CC static_vcall_reference_monitor(unsigned long, unsigned long,
+                                             unsigned long, unsigned long);
 
 void oscfi_init();
 void oscfi_end();
\ No newline at end of file
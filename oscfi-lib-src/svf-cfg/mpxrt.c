@@ -392,6 +392,7 @@ static bool process_specific_finish(void) {
   }
 
   munmap(l1base, MPX_L1_SIZE);
+  l1base = NULL;
 
   return true;
 }
@@ -8,16 +8,22 @@
  */
 
 #include "mpxrt.h"
+#include <malloc.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 
 // will be used for statistical purpose
-unsigned long stats[12] = {0};
-char *stats_name[12] = {
+unsigned long stats[16] = {0};
+char *stats_name[16] = {
     "update_mpx: ",      "get_entry: ",     "oscfi_vcall: ",
     "oscfi_pcall: ",     "oscfi_pcall_0: ", "oscfi_pcall_1: ",
     "oscfi_pcall_2: ",   "oscfi_pcall_3",   "oscfi_pcall_fix: ",
-    "oscfi_vcall_fix: ", "ref_pcall",       "ref_vcall"};
+    "oscfi_vcall_fix: ", "ref_pcall",       "ref_vcall",
+    "update_tl: ",       "get_entry_tl: ",  "shadow_copy: ",
+    "shadow_reclaim: "};
 
 // the fixer for SUPA, a address-taken type check CFG
 // Format: ref_id, target
@@ -59,8 +65,16 @@ pcallItem *PCALL_HASH_TABLE[HASH_KEY_RANGE] = {NULL};
 
 staticItem *STATIC_HASH_TABLE[HASH_KEY_RANGE] = {NULL};
 
+// metadata table of the running thread, open addressing on the pointer
+// address, doubled before it gets half full and freed when the thread exits
+static __thread tlEntry *TL_TABLE = NULL;
+static __thread unsigned long TL_TABLE_SIZE = 0;
+static __thread unsigned long TL_TABLE_USED = 0;
+static pthread_key_t tl_table_key;
+static pthread_once_t tl_table_once = PTHREAD_ONCE_INIT;
+
 // update mpx table
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 update_mpx_table(unsigned long ptr_addr, unsigned long ptr_val,
                  unsigned long origin, unsigned long originCtx) {
   __asm__ __volatile__("bndmk (%0,%1), %%bnd0;\
@@ -73,7 +87,7 @@ update_mpx_table(unsigned long ptr_addr, unsigned long ptr_val,
 }
 
 // get entry from mpx table
-mEntry __attribute__((__used__))
+mEntry OSCFI_CC __attribute__((__used__))
 get_entry_mpx_table(unsigned long ptr_addr, unsigned long ptr_val) {
   mEntry entry;
   unsigned long bnds[2];
@@ -90,6 +104,314 @@ get_entry_mpx_table(unsigned long ptr_addr, unsigned long ptr_val) {
   return entry;
 }
 
+// the thread is exiting, a later TLS destructor may still free or store a
+// pointer and must find no table rather than the freed one
+static void tl_table_release(void *table) {
+  TL_TABLE = NULL;
+  TL_TABLE_SIZE = 0;
+  TL_TABLE_USED = 0;
+  free(table);
+}
+
+static void tl_table_key_init() {
+  pthread_key_create(&tl_table_key, tl_table_release);
+}
+
+static inline tlEntry *tl_table_slot(tlEntry *table, unsigned long size,
+                              unsigned long ptr_addr) {
+  unsigned long i = ((ptr_addr >> 3) ^ (ptr_addr >> 17)) & (size - 1);
+  while (table[i].ptr_addr != 0 && table[i].ptr_addr != ptr_addr)
+    i = (i + 1) & (size - 1);
+  return &table[i];
+}
+
+// a rare slow path of update_tl_table, the entries dropped on free are left
+// behind and the table only doubles when the live ones keep it a quarter full
+static void OSCFI_CC __attribute__((noinline, cold)) tl_table_grow() {
+  unsigned long i, size, live = 0;
+  tlEntry *table;
+  for (i = 0; i < TL_TABLE_SIZE; i++) {
+    if (TL_TABLE[i].ptr_val != 0)
+      live++;
+  }
+  if (TL_TABLE_SIZE == 0)
+    size = TL_TABLE_INIT_SIZE;
+  else if (4 * (live + 1) > TL_TABLE_SIZE)
+    size = TL_TABLE_SIZE * 2;
+  else
+    size = TL_TABLE_SIZE;
+  table = calloc(size, sizeof(tlEntry));
+  if (table == NULL) {
+    fprintf(stderr, "[OSCFI-LOG] Cannot grow the thread metadata table\n");
+    abort();
+  }
+  for (i = 0; i < TL_TABLE_SIZE; i++) {
+    if (TL_TABLE[i].ptr_val != 0)
+      *tl_table_slot(table, size, TL_TABLE[i].ptr_addr) = TL_TABLE[i];
+  }
+  free(TL_TABLE);
+  TL_TABLE = table;
+  TL_TABLE_SIZE = size;
+  TL_TABLE_USED = live;
+  pthread_once(&tl_table_once, tl_table_key_init);
+  pthread_setspecific(tl_table_key, table);
+}
+
+// update the running thread's metadata table
+void OSCFI_CC __attribute__((__used__))
+update_tl_table(unsigned long ptr_addr, unsigned long ptr_val,
+                unsigned long origin, unsigned long originCtx) {
+  tlEntry *slot;
+  if (2 * (TL_TABLE_USED + 1) > TL_TABLE_SIZE)
+    tl_table_grow();
+  slot = tl_table_slot(TL_TABLE, TL_TABLE_SIZE, ptr_addr);
+  if (slot->ptr_addr == 0) {
+    slot->ptr_addr = ptr_addr;
+    TL_TABLE_USED++;
+  }
+  slot->ptr_val = ptr_val;
+  slot->entry.origin = origin;
+  slot->entry.originCtx = originCtx;
+  stats[12]++;
+}
+
+// get entry from the running thread's metadata table, like bndldx the
+// entry is dropped if the pointer was overwritten since
+mEntry OSCFI_CC __attribute__((__used__))
+get_entry_tl_table(unsigned long ptr_addr, unsigned long ptr_val) {
+  mEntry entry = {0, 0};
+  if (TL_TABLE != NULL) {
+    tlEntry *slot = tl_table_slot(TL_TABLE, TL_TABLE_SIZE, ptr_addr);
+    if (slot->ptr_addr == ptr_addr && slot->ptr_val == ptr_val)
+      entry = slot->entry;
+  }
+
+  stats[13]++;
+
+  return entry;
+}
+
+// move the metadata of a pointer stored at from to the same pointer stored at
+// to, a slot without metadata reads the INIT bounds which are not stored
+static inline __attribute__((always_inline)) void
+shadow_move(unsigned long to, unsigned long from, unsigned long val) {
+  unsigned long bnds[2];
+  __asm__ __volatile__("bndldx (%1,%2), %%bnd0;\
+      bndmov %%bnd0, %0;"
+                       : "=m"(bnds)
+                       : "r"(from), "r"(val)
+                       : "%bnd0");
+  if ((bnds[0] | bnds[1]) == 0)
+    return;
+  __asm__ __volatile__("bndmov %0, %%bnd0;\
+      bndstx %%bnd0, (%1,%2);"
+                       :
+                       : "m"(bnds), "r"(to), "r"(val)
+                       : "%bnd0");
+}
+
+// same for a pointer kept in the running thread's metadata table, false if
+// the table has no entry for it
+static inline __attribute__((always_inline)) int
+tl_shadow_move(unsigned long to, unsigned long from, unsigned long val) {
+  tlEntry *slot = tl_table_slot(TL_TABLE, TL_TABLE_SIZE, from);
+  if (slot->ptr_addr != from || slot->ptr_val != val)
+    return 0;
+  update_tl_table(to, val, slot->entry.origin, slot->entry.originCtx);
+  return 1;
+}
+
+// copy the metadata of the pointers in [src, src + n) to the same offsets
+// from dst, reading the pointer values at the same offsets from data. Only
+// the 8-byte aligned slots of src can hold a pointer, a null slot has no
+// metadata, and overlapping slots are walked in the direction memmove copies.
+// MDPlacement places both sides of a copy in the same store, so the metadata
+// stays in the store it is found in
+static void shadow_copy(unsigned long dst, unsigned long src, unsigned long n,
+                        unsigned long data) {
+  unsigned long first = (src + 7) & ~7UL;
+  unsigned long delta = dst - src;
+  unsigned long count, i;
+
+  if (dst == src || src + n < first + 8)
+    return;
+  count = (src + n - first) / 8;
+  for (i = 0; i < count; i++) {
+    unsigned long slot = first + 8 * (dst < src ? i : count - 1 - i);
+    unsigned long val = *(unsigned long *)(slot - src + data);
+    if (val == 0)
+      continue;
+    if (TL_TABLE_USED == 0 || !tl_shadow_move(slot + delta, slot, val))
+      shadow_move(slot + delta, slot, val);
+  }
+  stats[14]++;
+}
+
+// memcpy keeping the metadata of the copied pointers
+void *__attribute__((__used__))
+oscfi_memcpy(void *dst, const void *src, unsigned long n) {
+  shadow_copy((unsigned long)dst, (unsigned long)src, n, (unsigned long)src);
+  return memcpy(dst, src, n);
+}
+
+// memmove keeping the metadata of the moved pointers, the metadata goes first
+// while the source still holds the pointers
+void *__attribute__((__used__))
+oscfi_memmove(void *dst, const void *src, unsigned long n) {
+  shadow_copy((unsigned long)dst, (unsigned long)src, n, (unsigned long)src);
+  return memmove(dst, src, n);
+}
+
+// a bound table entry per 8-byte slot of the memory a directory entry covers
+#define BT_ENTRY_SIZE (4 * sizeof(void *))
+#define BT_SIZE ((1UL << NUM_L2_BITS) * BT_ENTRY_SIZE)
+#define BT_COVER_BITS (NUM_L2_BITS + NUM_IGN_BITS)
+#define SHADOW_PAGE_SIZE 4096UL
+
+// drop the bound table entries of the slots in [start, end), the table pages
+// fully covered are given back to the kernel and read as zero again
+static void shadow_reclaim(unsigned long start, unsigned long end) {
+  unsigned long *bd = get_bd();
+  unsigned long slot = (1UL << NUM_IGN_BITS) - 1;
+  unsigned long addr = (start + slot) & ~slot;
+
+  if (bd == NULL)
+    return;
+  end &= ~slot;
+  while (addr < end) {
+    unsigned long next = ((addr >> BT_COVER_BITS) + 1) << BT_COVER_BITS;
+    unsigned long bde =
+        bd[(addr >> BT_COVER_BITS) & ((1UL << NUM_L1_BITS) - 1)];
+    if (next > end)
+      next = end;
+    if (bde & MPX_L2_VALID_MASK) {
+      unsigned long lo = (bde & MPX_L2_ADDR_MASK) +
+                         ((addr >> NUM_IGN_BITS) & ((1UL << NUM_L2_BITS) - 1)) *
+                             BT_ENTRY_SIZE;
+      unsigned long hi = lo + ((next - addr) >> NUM_IGN_BITS) * BT_ENTRY_SIZE;
+      unsigned long plo = (lo + SHADOW_PAGE_SIZE - 1) & ~(SHADOW_PAGE_SIZE - 1);
+      unsigned long phi = hi & ~(SHADOW_PAGE_SIZE - 1);
+      if (plo < phi) {
+        memset((void *)lo, 0, plo - lo);
+        if (madvise((void *)plo, phi - plo, MADV_DONTNEED) != 0)
+          memset((void *)plo, 0, phi - plo);
+        memset((void *)phi, 0, hi - phi);
+      } else {
+        memset((void *)lo, 0, hi - lo);
+      }
+    }
+    addr = next;
+  }
+}
+
+// drop the entries of the running thread's metadata table in [start, end),
+// the slots are recycled by the next tl_table_grow. The 8-byte aligned slots
+// of the block are probed, the table is only scanned when it is smaller
+static void tl_table_drop(unsigned long start, unsigned long end) {
+  unsigned long addr, i;
+  if ((end - start) / 8 < TL_TABLE_SIZE) {
+    for (addr = (start + 7) & ~7UL; addr + 8 <= end; addr += 8) {
+      tlEntry *slot = tl_table_slot(TL_TABLE, TL_TABLE_SIZE, addr);
+      if (slot->ptr_addr == addr)
+        slot->ptr_val = 0;
+    }
+    return;
+  }
+  for (i = 0; i < TL_TABLE_SIZE; i++) {
+    if (TL_TABLE[i].ptr_addr >= start && TL_TABLE[i].ptr_addr < end)
+      TL_TABLE[i].ptr_val = 0;
+  }
+}
+
+// drop the metadata of [ptr, ptr + size) of a block about to be freed, only
+// blocks of at least SHADOW_RECLAIM_SIZE are worth it. The compiler calls it
+// before operator delete of an object holding code pointers
+void __attribute__((__used__)) oscfi_reclaim(void *ptr, unsigned long size) {
+  unsigned long start = (unsigned long)ptr;
+  if (ptr == NULL || size < SHADOW_RECLAIM_SIZE)
+    return;
+  shadow_reclaim(start, start + size);
+  if (TL_TABLE_USED != 0)
+    tl_table_drop(start, start + size);
+  stats[15]++;
+}
+
+// free of a block holding code pointers, the compiler calls it instead of free
+void __attribute__((__used__)) oscfi_free(void *ptr) {
+  if (ptr != NULL)
+    oscfi_reclaim(ptr, malloc_usable_size(ptr));
+  free(ptr);
+}
+
+// realloc keeping the metadata of the pointers of a moved block. A large
+// block that grows is moved here, so its metadata is dropped before the old
+// block is freed, and a large block that shrinks drops that of its tail.
+// Otherwise the old block is freed by realloc and the pointers are read from
+// the new one
+void *__attribute__((__used__)) oscfi_realloc(void *ptr, unsigned long size) {
+  unsigned long from = (unsigned long)ptr;
+  unsigned long old = ptr ? malloc_usable_size(ptr) : 0;
+  void *res;
+  if (old >= SHADOW_RECLAIM_SIZE && size > old) {
+    res = malloc(size);
+    if (res != NULL) {
+      shadow_copy((unsigned long)res, from, old, from);
+      memcpy(res, ptr, old);
+      oscfi_free(ptr);
+    }
+    return res;
+  }
+  if (old >= SHADOW_RECLAIM_SIZE)
+    oscfi_reclaim((char *)ptr + size, old - size);
+  res = realloc(ptr, size);
+  if (res != NULL && (unsigned long)res != from && old != 0)
+    shadow_copy((unsigned long)res, from, old < size ? old : size,
+                (unsigned long)res);
+  return res;
+}
+
+static unsigned long resident_size(unsigned long addr, unsigned long len,
+                                   unsigned char *vec) {
+  unsigned long i, rss = 0;
+  if (mincore((void *)addr, len, vec) != 0)
+    return 0;
+  for (i = 0; i < len / SHADOW_PAGE_SIZE; i++) {
+    if (vec[i] & 1)
+      rss += SHADOW_PAGE_SIZE;
+  }
+  return rss;
+}
+
+// resident bytes of the bound directory and tables, and of the running
+// thread's metadata table
+unsigned long __attribute__((__used__)) oscfi_metadata_rss() {
+  unsigned long *bd = get_bd();
+  unsigned long per_page = SHADOW_PAGE_SIZE / sizeof(unsigned long);
+  unsigned long rss = TL_TABLE_SIZE * sizeof(tlEntry);
+  unsigned char *bd_vec, *bt_vec;
+  unsigned long i, j;
+
+  if (bd == NULL)
+    return rss;
+  bd_vec = malloc(MPX_L1_SIZE / SHADOW_PAGE_SIZE);
+  bt_vec = malloc(BT_SIZE / SHADOW_PAGE_SIZE);
+  if (bd_vec != NULL && bt_vec != NULL &&
+      mincore(bd, MPX_L1_SIZE, bd_vec) == 0) {
+    for (i = 0; i < MPX_L1_SIZE / SHADOW_PAGE_SIZE; i++) {
+      if (!(bd_vec[i] & 1))
+        continue;
+      rss += SHADOW_PAGE_SIZE;
+      for (j = i * per_page; j < (i + 1) * per_page; j++) {
+        if (bd[j] & MPX_L2_VALID_MASK)
+          rss += resident_size(bd[j] & MPX_L2_ADDR_MASK, BT_SIZE, bt_vec);
+      }
+    }
+  }
+  free(bd_vec);
+  free(bt_vec);
+  return rss;
+}
+
 // add new oscfiItem in the OSCFI_HASH_TABLE
 void __attribute__((__used__))
 oscfi_hash_insert(unsigned long ref_id, unsigned long target,
@@ -226,24 +548,31 @@ static_hash_insert(unsigned long ref_id, unsigned long target) {
   }
 }
 
-void __attribute__((__used__))
+// failures are kept out of line, the monitors then only save the registers
+// their fast path uses
+static void OSCFI_CC __attribute__((noinline, cold))
+oscfi_report(const char *fmt, unsigned long a, unsigned long b,
+             unsigned long c, unsigned long d, unsigned long e) {
+  fprintf(stderr, fmt, a, b, c, d, e);
+}
+
+void OSCFI_CC __attribute__((__used__))
 pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
                         unsigned long ptr_val) {
   stats[10]++;
 }
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
                         unsigned long vtable_addr, unsigned long vtarget) {
   stats[11]++;
 }
 
-void __attribute__((__used__))
-oscfi_vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
-                              unsigned long vtable_addr, unsigned long target) {
-  mEntry entry = get_entry_mpx_table(vptr_addr, vtable_addr);
-
+static inline __attribute__((always_inline)) void
+oscfi_vcall_check(unsigned long ref_id, unsigned long vtable_addr,
+                  unsigned long target, mEntry entry) {
   if (entry.origin == 0) {
-    fprintf(stderr, "[OSCFI-LOG] Something wrong with mpx metadata table\n");
+    oscfi_report("[OSCFI-LOG] Something wrong with mpx metadata table\n", 0, 0,
+                 0, 0, 0);
   }
 
   unsigned long long hash_key =
@@ -261,19 +590,32 @@ oscfi_vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
     }
   }
 
-  fprintf(stderr,
-          "[OSCFI-LOG] Failed validation for <vcall origin sensitivity> {%lu "
-          "=> %lx[%lu]}\n",
-          ref_id, target, entry.origin);
+  oscfi_report("[OSCFI-LOG] Failed validation for <vcall origin sensitivity> "
+               "{%lu => %lx[%lu]}\n",
+               ref_id, target, entry.origin, 0, 0);
 }
 
-void __attribute__((__used__))
-oscfi_pcall_ctx_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
-                                  unsigned long ptr_val) {
-  mEntry entry = get_entry_mpx_table(ptr_addr, ptr_val);
+void OSCFI_CC __attribute__((__used__))
+oscfi_vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
+                              unsigned long vtable_addr, unsigned long target) {
+  oscfi_vcall_check(ref_id, vtable_addr, target,
+                    get_entry_mpx_table(vptr_addr, vtable_addr));
+}
 
+void OSCFI_CC __attribute__((__used__))
+oscfi_vcall_tl_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
+                                 unsigned long vtable_addr,
+                                 unsigned long target) {
+  oscfi_vcall_check(ref_id, vtable_addr, target,
+                    get_entry_tl_table(vptr_addr, vtable_addr));
+}
+
+static inline __attribute__((always_inline)) void
+oscfi_pcall_ctx_check(unsigned long ref_id, unsigned long ptr_val,
+                      mEntry entry) {
   if (entry.origin == 0) {
-    fprintf(stderr, "[OSCFI-LOG] Something wrong with mpx metadata table\n");
+    oscfi_report("[OSCFI-LOG] Something wrong with mpx metadata table\n", 0, 0,
+                 0, 0, 0);
   }
 
   unsigned long long hash_key =
@@ -291,20 +633,31 @@ oscfi_pcall_ctx_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
     }
   }
 
-  fprintf(stderr,
-          "[OSCFI-LOG] Failed validation for <pcall origin with CTX "
-          "sensitivity> {%lu "
-          "=> %lx} [%lu, %lx]\n",
-          ref_id, ptr_val, entry.origin, entry.originCtx);
+  oscfi_report("[OSCFI-LOG] Failed validation for <pcall origin with CTX "
+               "sensitivity> {%lu "
+               "=> %lx} [%lu, %lx]\n",
+               ref_id, ptr_val, entry.origin, entry.originCtx, 0);
 }
 
-void __attribute__((__used__))
-oscfi_pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
-                              unsigned long ptr_val) {
-  mEntry entry = get_entry_mpx_table(ptr_addr, ptr_val);
+void OSCFI_CC __attribute__((__used__))
+oscfi_pcall_ctx_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
+                                  unsigned long ptr_val) {
+  oscfi_pcall_ctx_check(ref_id, ptr_val,
+                        get_entry_mpx_table(ptr_addr, ptr_val));
+}
+
+void OSCFI_CC __attribute__((__used__))
+oscfi_pcall_ctx_tl_reference_monitor(unsigned long ref_id,
+                                     unsigned long ptr_addr,
+                                     unsigned long ptr_val) {
+  oscfi_pcall_ctx_check(ref_id, ptr_val, get_entry_tl_table(ptr_addr, ptr_val));
+}
 
+static inline __attribute__((always_inline)) void
+oscfi_pcall_check(unsigned long ref_id, unsigned long ptr_val, mEntry entry) {
   if (entry.origin == 0) {
-    fprintf(stderr, "[OSCFI-LOG] Something wrong with mpx metadata table\n");
+    oscfi_report("[OSCFI-LOG] Something wrong with mpx metadata table\n", 0, 0,
+                 0, 0, 0);
   }
 
   unsigned long long hash_key =
@@ -322,14 +675,25 @@ oscfi_pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
     }
   }
 
-  fprintf(stderr,
-          "[OSCFI-LOG] Failed validation for <pcall origin w/o CTX "
-          "sensitivity> {%lu "
-          "=> %lx} [%lu]\n",
-          ref_id, ptr_val, entry.origin);
+  oscfi_report("[OSCFI-LOG] Failed validation for <pcall origin w/o CTX "
+               "sensitivity> {%lu "
+               "=> %lx} [%lu]\n",
+               ref_id, ptr_val, entry.origin, 0, 0);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
+oscfi_pcall_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
+                              unsigned long ptr_val) {
+  oscfi_pcall_check(ref_id, ptr_val, get_entry_mpx_table(ptr_addr, ptr_val));
+}
+
+void OSCFI_CC __attribute__((__used__))
+oscfi_pcall_tl_reference_monitor(unsigned long ref_id, unsigned long ptr_addr,
+                                 unsigned long ptr_val) {
+  oscfi_pcall_check(ref_id, ptr_val, get_entry_tl_table(ptr_addr, ptr_val));
+}
+
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor_d0(unsigned long ref_id, unsigned long ptr_addr,
                                  unsigned long ptr_val) {
   unsigned long long hash_key = ((ref_id ^ ptr_val) % HASH_KEY_RANGE);
@@ -346,14 +710,13 @@ oscfi_pcall_reference_monitor_d0(unsigned long ref_id, unsigned long ptr_addr,
     }
   }
 
-  fprintf(stderr,
-          "[OSCFI-LOG] Failed validation for <pcall call-site sensitivity "
-          "depth 0> {%lu "
-          "=> %lx}\n",
-          ref_id, ptr_val);
+  oscfi_report("[OSCFI-LOG] Failed validation for <pcall call-site "
+               "sensitivity depth 0> {%lu "
+               "=> %lx}\n",
+               ref_id, ptr_val, 0, 0, 0);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor_d1(unsigned long ref_id, unsigned long ptr_addr,
                                  unsigned long ptr_val) {
   unsigned long long site1 = (unsigned long long)__builtin_return_address(1);
@@ -371,14 +734,13 @@ oscfi_pcall_reference_monitor_d1(unsigned long ref_id, unsigned long ptr_addr,
     }
   }
 
-  fprintf(stderr,
-          "[OSCFI-LOG] Failed validation for <pcall call-site sensitivity "
-          "depth 1> {%lu "
-          "=> %lx [%lx]}\n",
-          ref_id, ptr_val, site1);
+  oscfi_report("[OSCFI-LOG] Failed validation for <pcall call-site "
+               "sensitivity depth 1> {%lu "
+               "=> %lx [%lx]}\n",
+               ref_id, ptr_val, site1, 0, 0);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor_d2(unsigned long ref_id, unsigned long ptr_addr,
                                  unsigned long ptr_val) {
   unsigned long long site1 = (unsigned long long)__builtin_return_address(1);
@@ -399,14 +761,13 @@ oscfi_pcall_reference_monitor_d2(unsigned long ref_id, unsigned long ptr_addr,
     }
   }
 
-  fprintf(stderr,
-          "[OSCFI-LOG] Failed validation for <pcall call-site sensitivity "
-          "depth 2> {%lu "
-          "=> %lx [%lx, %lx]}\n",
-          ref_id, ptr_val, site1, site2);
+  oscfi_report("[OSCFI-LOG] Failed validation for <pcall call-site "
+               "sensitivity depth 2> {%lu "
+               "=> %lx [%lx, %lx]}\n",
+               ref_id, ptr_val, site1, site2, 0);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 oscfi_pcall_reference_monitor_d3(unsigned long ref_id, unsigned long ptr_addr,
                                  unsigned long ptr_val) {
   unsigned long long site1 = (unsigned long long)__builtin_return_address(1);
@@ -428,14 +789,13 @@ oscfi_pcall_reference_monitor_d3(unsigned long ref_id, unsigned long ptr_addr,
     }
   }
 
-  fprintf(stderr,
-          "[OSCFI-LOG] Failed validation for <pcall call-site sensitivity "
-          "depth 3> {%lu "
-          "=> %lx[%lx, %lx, %lx]}\n",
-          ref_id, ptr_val, site1, site2, site3);
+  oscfi_report("[OSCFI-LOG] Failed validation for <pcall call-site "
+               "sensitivity depth 3> {%lu "
+               "=> %lx[%lx, %lx, %lx]}\n",
+               ref_id, ptr_val, site1, site2, site3);
 }
 
-void __attribute__((__used__))
+void OSCFI_CC __attribute__((__used__))
 static_vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
                                unsigned long vtable_addr,
                                unsigned long target) {
@@ -451,10 +811,9 @@ static_vcall_reference_monitor(unsigned long ref_id, unsigned long vptr_addr,
     }
   }
 
-  fprintf(stderr,
-          "[OSCFI-LOG] Failed validation for <vcall supa fixer> {%lu => %lx "
-          "[%lx]}\n",
-          ref_id, target, vtable_addr);
+  oscfi_report("[OSCFI-LOG] Failed validation for <vcall supa fixer> {%lu => "
+               "%lx [%lx]}\n",
+               ref_id, target, vtable_addr, 0, 0);
 }
 
 // initialize the hash table at the beginning of the program execution
@@ -505,9 +864,10 @@ void __attribute__((__used__)) oscfi_end() {
   fprintf(
       stderr,
       "-----------------------------------------------------------------\n");
-  for (i = 0; i < 12; i++) {
+  for (i = 0; i < sizeof(stats) / sizeof(stats[0]); i++) {
     fprintf(stderr, "%-20s%20lu\n", stats_name[i], stats[i]);
   }
+  fprintf(stderr, "%-20s%20lu\n", "metadata_rss: ", oscfi_metadata_rss());
   fprintf(
       stderr,
       "-----------------------------------------------------------------\n");
@@ -1,30 +1,28 @@
 import sys
+import mmap
+import struct
 import r2pipe
 
-def fixCS(query):
-    res = query
-    bFile = str(sys.argv[1]) + str(sys.argv[2])
-    r2 = r2pipe.open(bFile)
-    r2.cmd("aaa")
+LABEL_SECTION = b'cfg_label_tracker'
+CFG_MAGIC = b'OSCFICFG'
+CFG_VERSION = 1
 
-    r2.cmd("s " + hex(query))
-    r2.cmd("sf.")
 
-    item = r2.cmd("/c jmp " + hex(query))
-    if (len(item) > 0):
-        res = int(item.strip('|').strip().split(' ')[0], 16)
-    else:
-        item = r2.cmd("/c jne " + hex(query))
-        if (len(item) > 0):
-            item = r2.cmd("pd -1")
-            res = int(item.strip('|').strip().split(' ')[0], 16)
-    
-    r2.quit()
-    return res
+class LabelIDMap(dict):
+    # symbolic mode keeps the label ids, INSTCFG turns them into relocations
+    def __missing__(self, key):
+        return key
+
+
+def isSymbolic():
+    return len(sys.argv) < 3
+
 
 def fixVTable(query):
     res = query
     mind = 1000
+    if (isSymbolic()):
+        return res
     bFile = str(sys.argv[1]) + str(sys.argv[2])
     r2 = r2pipe.open(bFile)
     r2.cmd("aaa")
@@ -41,69 +39,115 @@ def fixVTable(query):
     r2.quit()
     return res
 
-def main():
+def readLabelTable(bFile):
+    # map the binary and walk the ELF64 section headers to find the label
+    # tracker; the (tag, label) pairs are decoded in place as native words
     tagLabelMap = dict()
+    with open(bFile, 'rb') as fp:
+        mm = mmap.mmap(fp.fileno(), 0, access=mmap.ACCESS_READ)
+    try:
+        if (mm[:4] != b'\x7fELF' or mm[4] != 2):
+            raise ValueError(bFile + " is not an ELF64 binary")
+        (shoff, ) = struct.unpack_from('<Q', mm, 0x28)
+        (shentsize, shnum, shstrndx) = struct.unpack_from('<HHH', mm, 0x3A)
+        (stroff, ) = struct.unpack_from('<Q', mm, shoff + shstrndx * shentsize + 24)
+
+        for i in range(shnum):
+            hdr = shoff + i * shentsize
+            (name, ) = struct.unpack_from('<I', mm, hdr)
+            (offset, size) = struct.unpack_from('<QQ', mm, hdr + 24)
+            end = mm.find(b'\x00', stroff + name)
+            if (mm[stroff + name:end] != LABEL_SECTION):
+                continue
+            # entries are 16-byte (tag, label) pairs, a trailing partial
+            # pair is never a valid entry
+            size -= size % 16
+            view = memoryview(mm)[offset:offset + size]
+            words = view.cast('Q')
+            try:
+                for x in range(0, len(words), 2):
+                    tagLabelMap[words[x]] = words[x + 1]
+            finally:
+                words.release()
+                view.release()
+            break
+    finally:
+        mm.close()
+    return tagLabelMap
+
+
+def readCFGStream(cFile):
+    # decode the length-prefixed records written by oscfg -cfg-out, every
+    # record is returned as [kind, target type, icall id, target id,
+    # context ids...] in the order oscfg streamed it
+    with open(cFile, 'rb') as fp:
+        data = fp.read()
+    if (data[:8] != CFG_MAGIC):
+        raise ValueError(cFile + " is not a CFG stream")
+    (version, ) = struct.unpack_from('<I', data, 8)
+    if (version != CFG_VERSION):
+        raise ValueError(cFile + " has CFG stream version " + str(version))
+    pos = 16
+    while (pos < len(data)):
+        if (pos + 4 > len(data)):
+            raise ValueError(cFile + " ends in a partial record")
+        (length, ) = struct.unpack_from('<I', data, pos)
+        pos += 4
+        if (length < 24 or (length - 24) % 8 != 0 or
+                pos + length > len(data)):
+            raise ValueError(cFile + " ends in a partial record")
+        items = list(struct.unpack_from('<IIQQ', data, pos))
+        items.extend(struct.unpack_from('<' + str((length - 24) // 8) + 'Q',
+                                        data, pos + 24))
+        pos += length
+        yield items
+
+
+def main():
     osCFG = dict()
     csCFG = dict()
     ciCFG = dict()
 
-    bFile = str(sys.argv[1]) + "dump_table.bin"
-    with open(bFile, 'r') as fp:
-        rLine = fp.readline()
-        while rLine:
-            if (rLine[0] == ' ' and len(rLine.strip().split(' ')) >= 7):
-                items = rLine.strip().split(' ')
-                tag = (str(items[2][::-1]) + str(items[1][::-1]))
-                tag = ''.join(
-                    [tag[x:x + 2][::-1] for x in range(0, len(tag), 2)])
-                label = (str(items[4][::-1]) + str(items[3][::-1]))
-                label = ''.join(
-                    [label[x:x + 2][::-1] for x in range(0, len(label), 2)])
-                tagLabelMap[int(tag, 16)] = int(label, 16)
-            rLine = fp.readline()
-    fp.close()
-
-    eFile = str(sys.argv[1]) + "stats.bin"
-    with open(eFile, 'r') as fp:
-        eLine = fp.readline()
-        while eLine:
-            items = eLine.strip().split('\t')
-            if (items[0] == '2'):
-                if (len(items) == 6):
-                    key = (items[1], items[2], int(items[4], 10),
-                           fixCS(tagLabelMap[int(items[5], 10)]))
-                else:
-                    key = (items[1], items[2], int(items[4], 10), 0)
-
-                if (not key in osCFG):
-                    osCFG[key] = []
-                if(items[1] == '1'):
-                    osCFG[key].append(tagLabelMap[int(items[3], 10)])
-                else:
-                    osCFG[key].append(fixVTable(tagLabelMap[int(items[3], 10)]))
-            if (items[0] == '3'):
-                tmp = []
-                tmp.append(items[1])
-                tmp.append(items[2])
-                for x in range(4, len(items), 1):
-                    tmp.append(fixCS(tagLabelMap[int(items[x], 10)]))
-                key = tuple(tmp)
-                if (not key in csCFG):
-                    csCFG[key] = []
-
-                csCFG[key].append(tagLabelMap[int(items[3], 10)])
-
-            if (items[0] == '4'):
-                key = (items[1], items[2])
-                if (not key in ciCFG):
-                    ciCFG[key] = []
-                if(items[1] == '1'):
-                    ciCFG[key].append(tagLabelMap[int(items[3], 10)])
-                else:
-                    ciCFG[key].append(fixVTable(tagLabelMap[int(items[3], 10)]))
-
-            eLine = fp.readline()
-    fp.close()
+    if (isSymbolic()):
+        tagLabelMap = LabelIDMap()
+    else:
+        tagLabelMap = readLabelTable(str(sys.argv[1]) + str(sys.argv[2]))
+
+    cFile = str(sys.argv[1]) + "cfg.bin"
+    for items in readCFGStream(cFile):
+        if (items[0] == 2):
+            if (len(items) == 6):
+                key = (items[1], items[2], items[4],
+                       tagLabelMap[items[5]])
+            else:
+                key = (items[1], items[2], items[4], 0)
+
+            if (not key in osCFG):
+                osCFG[key] = []
+            if(items[1] == 1):
+                osCFG[key].append(tagLabelMap[items[3]])
+            else:
+                osCFG[key].append(fixVTable(tagLabelMap[items[3]]))
+        if (items[0] == 3):
+            tmp = []
+            tmp.append(items[1])
+            tmp.append(items[2])
+            for x in range(4, len(items), 1):
+                tmp.append(tagLabelMap[items[x]])
+            key = tuple(tmp)
+            if (not key in csCFG):
+                csCFG[key] = []
+
+            csCFG[key].append(tagLabelMap[items[3]])
+
+        if (items[0] == 4):
+            key = (items[1], items[2])
+            if (not key in ciCFG):
+                ciCFG[key] = []
+            if(items[1] == 1):
+                ciCFG[key].append(tagLabelMap[items[3]])
+            else:
+                ciCFG[key].append(fixVTable(tagLabelMap[items[3]]))
 
     osChoice = dict()
     csChoice = dict()
@@ -6,8 +6,8 @@ LLC=$OSCFI_PATH/llvm-obj/bin/llc
 DIS=$OSCFI_PATH/llvm-obj/bin/llvm-dis
 
 OSCFG=$OSCFI_PATH/svf-src/debug-build/bin/oscfg
+ECSELECT=$OSCFI_PATH/svf-src/debug-build/bin/ecselect
 CFG=$OSCFI_PATH/llvm-obj/lib/LLVMInstCFG.so
-PYSCRIPT=$OSCFI_PATH/pyScript/dumpData.py
 
 OSCFI_LIB=$OSCFI_PATH/oscfi-lib-src/svf-cfg/
 
@@ -31,8 +31,8 @@ echo "-----------------------------------------------------------------------"
 echo "++++++++++++Building the target project (assuming Makefile has been modified as expected)+++++++++++"
 export CC="$OSCFI_PATH""/llvm-obj/bin/clang"
 export CXX="$OSCFI_PATH""/llvm-obj/bin/clang++"
-export CFLAGS="-O0 -Xclang -disable-O0-optnone -flto -std=gnu89 -D_GNU_SOURCE -fpermissive -Wno-return-type -include oscfi-libs/oscfi.h -mmpx -pthread"
-export CXXFLAGS="-O0 -Xclang -disable-O0-optnone -flto -std=c++03 -D_GNU_SOURCE -fpermissive -Wno-return-type -include oscfi-libs/oscfi.h -mmpx -pthread"
+export CFLAGS="-O2 -fno-omit-frame-pointer -flto -std=gnu89 -D_GNU_SOURCE -fpermissive -Wno-return-type -include oscfi-libs/oscfi.h -mmpx -pthread"
+export CXXFLAGS="-O2 -fno-omit-frame-pointer -flto -std=c++03 -D_GNU_SOURCE -fpermissive -Wno-return-type -include oscfi-libs/oscfi.h -mmpx -pthread"
 export LFILES="oscfi-libs/oscfi.o oscfi-libs/mpxrt.o oscfi-libs/mpxrt-utils.o"
 
 make clean
@@ -45,44 +45,29 @@ make
 echo "-----------------------------------------------------------------------"
 
 echo "++++++++++++++++++CFG generation with SVF-SUPA++++++++++++++++++++++++"
-$OSCFG -svfmain -cxt -query=funptr -maxcxt=10 -flowbg=10000 -cxtbg=100000 -cpts -print-query-pts "$tarDir""/""$tarBin"".0.4.opt.bc" > "$tarDir""/outs.txt" 2> "$tarDir""/stats.bin"
+# the test suite sets SVFG_CSR to compare CFGs built without the SVFG snapshot
+SVFG_CSR=${SVFG_CSR-cxt,dfs}
+# and DDA_JOBS and DDA_SHARD_SIZE to compare CFGs built by other query workers
+DDA_JOBS=${DDA_JOBS:-$(nproc)}
+$OSCFG -svfmain -cxt -query=funptr -maxcxt=10 -flowbg=10000 -cxtbg=100000 -ander-jobs=$(nproc) -mssa-jobs=$(nproc) -dda-jobs=$DDA_JOBS ${DDA_SHARD_SIZE:+-dda-shard-size=$DDA_SHARD_SIZE} -ander-snapshot="$tarDir""/snapshot" ${SVFG_CSR:+-svfg-csr=$SVFG_CSR} -cpts -print-query-pts -cfg-out="$tarDir""/cfg.bin" -tl-out="$tarDir""/tlMD.bin" "$tarDir""/""$tarBin"".0.4.opt.bc" > "$tarDir""/outs.txt" 2> "$tarDir""/errs.txt"
 echo "-----------------------------------------------------------------------"
 
-echo "+++++++++++++++++++Build the target program+++++++++++++++++++++++++"
-$LLC -filetype=obj "$tarBin"".0.4.opt.oscfg.bc"
-$CLANGPP -mmpx -pthread -O0  "$tarBin"".0.4.opt.oscfg.o" -o "$tarBin""_dump"
-echo "-----------------------------------------------------------------------"
-
-echo "+++++++++++++++++CFG table processing (1st phase)+++++++++++++++++++++"
-objdump -s -j cfg_label_tracker "$tarBin""_dump" > dump_table.bin
-python3 $PYSCRIPT $tarDir "$tarBin""_dump"
-cp dump_table.bin dump_table.back
-echo "-----------------------------------------------------------------------"
-
-echo "++++++++++++++++++++++++++Optimization phase+++++++++++++++++++++++++++"
-$OPT -load $CFG -llvm-inst-cfg -DIR_PATH="$tarDir" < "$tarBin"".0.4.opt.oscfg.bc" > "$tarBin"".0.4.opt.oscfg.opt.bc"
-echo "-----------------------------------------------------------------------"
-
-echo "+++++++++++++++Building the program with optimization++++++++++++++++++++++"
-$LLC -filetype=obj "$tarBin"".0.4.opt.oscfg.opt.bc"
-$CLANGPP -mmpx -pthread -O0 "$tarBin"".0.4.opt.oscfg.opt.o" -o "$tarBin""_opt"
-echo "-----------------------------------------------------------------------"
-
-echo "+++++++++++++++++CFG table processing (2nd phase)+++++++++++++++++++++"
-objdump -s -j cfg_label_tracker "$tarBin""_opt" > dump_table.bin
-python3 $PYSCRIPT $tarDir "$tarBin""_opt"
+echo "+++++++++++++++++CFG table processing+++++++++++++++++++++"
+$ECSELECT "$tarDir"
 echo "-----------------------------------------------------------------------"
 
 echo "+++++++++++++++++Instrumenting CFG to the binary+++++++++++++++++++++"
-$OPT -load $CFG -llvm-inst-cfg -DIR_PATH="$tarDir" < "$tarBin"".0.4.opt.oscfg.bc" > "$tarBin"".0.4.opt.oscfg.cfg.bc"
+$OPT -load $CFG -llvm-inst-cfg -llvm-check-elim -symbolic-cfg -devirt-cfg -DIR_PATH="$tarDir" < "$tarBin"".0.4.opt.oscfg.bc" > "$tarBin"".0.4.opt.oscfg.cfg.bc"
 echo "-----------------------------------------------------------------------"
 
 echo "+++++++++++++++++++++++Final binary++++++++++++++++++++++++++++++"
 $LLC -filetype=obj "$tarBin"".0.4.opt.oscfg.cfg.bc"
-$CLANGPP -mmpx -pthread -O0 "$tarBin"".0.4.opt.oscfg.cfg.o" -o "$tarBin""_exec"
+$CLANGPP -mmpx -pthread -O2 "$tarBin"".0.4.opt.oscfg.cfg.o" -o "$tarBin""_exec"
 echo "-----------------------------------------------------------------------"
 
 echo "+++++++++++++++++++++++Removing unnecessary files++++++++++++++++++++++++++++++"
+mkdir -p run
+cp cfg.bin run/
 rm -rf *.bin *.ll *.bc *.o
 echo "-----------------------------------------------------------------------"
 
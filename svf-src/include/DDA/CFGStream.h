@@ -0,0 +1,83 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef CFGSTREAM_H_
+#define CFGSTREAM_H_
+
+#include "Util/BasicTypes.h"
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+// [OC-CFI] we will have four different kinds of CFG
+// 1) SUPA generated CI-CFG (Error included)
+// 2) Origin Sensitive CFG (oCFG)
+// 3) Callsite Sensitive CFG (cCFG)
+// 4) Type and address taken CFG (Fix the error)
+typedef enum CFG_TYPE { SUPA_CFG = 1, OCFG = 2, CCFG = 3, ATCFG = 4 } cfgType;
+typedef enum TARGET_TYPE { FUNC = 1, VT = 2 } targetType;
+
+/*!
+ * [OS-CFI] A CFG entry as it is streamed. The context words are empty for
+ * SUPA_CFG and ATCFG, the origin id and optionally the origin context id for
+ * OCFG, and the call-site ids from the innermost one for CCFG.
+ */
+struct CFGRecord {
+  u32_t kind;                 ///< cfgType
+  u32_t target;               ///< targetType
+  u64_t iCallID;              ///< id of the indirect call-site
+  u64_t iCallTargetID;        ///< PAG id of the target
+  std::vector<u64_t> context; ///< kind specific context ids
+};
+
+/*!
+ * [OS-CFI] Writer of the binary CFG stream.
+ *
+ * The stream starts with a magic and a schema version and goes on with one
+ * length-prefixed record per CFG entry: the byte length of the body, then
+ * the kind and target type as 32-bit words and the ids as 64-bit words, all
+ * in native byte order. A reader skips records of a kind it does not know.
+ */
+class CFGStreamWriter {
+public:
+  /// Constructor, reports an error if the file cannot be created
+  CFGStreamWriter(const std::string &path);
+  /// Destructor, flushes the records not written yet
+  ~CFGStreamWriter();
+
+  inline bool isOpen() const { return os != NULL; }
+  void write(const CFGRecord &rec);
+  /// Hand the records written so far to the file
+  void flush();
+
+  /// Number of records written
+  inline u32_t getNumOfRecords() const { return numOfRecords; }
+
+private:
+  llvm::raw_fd_ostream *os; ///< output file, NULL if it cannot be created
+  u32_t numOfRecords;       ///< records written
+};
+
+/*!
+ * [OS-CFI] Reader of the binary CFG stream, the file is mapped and the
+ * records are decoded in place one at a time.
+ */
+class CFGStreamReader {
+public:
+  /// Constructor, reports an error if the file is not a CFG stream
+  CFGStreamReader(const std::string &path);
+
+  inline bool isOpen() const { return buf != nullptr; }
+  /// Decode the next record, false at the end of the stream
+  bool next(CFGRecord &rec);
+  /// Whether the stream ended in the middle of a record
+  inline bool isTruncated() const { return truncated; }
+
+private:
+  std::unique_ptr<llvm::MemoryBuffer> buf; ///< mapped stream
+  const char *pos;                         ///< next record
+  bool truncated;                          ///< last record is incomplete
+};
+
+#endif /* CFGSTREAM_H_ */
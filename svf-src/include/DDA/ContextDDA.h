@@ -31,12 +31,42 @@ public:
   /// Initialization of the analysis
   virtual void initialize(SVFModule module);
 
+  /// [OS-CFI] Step budget of a context-sensitive query
+  static u64_t getCxtBudget();
+
   // [OS-CFI] return SVFG node of candidate node id
   const SVFGNode *getSVFGForCandidateNode(NodeID);
   // [OS-CFI] return OriginSensitiveTupleSet of a candidate node id
   OriginSensitiveTupleSet *getOriginSensitiveTupleSet(NodeID);
   // [OS-CFI] return CallStackSet of a candidate node id
   CallStackSet *getCSSensitiveSet(NodeID);
+  // [OS-CFI] return the context-free points-to set of a solved query
+  void getDDAQueryPts(NodeID, PointsTo &);
+  // [OS-CFI] install a query result computed by a query worker
+  void setDDAQueryResult(NodeID, const SVFGNode *, const PointsTo &,
+                         OriginSensitiveTupleSet *, CallStackSet *);
+  // [OS-CFI] return the SVFG slice a solved query depends on
+  bool getDDAQuerySlice(NodeID id, NodeBS &slice) {
+    return getQuerySlice(id, slice);
+  }
+  // [OS-CFI] install the SVFG slice of a query solved by a query worker
+  void setDDAQuerySlice(NodeID id, const NodeBS &slice, bool complete) {
+    setQuerySlice(id, slice, complete);
+  }
+  // [OS-CFI] return the SVFG the queries are solved on
+  SVFG *getDDASVFG() { return getSVFG(); }
+  // [OS-CFI] return the pre-analysis points-to set of a pointer
+  const PointsTo *getDDAPreAnalysisPts(NodeID id) {
+    return &getAndersenAnalysis()->getPts(id);
+  }
+  // [OS-CFI] limit the wall-clock time of the next queries
+  void setDDAQueryTimeout(double seconds) { setQueryTimeout(seconds); }
+  // [OS-CFI] whether the last query ran out of budget
+  bool isDDAQueryOutOfBudget() { return isOutOfBudgetQuery(); }
+  // [OS-CFI] forget the answer of a query so that it can be solved again
+  void resetDDAQueryResult(NodeID id);
+  // [OS-CFI] drop the cached dpms before the context limit changes
+  void resetDDAPass() { resetPass(); }
 
   /// Finalize analysis
   virtual inline void finalize() { CondPTAImpl<ContextCond>::finalize(); }
@@ -0,0 +1,66 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef DDABUDGET_H_
+#define DDABUDGET_H_
+
+#include "Util/BasicTypes.h"
+#include <chrono>
+
+/*!
+ * [OS-CFI] Global time and memory budget of an anytime SUPA run.
+ *
+ * The candidates are solved in passes of growing context limits. A pass may
+ * spend an even share of the time that is left for the passes still to come,
+ * and every query of a pass gets a slice of that share in proportion to its
+ * value, the number of targets its answer still allows. Once the time or the
+ * memory is used up every further query gets no time at all.
+ */
+class DDABudget {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  /// Constructor, zero seconds or megabytes leave the budget unlimited
+  DDABudget(double seconds, u32_t megabytes, u32_t firstCxt, u32_t maxCxt);
+
+  /// Start the next pass for queries of the given total value, false if the
+  /// deepest context limit was solved or the budget is used up
+  bool nextPass(u64_t value);
+  /// The queries of this process have the given total value in this pass
+  inline void setPassValue(u64_t value) { passValue = value; }
+  /// Seconds the next query of the given value may take, negative if the
+  /// time is unlimited
+  double getQueryTimeout(u32_t value);
+  /// Whether the time or the memory is used up
+  bool isExhausted();
+
+  /// Pass state
+  //@{
+  inline u32_t getCxtLimit() const { return cxt; }
+  inline u32_t getNumOfPasses() const { return numOfPasses; }
+  /// Whether the current pass refines the answers of an earlier pass
+  inline bool isDeepening() const { return numOfPasses > 1; }
+  /// Whether the current pass solves under the deepest context limit
+  inline bool isFinalPass() const { return cxt >= maxCxt; }
+  //@}
+
+  /// Seconds since the budget was created
+  double getElapsed() const;
+
+private:
+  u32_t getNumOfPassesLeft() const;
+
+  double seconds;          ///< time budget, zero if unlimited
+  u32_t megabytes;         ///< resident memory budget, zero if unlimited
+  u32_t cxt;               ///< context limit of the current pass
+  u32_t maxCxt;            ///< context limit of the last pass
+  u32_t numOfPasses;       ///< passes started so far
+  double passEnd;          ///< elapsed seconds the current pass may end at
+  u64_t passValue;         ///< value of the queries left in the current pass
+  bool exhausted;          ///< the time or the memory is used up
+  Clock::time_point start; ///< creation time
+};
+
+#endif /* DDABUDGET_H_ */
@@ -14,13 +14,17 @@
 #include "Util/CPPUtil.h"
 #include <llvm/IR/DataLayout.h>
 
+class DDABudget;
+class DDAQueryCache;
+
 /**
  * General DDAClient which queries all top level pointers by default.
  */
 class DDAClient {
 public:
   DDAClient(SVFModule mod)
-      : pag(NULL), module(mod), curPtr(0), solveAll(true) {}
+      : pag(NULL), module(mod), curPtr(0), queryCache(NULL),
+        anytimeBudget(NULL), solveAll(true) {}
 
   virtual ~DDAClient() {}
 
@@ -52,6 +56,10 @@ public:
     userInput.insert(ptr);
     solveAll = false;
   }
+  /// [OS-CFI] Set the persistent cache consulted before solving a query
+  inline void setQueryCache(DDAQueryCache *cache) { queryCache = cache; }
+  /// [OS-CFI] How the answers are budgeted: "off", "fixed" or "deepen"
+  static std::string getAnytimeMode();
   /// Get LLVM module
   inline SVFModule getModule() const { return module; }
   virtual void answerQueries(PointerAnalysis *pta);
@@ -66,10 +74,46 @@ protected:
       candidateQueries.insert(id);
   }
 
+  /// [OS-CFI] Order the valid candidates so that candidates sharing SVFG
+  /// ancestors are solved one after another, clusterOf holds the cluster of
+  /// every scheduled candidate
+  void scheduleQueries(PointerAnalysis *pta, std::vector<NodeID> &queries,
+                       std::vector<u32_t> &clusterOf);
+
+  /// [OS-CFI] Solve fixed-size shards of the candidates in forked query
+  /// workers, at most jobs at a time, and merge their results back in query
+  /// order
+  void answerQueriesInWorkers(PointerAnalysis *pta,
+                              const std::vector<NodeID> &candidates,
+                              const std::vector<u32_t> &clusterOf, u32_t jobs);
+
+  /// [OS-CFI] Solve the scheduled candidates once
+  void solveQueries(PointerAnalysis *pta, const std::vector<NodeID> &queries,
+                    const std::vector<u32_t> &clusterOf);
+
+  /// [OS-CFI] Solve the candidates in passes of growing context limits
+  /// within a global time and memory budget
+  void answerQueriesAnytime(PointerAnalysis *pta, std::vector<NodeID> queries,
+                            std::vector<u32_t> clusterOf);
+
+  /// [OS-CFI] Per-candidate steps
+  //@{
+  /// Install the cached answer of a candidate, false if it has to be solved
+  bool lookupQuery(NodeID id);
+  /// Solve a candidate, true if it ran out of budget
+  bool solveQuery(PointerAnalysis *pta, NodeID id);
+  /// A candidate got its answer
+  void finishQuery(PointerAnalysis *pta, NodeID id, bool truncated);
+  //@}
+
   PAG *pag;                 ///< PAG graph used by current DDA analysis
   SVFModule module;         ///< LLVM module
   NodeID curPtr;            ///< current pointer being queried
   NodeSet candidateQueries; ///< store all candidate pointers to be queried
+  DDAQueryCache *queryCache; ///< [OS-CFI] persistent query cache, may be NULL
+  DDABudget *anytimeBudget;  ///< [OS-CFI] budget of an anytime run, may be NULL
+  NodeBS improvableQueries;  ///< [OS-CFI] answers a deeper pass may refine
+  NodeBS truncatedQueries;   ///< [OS-CFI] answers cut short by the budget
 
 private:
   NodeSet userInput; ///< User input queries
@@ -0,0 +1,83 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef DDAMEMGOVERNOR_H_
+#define DDAMEMGOVERNOR_H_
+
+#include "Util/BasicTypes.h"
+#include "Util/DPItem.h"
+#include <algorithm>
+#include <cstdio>
+#include <sys/types.h>
+
+/*!
+ * [OS-CFI] Memory governor of the DDA solver caches.
+ *
+ * Before every query the governor compares the resident set size with a
+ * ceiling. Whenever the ceiling is exceeded it halves the number of cached
+ * dpms the solver may keep, and the solver evicts its least recently used
+ * dpms down to that number, and lets the number grow back once the resident
+ * set is well under the ceiling again. Evicted points-to sets are optionally
+ * spilled to an unlinked temporary file, which is read back through a shared
+ * mapping, so a dpm that turns hot again is restored rather than solved
+ * again. Only the process that opened the file appends to it, a forked query
+ * worker reads the entries spilled before the fork and drops what it evicts.
+ */
+class DDAMemGovernor {
+public:
+  typedef std::vector<u64_t> Words;
+  /// A spilled entry as (offset, number of words)
+  typedef std::pair<u64_t, u64_t> Entry;
+
+  /// Constructor, opens the spill file if spilling was asked for
+  DDAMemGovernor();
+  /// Destructor
+  ~DDAMemGovernor();
+
+  /// Whether a resident memory ceiling was given
+  static bool isEnabled();
+
+  /// Number of cached dpms the solver may keep, false if it may keep them all
+  bool getCacheLimit(u32_t numOfCached, u32_t &limit);
+  /// Give the memory freed by an eviction back to the system
+  void release();
+
+  /// Spill file
+  //@{
+  bool isSpilling() const;
+  /// Append an entry, offset is counted in words
+  bool spill(const Words &words, u64_t &offset);
+  /// Words of a spilled entry, NULL if the file cannot be mapped
+  const u64_t *load(u64_t offset, u64_t num);
+  /// An entry of num words was read back or dropped
+  inline void discard(u64_t num) { liveWords -= std::min(liveWords, num); }
+  /// Every entry was dropped, the file is written from its start again
+  void discardAll();
+  /// Whether most of the file is taken by discarded entries
+  bool needsCompaction() const;
+  /// Move the given live entries to a new file and update their offsets
+  bool compact(const std::vector<Entry *> &entries);
+  //@}
+
+  /// Spilled form of the cached points-to sets
+  //@{
+  static void encode(const PointsTo &pts, Words &words);
+  static void encode(const CxtPtSet &pts, Words &words);
+  static bool decode(const u64_t *words, u64_t num, PointsTo &pts);
+  static bool decode(const u64_t *words, u64_t num, CxtPtSet &pts);
+  //@}
+
+private:
+  bool limited;     ///< the ceiling was exceeded at least once
+  u32_t cacheLimit; ///< dpms the solver may keep once limited
+  FILE *spillFile;  ///< unlinked spill file, NULL if not spilling
+  pid_t spillPid;   ///< process that opened the spill file
+  u64_t spillSize;  ///< bytes written to the spill file
+  u64_t liveWords;  ///< words of the entries not discarded yet
+  void *mapping;    ///< shared mapping of the spill file, NULL if none
+  u64_t mappedSize; ///< bytes covered by the mapping
+};
+
+#endif /* DDAMEMGOVERNOR_H_ */
@@ -6,11 +6,13 @@
 #ifndef WPA_H_
 #define WPA_H_
 
+#include "DDA/CFGStream.h"
 #include "DDA/DDAClient.h"
 #include "MemoryModel/PointerAnalysis.h"
 #include "Util/SCC.h"
 #include <llvm/Analysis/AliasAnalysis.h>
 #include <llvm/Pass.h>
+#include <unordered_map>
 
 #define DUMP_CFG_DEBUG 1       // [OS-CFI] CFG DUMP FLAG
 #define HASH_ID_RANGE 10000000 // [OS-CFI] unique hash id range
@@ -26,55 +28,7 @@ class SVFGEdge;
 // [OS-CFI] we fix SUPA errored points-to for two reasons: 1) it points-to all
 // address-taken 2) it points-to empty
 typedef enum FIX_TYPE { OVER_APPROXIMATE = 1, UNDER_APPROXIMATE = 2 } fixType;
-// [OC-CFI] we will have four different kinds of CFG
-// 1) SUPA generated CI-CFG (Error included)
-// 2) Origin Sensitive CFG (oCFG)
-// 3) Callsite Sensitive CFG (cCFG)
-// 4) Type and address taken CFG (Fix the error)
-typedef enum CFG_TYPE { SUPA_CFG = 1, OCFG = 2, CCFG = 3, ATCFG = 4 } cfgType;
-typedef enum TARGET_TYPE { FUNC = 1, VT = 2 } targetType;
-
-// [OS-CFI] oCFG Data Structure
-// Origin Context can be null
-typedef struct oCFGData {
-  const llvm::Instruction *iCallInst;
-  unsigned long iCallID;
-  const llvm::Value *iCallTarget;
-  unsigned long iCallTargetID;
-  unsigned long originID;
-  const llvm::Instruction *originCTXInst;
-  unsigned long originCTXID;
-} oCFG;
-
-// [OS-CFI] cCFG Data Structure
-// # of callsite will be variable
-typedef struct cCFGData {
-  const llvm::Instruction *iCallInst;
-  unsigned long iCallID;
-  const llvm::Value *iCallTarget;
-  unsigned long iCallTargetID;
-  std::vector<const llvm::Instruction *> *cInstStack;
-  std::vector<unsigned long> *cIDStack;
-} cCFG;
-
-// [OS-CFI] Address Taken and Type Check CFG Data Structure
-// the fixType is the enum defined above
-typedef struct AddrTypeData {
-  fixType type;
-  const llvm::Instruction *iCallInst;
-  unsigned long iCallID;
-  const llvm::Value *iCallTarget;
-  unsigned long iCallTargetID;
-} atCFG;
-
-// [OS-CFI] CI-CFG Data Structure
-// Generated by SUPA
-typedef struct SUPAData {
-  const llvm::Instruction *iCallInst;
-  unsigned long iCallID;
-  const llvm::Value *iCallTarget;
-  unsigned long iCallTargetID;
-} supaCFG;
+// [OS-CFI] the CFG kinds and target types are defined by the CFG stream
 
 // [OS-CFI]Function* can map a set of Instruction*
 typedef std::map<const llvm::Value *, unsigned long> ValToIDMap;
@@ -86,40 +40,31 @@ typedef std::map<llvm::Function *, std::set<llvm::Instruction *>>
 typedef std::map<llvm::Function *, std::set<llvm::Instruction *>>::iterator
     FuncToInstSetMapIt;
 
-// [OS-CFI] Function* can map a set of BasicBlock*
-typedef std::map<llvm::Function *, std::set<llvm::BasicBlock *>> FuncToBBSetMap;
-typedef std::map<llvm::Function *, std::set<llvm::BasicBlock *>>::iterator
-    FuncToBBSetMapIt;
-
-// [OS-CFI] BasicBlock* can map to an unsigned long
-typedef std::map<llvm::BasicBlock *, unsigned long> BBToIDMap;
-typedef std::map<llvm::BasicBlock *, unsigned long>::iterator BBToIDMapIt;
-
-// [OS-CFI] typedef container for CFGs
-typedef std::vector<supaCFG *> SUPACFGList;
-typedef std::vector<supaCFG *>::iterator SUPACFGListIt;
-typedef std::vector<cCFG *> CCFGList;
-typedef std::vector<cCFG *>::iterator CCFGListIt;
-typedef std::vector<oCFG *> OCFGList;
-typedef std::vector<oCFG *>::iterator OCFGListIt;
-typedef std::vector<atCFG *> ATCFGList;
-typedef std::vector<atCFG *>::iterator ATCFGListIt;
+// [OS-CFI] typedef call-site context of a cCFG entry
+typedef std::vector<const llvm::Instruction *> CSiteInstVec;
 // [OS-CFI] typdef address taken function set
 typedef std::set<llvm::Function *> FuncSet;
 typedef std::set<llvm::Function *>::iterator FuncSetIt;
 
+// [OS-CFI] canonical signature to the address-taken functions of it, NULL
+// maps the ones without parameter
+typedef std::unordered_map<const llvm::FunctionType *,
+                           std::vector<llvm::Function *>>
+    SigToFuncVecMap;
+// [OS-CFI] indirect call-site to its canonical signature
+typedef std::unordered_map<const llvm::Instruction *,
+                           const llvm::FunctionType *>
+    InstToSigMap;
+
 class DDAPass : public llvm::ModulePass {
 private:
-  SUPACFGList supaCFGList; // [OS-CFI] List of SUPA CF-CFG Entry
-  CCFGList cCFGList;       // [OS-CFI] List of CS-CFG Entry
-  OCFGList oCFGList;       // [OS-CFI] List of OS-CFG Entry
-  ATCFGList atCFGList;     // [OS-CFI] List of ADDRTY-CFG Entry
-  FuncSet setAddrFunc;     // [OS-CFI] Set of ADDR Functions
+  CFGStreamWriter *cfgStream;     // [OS-CFI] CFG entries as they are computed
+  FuncSet setAddrFunc;            // [OS-CFI] Set of ADDR Functions
+  SigToFuncVecMap mapSigAddrFunc; // [OS-CFI] ADDR Functions by signature
+  InstToSigMap mapInstSig;        // [OS-CFI] signatures of the sinks
 
   FuncToInstSetMap mapFnCSite; // [OS-CFI] ToDo
   InstToIDMap mapInstID;       // [OS-CFI] ToDo
-  BBToIDMap mapBBID;           // [OS-CFI] ToDo
-  FuncToBBSetMap mapFnBB;      // [OS-CFI] ToDo
   ValToIDMap mapValID;         // [OS-CFI] ToDo
 
 public:
@@ -129,7 +74,8 @@ public:
   typedef std::set<const SVFGEdge *> SVFGEdgeSet;
   typedef std::vector<PointerAnalysis *> PTAVector;
 
-  DDAPass() : llvm::ModulePass(ID), _pta(NULL), _client(NULL) {}
+  DDAPass()
+      : llvm::ModulePass(ID), cfgStream(NULL), _pta(NULL), _client(NULL) {}
   ~DDAPass();
 
   virtual inline void getAnalysisUsage(llvm::AnalysisUsage &au) const {
@@ -166,14 +112,28 @@ public:
 private:
   unsigned long getHashID(const llvm::Instruction *); // [OS-CFI] return unique
                                                       // id for an instruction
-  void computeCFG(SVFModule);  // [OS-CFI] fill out CFG containers
-  void dumpSUPACFG(); // [OS-CFI] print SUPA CI-CFG
-  void dumpoCFG();    // [OS-CFI] print OS-CFG
-  void dumpcCFG();    // [OS-CFI] print CS-CFG
-  void dumpatCFG();   // [OS-CFI] print ADDRTY-CFG
+  void computeCFG(SVFModule);  // [OS-CFI] stream the CFGs of every query
+  void emitSUPACFG(const llvm::Instruction *, unsigned long,
+                   const llvm::Value *,
+                   unsigned long); // [OS-CFI] stream a SUPA CI-CFG entry
+  void emitoCFG(const llvm::Instruction *, unsigned long, const llvm::Value *,
+                unsigned long, unsigned long,
+                const llvm::Instruction *); // [OS-CFI] stream an OS-CFG entry
+  void emitcCFG(const llvm::Instruction *, unsigned long, const llvm::Value *,
+                unsigned long,
+                const CSiteInstVec &); // [OS-CFI] stream a CS-CFG entry
+  void emitatCFG(fixType, const llvm::Instruction *, unsigned long,
+                 const llvm::Value *,
+                 unsigned long); // [OS-CFI] stream an ADDRTY-CFG entry
   void labelForCSite(const llvm::Instruction *, unsigned long); // [OS-CFI] ToDo
   void createLabelForCS();                                      // [OS-CFI] ToDo
   void createLabelForValue(SVFModule);                          // [OS-CFI] ToDo
+  const llvm::FunctionType *
+  getSignature(const llvm::Function *); // [OS-CFI] canonical signature of a
+                                        // function
+  const llvm::FunctionType *
+  getSignature(const llvm::Instruction *); // [OS-CFI] canonical signature of
+                                           // a call, NULL for other sinks
   bool isTypeMatch(const llvm::Instruction *,
                    const llvm::Value *); // [OS-CFI] test the type match between
                                          // sink and source
@@ -0,0 +1,84 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef DDAQUERYCACHE_H_
+#define DDAQUERYCACHE_H_
+
+#include "MSSA/SVFG.h"
+#include "MemoryModel/PointerAnalysis.h"
+#include <chrono>
+
+/*!
+ * [OS-CFI] Persistent cache of SUPA query results.
+ *
+ * An entry is keyed by the queried pointer and records the points-to set,
+ * the origin sensitive tuples and the call-site stacks of the query with
+ * module-independent keys (names and instruction positions). It also keeps
+ * the hash of every function its SVFG slice touched. A hash covers the
+ * function body and the value-flow edges entering it, so an entry is reused
+ * by a later run only if none of the functions it depends on changed. The
+ * header records the solver settings the answers were computed under, a file
+ * written under other settings is ignored as a whole.
+ */
+class DDAQueryCache {
+public:
+  typedef std::map<std::string, std::string> KeyToStrMap;
+  typedef std::map<std::string, NodeID> KeyToNodeMap;
+  typedef std::map<std::string, const llvm::Function *> NameToFuncMap;
+  typedef std::map<const llvm::Instruction *, std::string> InstToKeyMap;
+  typedef std::map<std::string, const llvm::Instruction *> KeyToInstMap;
+  typedef std::set<const llvm::Function *> FuncSet;
+  typedef std::chrono::steady_clock Clock;
+
+  /// Constructor, hashes the module before any query is answered
+  DDAQueryCache(const std::string &path, const std::string &settings,
+                PointerAnalysis *pta, SVFG *svfg);
+
+  /// Load the entries written by an earlier run
+  void load();
+  /// Install the cached answer of a query, false if it has to be solved
+  bool lookup(NodeID query);
+  /// Record the answer of a solved query
+  void record(NodeID query);
+  /// Write the entries that are valid for this module back
+  void save();
+  /// Save the entries recorded so far if the checkpoint interval has passed
+  void checkpoint();
+
+  /// Statistics
+  inline u32_t getNumOfHits() const { return numOfHits; }
+  inline u32_t getNumOfRecords() const { return numOfRecords; }
+
+private:
+  void hashFunctions();
+  std::string getFuncKey(const llvm::Function *fun) const;
+  std::string getInstKey(const llvm::Instruction *inst) const;
+  std::string getValueKey(const llvm::Value *val) const;
+  std::string getObjKey(NodeID id) const;
+  std::string getSVFGNodeKey(const SVFGNode *node) const;
+  const llvm::Function *getSVFGNodeFunction(const SVFGNode *node) const;
+  bool resolveInst(const std::string &key, const llvm::Instruction *&inst);
+  bool resolveObj(const std::string &key, NodeID &id);
+  bool decode(const std::string &entry, NodeID query);
+  void write(bool keepUnvisited);
+
+  std::string path;          ///< cache file
+  std::string settings;      ///< solver settings the answers depend on
+  PointerAnalysis *pta;      ///< pointer analysis answering the queries
+  PAG *pag;                  ///< PAG
+  SVFG *svfg;                ///< SVFG before any query is answered
+  KeyToStrMap funcHashes;    ///< function key to its hash
+  KeyToStrMap loadedEntries; ///< entries read and not yet looked up
+  KeyToStrMap validEntries;  ///< entries written back on save()
+  KeyToNodeMap objKeyToNode; ///< object key to PAG object node
+  NameToFuncMap nameToFunc;  ///< function name to function
+  InstToKeyMap instToKey;    ///< instruction to its position key
+  KeyToInstMap keyToInst;    ///< position key to instruction
+  u32_t numOfHits;           ///< queries answered from the cache
+  u32_t numOfRecords;        ///< queries recorded into the cache
+  Clock::time_point savedAt; ///< time of the last save
+};
+
+#endif /* DDAQUERYCACHE_H_ */
@@ -29,6 +29,10 @@ public:
 
   u64_t _NumOfStep;
   u64_t _NumOfStepInCycle;
+  // [OS-CFI] dpms the memory governor evicted, spilled and read back
+  u32_t _NumOfEvictedDPM;
+  u32_t _NumOfSpilledDPM;
+  u32_t _NumOfRestoredDPM;
   double _AnaTimePerQuery;
   double _AnaTimeCyclePerQuery;
   double _TotalTimeOfQueries;
@@ -6,11 +6,16 @@
 #ifndef VALUEFLOWDDA_H_
 #define VALUEFLOWDDA_H_
 
+#include "DDA/DDAMemGovernor.h"
 #include "DDA/DDAStat.h"
 #include "MSSA/SVFGBuilder.h"
+#include "MSSA/SVFGSnapshot.h"
+#include "Util/NodeIDMap.h"
 #include "Util/SCC.h"
 #include "WPA/Andersen.h"
 #include <algorithm>
+#include <chrono>
+#include <memory>
 
 #define DEBUG_SOLVER 0
 #define DEBUG_DETAILS 0
@@ -37,26 +42,68 @@ public:
   // [OS-CFI] general typedef
   typedef std::set<const llvm::Instruction *> InstructionSet;
   typedef std::set<const llvm::Instruction *>::iterator InstructionSetIt;
-  typedef std::map<NodeID, const StoreSVFGNode *> NodeToStoreMap;
-  typedef std::map<NodeID, const StoreSVFGNode *>::iterator NodeToStoreMapIt;
-  // [OS-CFI] Origin sensitive typedef
-  typedef std::map<NodeID, InstructionSet> TargetToOriginContextMap;
+  // [OS-CFI] per query maps are indexed by node id and cleared in O(1)
+  typedef NodeIDMap<const StoreSVFGNode *> NodeToStoreMap;
+  // [OS-CFI] Origin sensitive typedef, the context sets are immutable and
+  // shared by every node they were propagated to
+  typedef std::shared_ptr<const InstructionSet> OriginContextSetPtr;
+  typedef NodeIDMap<OriginContextSetPtr> TargetToOriginContextMap;
+  // [OS-CFI] call-string tree, a call-stack is the id of its top node and
+  // every node is interned by (parent, entry), so pushing an already seen
+  // entry allocates nothing
+  struct CallStrNode {
+    CallSwitchPair entry;             ///< call-stack entry of this node
+    u32_t parent;                     ///< node below this one
+    u32_t depth;                      ///< number of entries up to this node
+    const llvm::Instruction *bottom;  ///< instruction of the bottom entry
+  };
+  typedef std::vector<CallStrNode> CallStrNodeVec;
+  typedef std::map<std::pair<u32_t, CallSwitchPair>, u32_t> CallStrInternMap;
   // [OS-CFI] set of origin sensitive tuples maps to sink
-  typedef std::map<NodeID, OriginSensitiveTupleSet *>
+  typedef llvm::DenseMap<NodeID, OriginSensitiveTupleSet *>
       SinkToOriginSensitiveTupleSetMap;
-  typedef std::map<NodeID, OriginSensitiveTupleSet *>::iterator
+  typedef typename SinkToOriginSensitiveTupleSetMap::iterator
       SinkToOriginSensitiveTupleSetMapIt;
   // [OS-CFI] set of call stack maps to sink
-  typedef std::map<NodeID, CallStackSet *> SinkToCallStackMap;
-  typedef std::map<NodeID, CallStackSet *>::iterator SinkToCallStackMapIt;
+  typedef llvm::DenseMap<NodeID, CallStackSet *> SinkToCallStackMap;
+  typedef typename SinkToCallStackMap::iterator SinkToCallStackMapIt;
   // [OS-CFI] ToDo
-  typedef std::map<NodeID, const SVFGNode *> NodeToSVFGMap;
-  typedef std::map<NodeID, const SVFGNode *>::iterator NodeToSVFGMapIt;
+  typedef llvm::DenseMap<NodeID, const SVFGNode *> NodeToSVFGMap;
+  typedef typename NodeToSVFGMap::iterator NodeToSVFGMapIt;
+  // [OS-CFI] origin tuples a dpm produced in an earlier query, they are a
+  // function of the origin store and contexts the dpm was reached with and
+  // do not depend on the call-stack
+  typedef std::vector<OriginSensitiveTuple> OriginTupleLog;
+  struct OriginLog {
+    OriginTupleLog tuples; ///< tuples of a query in the order produced
+    u32_t refs;            ///< sub-results that point into the tuples
+  };
+  typedef std::map<u32_t, OriginLog> QueryToOriginLogMap;
+  struct OriginSubResult {
+    const StoreSVFGNode *store; ///< origin store the dpm was reached with
+    OriginContextSetPtr ctxs;   ///< origin contexts the dpm was reached with
+    u32_t log;                  ///< query whose log holds the tuples, 0 if none
+    u32_t begin;                ///< first tuple in the log
+    u32_t end;                  ///< one past the last tuple in the log
+  };
+  typedef std::map<DPIm, OriginSubResult> DPMToOriginSubResultMap;
+  // [OS-CFI] query slice typedef
+  typedef std::map<DPIm, NodeID> DPMToQueryMap;
+  typedef std::map<NodeID, NodeBS> QueryToSliceMap;
+  // [OS-CFI] memory governor typedef, a spilled dpm is kept as the offset and
+  // the number of its words in the spill file
+  typedef std::map<DPIm, u32_t> DPMToEpochMap;
+  typedef std::map<DPIm, std::pair<u64_t, u64_t>> DPMToSpillMap;
 
   /// Constructor
   DDAVFSolver()
-      : outOfBudgetQuery(false), _pag(NULL), _svfg(NULL), _ander(NULL),
-        _callGraph(NULL), _callGraphSCC(NULL), _svfgSCC(NULL), ddaStat(NULL) {}
+      : outOfBudgetQuery(false), incompleteSlice(false), queryTimeout(-1),
+        _pag(NULL), _svfg(NULL), _ander(NULL), _callGraph(NULL),
+        _callGraphSCC(NULL), _svfgSCC(NULL), ddaStat(NULL), svfgSnapshot(NULL),
+        memGovernor(NULL), queryEpoch(0), curCallStr(0), curOriginLog(0) {
+    CallStrNode root = {CallSwitchPair(0, nullptr), 0, 0, nullptr};
+    callStrNodes.push_back(root);
+  }
   /// Destructor
   virtual ~DDAVFSolver() {
     if (_ander != NULL) {
@@ -71,6 +118,11 @@ public:
 
     if (_svfgSCC != NULL)
       delete _svfgSCC;
+
+    if (svfgSnapshot != NULL)
+      delete svfgSnapshot;
+    if (memGovernor != NULL)
+      delete memGovernor;
     _svfgSCC = NULL;
 
     _callGraph = NULL;
@@ -114,19 +166,83 @@ public:
     CallStackSet *setCSen = new CallStackSet();
     mapSOrgSenTupSet[curCandidate] = setOSen;
     mapCSSen[curCandidate] = setCSen;
+    startOriginLog();
+  }
+
+  // [OS-CFI] setCandidateResult(): adopt a candidate that was solved by a
+  // query worker, the solver takes ownership of both sets
+  virtual inline void setCandidateResult(NodeID id, const SVFGNode *node,
+                                         OriginSensitiveTupleSet *setOSen,
+                                         CallStackSet *setCSen) {
+    candidateSVFG[id] = node;
+    mapSOrgSenTupSet[id] = setOSen;
+    mapCSSen[id] = setCSen;
+  }
+
+  // [OS-CFI] getQuerySlice(): return the SVFG nodes a finished query depends
+  // on, false if its answer also depends on the whole-program pre-analysis
+  inline bool getQuerySlice(NodeID id, NodeBS &slice) const {
+    typename QueryToSliceMap::const_iterator it = querySlices.find(id);
+    if (it == querySlices.end() || incompleteSlices.test(id))
+      return false;
+    slice |= it->second;
+    return true;
   }
 
+  // [OS-CFI] setQuerySlice(): adopt the slice of a query solved by a worker
+  inline void setQuerySlice(NodeID id, const NodeBS &slice, bool complete) {
+    querySlices[id] |= slice;
+    if (!complete)
+      incompleteSlices.set(id);
+  }
+
+  // [OS-CFI] resetCandidateResult(): forget the origin sensitive tuples,
+  // call-site stacks and slice of a candidate before it is solved again
+  inline void resetCandidateResult(NodeID id) {
+    typename SinkToOriginSensitiveTupleSetMap::iterator oit =
+        mapSOrgSenTupSet.find(id);
+    if (oit != mapSOrgSenTupSet.end()) {
+      delete oit->second;
+      mapSOrgSenTupSet.erase(oit);
+    }
+    typename SinkToCallStackMap::iterator cit = mapCSSen.find(id);
+    if (cit != mapCSSen.end()) {
+      delete cit->second;
+      mapCSSen.erase(cit);
+    }
+    querySlices.erase(id);
+    incompleteSlices.reset(id);
+  }
+
+  // [OS-CFI] resetPass(): drop the dpms cached by earlier queries, they were
+  // computed under another context limit
+  inline void resetPass() {
+    backwardVisited.clear();
+    dpmToTLCPtSetMap.clear();
+    dpmToADCPtSetMap.clear();
+    outOfBudgetDpms.clear();
+    storeToDPMs.clear();
+    clearOriginSubResults();
+    dpmToSliceQuery.clear();
+    dpmLastUse.clear();
+    spilledDpms.clear();
+    if (memGovernor)
+      memGovernor->discardAll();
+  }
+
+  // [OS-CFI] setQueryTimeout(): wall-clock limit of the next queries in
+  // seconds, a negative timeout lifts the limit
+  inline void setQueryTimeout(double seconds) { queryTimeout = seconds; }
+
   // [OS-CFI] dumpCallStack(): print the current call-stack
   void dumpCallStack() {
     if (DEBUG_DETAILS) {
       llvm::outs() << "***************[OS-CFI] CALL STACK ("
-                   << setCallStack.size() << ") [OS-CFI]********************\n";
-      CallSwitchPairStack curStack(setCallStack);
-      while (!curStack.empty()) {
-        if (curStack.top().second)
-          llvm::outs() << curStack.top().first << " => "
-                       << *(curStack.top().second) << "\n";
-        curStack.pop();
+                   << getCallStackSize() << ") [OS-CFI]********************\n";
+      for (u32_t cur = curCallStr; cur != 0; cur = callStrNodes[cur].parent) {
+        const CallSwitchPair &entry = callStrNodes[cur].entry;
+        if (entry.second)
+          llvm::outs() << entry.first << " => " << *(entry.second) << "\n";
       }
       llvm::outs()
           << "**********************************************************"
@@ -134,37 +250,47 @@ public:
     }
   }
 
-  // [OS-CFI] clearCallStack(): clear the current call-stack
-  void clearCallStack() {
-    while (!setCallStack.empty()) {
-      setCallStack.pop();
+  /// [OS-CFI] Current call-stack
+  //@{
+  inline bool isCallStackEmpty() const { return curCallStr == 0; }
+  inline u32_t getCallStackSize() const {
+    return callStrNodes[curCallStr].depth;
+  }
+  inline const CallSwitchPair &topCallStack() const {
+    return callStrNodes[curCallStr].entry;
+  }
+  inline void popCallStack() { curCallStr = callStrNodes[curCallStr].parent; }
+  inline void pushCallStack(const CallSwitchPair &entry) {
+    std::pair<typename CallStrInternMap::iterator, bool> it =
+        callStrIds.insert(std::make_pair(std::make_pair(curCallStr, entry),
+                                         (u32_t)callStrNodes.size()));
+    if (it.second) {
+      const CallStrNode &top = callStrNodes[curCallStr];
+      CallStrNode node = {entry, curCallStr, top.depth + 1,
+                          curCallStr == 0 ? entry.second : top.bottom};
+      callStrNodes.push_back(node);
     }
+    curCallStr = it.first->second;
   }
+  //@}
+
+  // [OS-CFI] clearCallStack(): clear the current call-stack
+  void clearCallStack() { curCallStr = 0; }
 
   // [OS-CFI] isOriginCtxInCallStack(): return true if checked origin context is
-  // in the current call-stack
+  // the bottom entry of the current call-stack
   bool isOriginCtxInCallStack(const llvm::Instruction *originCtx) {
-    const llvm::Instruction *topInst = nullptr;
-    CallSwitchPairStack curStack(setCallStack);
-    while (!curStack.empty()) {
-      topInst = curStack.top().second;
-      curStack.pop();
-    }
-    if (topInst == originCtx) {
-      return true;
-    }
-    return false;
+    return callStrNodes[curCallStr].bottom == originCtx;
   }
 
   // [OS-CFI] createCSEntry(): will create a new call-site sensitive CFG entry
   // using the current call-stack but in reverse order
   void createCSEntry(NodeID id) {
-    CallSwitchPairStack curStack(setCallStack);
+    if (!csEntryCreated.insert(std::make_pair(id, curCallStr)).second)
+      return;
     CallSwitchPairStack tmp;
-    while (!curStack.empty()) {
-      tmp.push(curStack.top());
-      curStack.pop();
-    }
+    for (u32_t cur = curCallStr; cur != 0; cur = callStrNodes[cur].parent)
+      tmp.push(callStrNodes[cur].entry);
     mapCSSen[getCurCandidate()]->insert(std::make_pair(id, tmp));
   }
 
@@ -185,9 +311,11 @@ public:
         }
       }
 
-      if (mapTOrgCtx.count(dpm.getLoc()->getId()) > 0) {
-        for (InstructionSetIt it = mapTOrgCtx[dpm.getLoc()->getId()].begin();
-             it != mapTOrgCtx[dpm.getLoc()->getId()].end(); it++) {
+      const OriginContextSetPtr *ctxs = mapTOrgCtx.find(dpm.getLoc()->getId());
+      if (ctxs) {
+        const InstructionSet &orgCtxs = **ctxs;
+        for (InstructionSet::const_iterator it = orgCtxs.begin();
+             it != orgCtxs.end(); it++) {
           if (*it != nullptr) {
             if (DEBUG_SOLVER) {
               llvm::outs() << "[OS-CFI] mapSOrgSenTupSet[" << getCurCandidate()
@@ -195,13 +323,13 @@ public:
                            << dpm.getLoc()->getId() << "], " << **it << "]"
                            << ">\n";
             }
-            mapSOrgSenTupSet[getCurCandidate()]->insert(std::make_tuple(
+            addOriginTuple(std::make_tuple(
                 srcID, mapNodeStore[dpm.getLoc()->getId()], *it));
             if (flag && isOriginCtxInCallStack(*it)) {
               createCSEntry(srcID);
             }
           } else {
-            mapSOrgSenTupSet[getCurCandidate()]->insert(std::make_tuple(
+            addOriginTuple(std::make_tuple(
                 srcID, mapNodeStore[dpm.getLoc()->getId()], nullptr));
             if (DEBUG_SOLVER) {
               llvm::outs() << "[OS-CFI] mapSOrgSenTupSet[" << getCurCandidate()
@@ -213,7 +341,7 @@ public:
           }
         }
       } else {
-        mapSOrgSenTupSet[getCurCandidate()]->insert(std::make_tuple(
+        addOriginTuple(std::make_tuple(
             srcID, mapNodeStore[dpm.getLoc()->getId()], nullptr));
         if (DEBUG_SOLVER) {
           llvm::outs() << "[OS-CFI] mapSOrgSenTupSet[" << getCurCandidate()
@@ -234,16 +362,20 @@ public:
   /// Compute points-to
   virtual const CPtSet &findPT(const DPIm &dpm) {
 
-    if (isbkVisited(dpm)) {
+    touchDpm(dpm);
+    if (isbkVisited(dpm) || restoreDpm(dpm)) {
       const CPtSet &cpts = getCachedPointsTo(dpm);
       DBOUT(DDDA, llvm::outs() << "\t already backward visited dpm: ");
       DBOUT(DDDA, dpm.dump());
       DBOUT(DDDA, llvm::outs() << "\t return points-to: ");
       DBOUT(DDDA, dumpCPtSet(cpts));
+      addSliceReuse(dpm);
       // [OS-CFI] ToDo
       const SVFGNode *node = dpm.getLoc();
       if (llvm::isa<AddrSVFGNode>(node)) {
         handleOSensitivity(dpm, llvm::cast<AddrSVFGNode>(node), true);
+      } else {
+        replayOriginSubResult(dpm);
       }
       return cpts;
     }
@@ -252,6 +384,8 @@ public:
     DBOUT(DDDA, dpm.dump());
     markbkVisited(dpm);
     addDpmToLoc(dpm);
+    addSliceLoc(dpm);
+    OriginSubResult originEntry = getOriginEntry(dpm);
 
     if (testOutOfBudget(dpm) == false) {
 
@@ -261,6 +395,7 @@ public:
       /// Add successors of current stmt if its pts has been changed.
       updateCachedPointsTo(dpm, pts);
     }
+    recordOriginSubResult(dpm, originEntry);
     return getCachedPointsTo(dpm);
   }
 
@@ -413,12 +548,11 @@ protected:
     }
 
     if (llvm::isa<IndirectSVFGEdge>(edge) &&
-        ((setCallStack.size() > 0 && setCallStack.top().second != nullptr) ||
-         setCallStack.size() == 0)) {
+        (isCallStackEmpty() || topCallStack().second != nullptr)) {
       if (srcFunc != dstFunc) {
-        setCallStack.push(std::make_pair(oldDpm.getLoc()->getId(), nullptr));
+        pushCallStack(CallSwitchPair(oldDpm.getLoc()->getId(), nullptr));
       } else if (!dstStmt) {
-        setCallStack.push(std::make_pair(oldDpm.getLoc()->getId(), nullptr));
+        pushCallStack(CallSwitchPair(oldDpm.getLoc()->getId(), nullptr));
       }
       dumpCallStack();
     }
@@ -460,9 +594,8 @@ protected:
           if (call) {
             orgCtxSet.insert(call);
             CallSwitchPair tmp = std::make_pair(oldDpm.getLoc()->getId(), call);
-            if (setCallStack.size() == 0 ||
-                (setCallStack.size() > 0 && setCallStack.top() != tmp)) {
-              setCallStack.push(tmp);
+            if (isCallStackEmpty() || topCallStack() != tmp) {
+              pushCallStack(tmp);
               dumpCallStack();
             }
           }
@@ -482,9 +615,8 @@ protected:
 
                 CallSwitchPair tmp =
                     std::make_pair(oldDpm.getLoc()->getId(), call);
-                if (setCallStack.size() == 0 ||
-                    (setCallStack.size() > 0 && setCallStack.top() != tmp)) {
-                  setCallStack.push(tmp);
+                if (isCallStackEmpty() || topCallStack() != tmp) {
+                  pushCallStack(tmp);
                   dumpCallStack();
                 }
               }
@@ -494,21 +626,25 @@ protected:
       }
     }
 
-    if (mapTOrgCtx.count(edge->getDstID()) > 0) {
-      mapTOrgCtx[edge->getSrcID()] = mapTOrgCtx[edge->getDstID()];
+    if (copyOriginContext(edge->getDstID(), edge->getSrcID())) {
       if (DEBUG_SOLVER) {
         llvm::outs() << "[OS-CFI] mapTOrgCtx[" << edge->getSrcID()
                      << "] = mapTOrgCtx[" << edge->getDstID() << "]\n";
       }
     } else {
       if (!orgCtxSet.empty()) {
+        // the shared set is immutable, extend a private copy of it
+        OriginContextSetPtr &srcCtxs = mapTOrgCtx[edge->getSrcID()];
+        InstructionSet *ctxs = srcCtxs ? new InstructionSet(*srcCtxs)
+                                       : new InstructionSet();
         for (InstructionSetIt orgCtxSetIt = orgCtxSet.begin();
              orgCtxSetIt != orgCtxSet.end(); orgCtxSetIt++) {
-          mapTOrgCtx[edge->getSrcID()].insert(*orgCtxSetIt);
+          ctxs->insert(*orgCtxSetIt);
           if (DEBUG_SOLVER)
             llvm::outs() << "[OS-CFI] mapTOrgCtx[" << edge->getSrcID()
                          << "] = " << **orgCtxSetIt << "\n";
         }
+        srcCtxs.reset(ctxs);
       }
     }
   }
@@ -598,9 +734,9 @@ protected:
       }
       NodeID obj = dpm.getCurNodeID();
       if (!(_pag->isConstantObj(obj) || _pag->isNonPointerObj(obj))) {
-        const SVFGEdgeSet edgeSet(node->getInEdges());
-        for (SVFGNode::const_iterator it = edgeSet.begin(), eit = edgeSet.end();
-             it != eit; ++it) {
+        SVFGSnapshot::SVFGEdgeVec liveEdges;
+        SVFGSnapshot::EdgeRange edges = getIndirectInEdges(node, liveEdges);
+        for (SVFGEdge *const *it = edges.first; it != edges.second; ++it) {
           if (const IndirectSVFGEdge *indirEdge =
                   llvm::dyn_cast<IndirectSVFGEdge>(*it)) {
             PointsTo &guard = const_cast<PointsTo &>(indirEdge->getPointsTo());
@@ -612,8 +748,7 @@ protected:
                   llvm::outs() << "[OS-CFI] mapNodeStore[" << srcNode->getId()
                                << "] = mapNodeStore[" << curNode << "]\n";
                 }
-                if (mapTOrgCtx.count(curNode) > 0) {
-                  mapTOrgCtx[srcNode->getId()] = mapTOrgCtx[curNode];
+                if (copyOriginContext(curNode, srcNode->getId())) {
                   if (DEBUG_SOLVER) {
                     llvm::outs() << "[OS-CFI] mapTOrgCtx[" << srcNode->getId()
                                  << "] = mapTOrgCtx[" << curNode << "]\n";
@@ -696,7 +831,35 @@ protected:
     _ander = AndersenWaveDiff::createAndersenWaveDiff(module);
     _svfg = svfgBuilder.buildSVFG(_ander, true);
     _pag = _svfg->getPAG();
+    // [OS-CFI] the per query maps are keyed by PAG and SVFG node ids
+    u32_t numOfIds = std::max<u32_t>(_pag->getTotalNodeNum(),
+                                     _svfg->getTotalNodeNum());
+    mapNodeStore.reserve(numOfIds);
+    mapTOrgCtx.reserve(numOfIds);
+    if (DDAMemGovernor::isEnabled())
+      memGovernor = new DDAMemGovernor();
+  }
+  /// [OS-CFI] Read SVFG in-edges from a frozen CSR snapshot from now on
+  inline void buildSVFGSnapshot() { svfgSnapshot = new SVFGSnapshot(_svfg); }
+  /// [OS-CFI] In-edges of a node, copied into liveEdges unless they are read
+  /// from the snapshot, so edges added while they are visited are not seen
+  //@{
+  inline SVFGSnapshot::EdgeRange
+  getDirectInEdges(const SVFGNode *node, SVFGSnapshot::SVFGEdgeVec &liveEdges) {
+    if (svfgSnapshot)
+      return svfgSnapshot->getDirectInEdges(node, liveEdges);
+    return SVFGSnapshot::collectInEdges(node, SVFGSnapshot::Direct,
+                                        SVFGSnapshot::Indirect, liveEdges);
+  }
+  inline SVFGSnapshot::EdgeRange
+  getIndirectInEdges(const SVFGNode *node,
+                     SVFGSnapshot::SVFGEdgeVec &liveEdges) {
+    if (svfgSnapshot)
+      return svfgSnapshot->getIndirectInEdges(node, liveEdges);
+    return SVFGSnapshot::collectInEdges(node, SVFGSnapshot::Indirect,
+                                        SVFGSnapshot::NumOfGroups, liveEdges);
   }
+  //@}
   /// Reset visited map for next points-to query
   virtual inline void resetQuery() {
     if (outOfBudgetQuery)
@@ -707,16 +870,245 @@ protected:
     loadToPTCVarMap.clear();
     outOfBudgetQuery = false;
     ddaStat->_NumOfStep = 0;
+    if (queryTimeout >= 0)
+      queryDeadline = std::chrono::steady_clock::now() +
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::duration<double>(queryTimeout));
 
     // [OS-CFI] reset data before every query
     mapNodeStore.clear();
     mapTOrgCtx.clear();
+    csEntryCreated.clear();
     // storeToDPMs.clear();
     // dpmToTLCPtSetMap.clear();
     // dpmToADCPtSetMap.clear();
     // backwardVisited.clear();
     clearCallStack();
+    curSlice.clear();
+    incompleteSlice = false;
+    governCaches();
   }
+  /// [OS-CFI] Memory governor of the dpm caches. Dpms are only evicted
+  /// between queries, so a dpm on the path of the running query stays put
+  //@{
+  inline void touchDpm(const DPIm &dpm) {
+    if (memGovernor)
+      dpmLastUse[dpm] = queryEpoch;
+  }
+  /// Evict the least recently used dpms once the governor limits the caches
+  void governCaches() {
+    queryEpoch++;
+    u32_t limit = 0;
+    if (memGovernor && memGovernor->needsCompaction())
+      compactSpill();
+    if (memGovernor == NULL ||
+        !memGovernor->getCacheLimit(dpmLastUse.size(), limit))
+      return;
+    std::vector<std::pair<u32_t, DPIm>> byAge;
+    byAge.reserve(dpmLastUse.size());
+    for (typename DPMToEpochMap::iterator it = dpmLastUse.begin(),
+                                          eit = dpmLastUse.end();
+         it != eit; ++it)
+      byAge.push_back(std::make_pair(it->second, it->first));
+    u32_t numOfEvicted = byAge.size() - limit;
+    std::nth_element(byAge.begin(), byAge.begin() + numOfEvicted, byAge.end());
+    for (u32_t i = 0; i < numOfEvicted; i++)
+      evictDpm(byAge[i].second);
+    memGovernor->release();
+  }
+  /// The points-to set of a dpm is spilled if it was solved, its origin
+  /// tuples stay in memory since they are small next to it. An unsolved or
+  /// dropped dpm is solved again from scratch
+  void evictDpm(const DPIm &dpm) {
+    bool spilled = false;
+    if (memGovernor->isSpilling() && isbkVisited(dpm)) {
+      DDAMemGovernor::Words words;
+      DDAMemGovernor::encode(getCachedPointsTo(dpm), words);
+      u64_t offset = 0;
+      if (memGovernor->spill(words, offset)) {
+        spilledDpms[dpm] = std::make_pair(offset, (u64_t)words.size());
+        spilled = true;
+        DOSTAT(ddaStat->_NumOfSpilledDPM++);
+      }
+    }
+    if (isTopLevelPtrStmt(dpm.getLoc()))
+      dpmToTLCPtSetMap.erase(dpm);
+    else
+      dpmToADCPtSetMap.erase(dpm);
+    backwardVisited.erase(dpm);
+    if (!spilled) {
+      outOfBudgetDpms.erase(dpm);
+      eraseOriginSubResult(dpm);
+    }
+    dpmLastUse.erase(dpm);
+    DOSTAT(ddaStat->_NumOfEvictedDPM++);
+  }
+  /// Rewrite the spill file with the entries not read back yet
+  void compactSpill() {
+    std::vector<DDAMemGovernor::Entry *> entries;
+    entries.reserve(spilledDpms.size());
+    for (typename DPMToSpillMap::iterator it = spilledDpms.begin(),
+                                          eit = spilledDpms.end();
+         it != eit; ++it)
+      entries.push_back(&it->second);
+    memGovernor->compact(entries);
+  }
+  /// Read a spilled dpm back into its cache, false if it was not spilled
+  bool restoreDpm(const DPIm &dpm) {
+    typename DPMToSpillMap::iterator it = spilledDpms.find(dpm);
+    if (it == spilledDpms.end())
+      return false;
+    u64_t num = it->second.second;
+    const u64_t *words = memGovernor->load(it->second.first, num);
+    spilledDpms.erase(it);
+    memGovernor->discard(num);
+    CPtSet &pts = getCachedPointsTo(dpm);
+    if (words == NULL || !DDAMemGovernor::decode(words, num, pts)) {
+      pts.clear();
+      outOfBudgetDpms.erase(dpm);
+      eraseOriginSubResult(dpm);
+      return false;
+    }
+    markbkVisited(dpm);
+    DOSTAT(ddaStat->_NumOfRestoredDPM++);
+    return true;
+  }
+  //@}
+  /// [OS-CFI] copyOriginContext(): let dst share the origin contexts of src,
+  /// return false if src has none
+  inline bool copyOriginContext(NodeID src, NodeID dst) {
+    const OriginContextSetPtr *ctxs = mapTOrgCtx.find(src);
+    if (!ctxs)
+      return false;
+    mapTOrgCtx[dst] = *ctxs;
+    return true;
+  }
+  /// [OS-CFI] Query slices
+  //@{
+  /// Record a SVFG node traversed by the current query
+  inline void addSliceLoc(const DPIm &dpm) {
+    curSlice.set(dpm.getLoc()->getId());
+    dpmToSliceQuery.insert(std::make_pair(dpm, getCurCandidate()));
+  }
+  /// A dpm cached by an earlier query is reused, so the current query also
+  /// depends on the slice of that query
+  inline void addSliceReuse(const DPIm &dpm) {
+    curSlice.set(dpm.getLoc()->getId());
+    typename DPMToQueryMap::const_iterator it = dpmToSliceQuery.find(dpm);
+    if (it == dpmToSliceQuery.end() || it->second == getCurCandidate())
+      return;
+    typename QueryToSliceMap::const_iterator sit =
+        querySlices.find(it->second);
+    if (sit != querySlices.end())
+      curSlice |= sit->second;
+    if (incompleteSlices.test(it->second))
+      incompleteSlice = true;
+  }
+  /// The current answer is not derived from SVFG nodes alone
+  inline void markSliceIncomplete() { incompleteSlice = true; }
+  //@}
+  /// [OS-CFI] Cross-query origin sub-results
+  //@{
+  /// Start the log of a new query. The log of the finished query is kept
+  /// only while a cached sub-result points into it.
+  inline void startOriginLog() {
+    releaseOriginLog(curOriginLog);
+    curOriginLog++;
+    OriginLog log = {OriginTupleLog(), 0};
+    originLogs[curOriginLog] = log;
+  }
+  /// Drop a log that is not the current one and no sub-result points into
+  inline void releaseOriginLog(u32_t id) {
+    typename QueryToOriginLogMap::iterator it = originLogs.find(id);
+    if (it != originLogs.end() && it->second.refs == 0 && id != curOriginLog)
+      originLogs.erase(it);
+  }
+  /// Forget the sub-result of a dpm, its log may go with it
+  inline void eraseOriginSubResult(const DPIm &dpm) {
+    typename DPMToOriginSubResultMap::iterator it = originSubResults.find(dpm);
+    if (it == originSubResults.end())
+      return;
+    u32_t id = it->second.log;
+    originSubResults.erase(it);
+    if (id == 0)
+      return;
+    originLogs[id].refs--;
+    releaseOriginLog(id);
+  }
+  /// Forget all sub-results and the logs of finished queries
+  inline void clearOriginSubResults() {
+    originSubResults.clear();
+    for (typename QueryToOriginLogMap::iterator it = originLogs.begin();
+         it != originLogs.end();) {
+      if (it->first == curOriginLog) {
+        it->second.refs = 0;
+        ++it;
+      } else
+        originLogs.erase(it++);
+    }
+  }
+  /// Add an origin sensitive tuple to the current candidate. Every tuple is
+  /// logged, also one the candidate already has: each dpm being traversed
+  /// needs all the tuples it produces, not only the first ones
+  inline void addOriginTuple(const OriginSensitiveTuple &tuple) {
+    mapSOrgSenTupSet[getCurCandidate()]->insert(tuple);
+    if (curOriginLog != 0)
+      originLogs[curOriginLog].tuples.push_back(tuple);
+  }
+  /// Origin store and contexts at the location of a dpm
+  inline OriginSubResult getOriginEntry(const DPIm &dpm) {
+    NodeID loc = dpm.getLoc()->getId();
+    const StoreSVFGNode *const *store = mapNodeStore.find(loc);
+    const OriginContextSetPtr *ctxs = mapTOrgCtx.find(loc);
+    OriginSubResult entry = {store ? *store : NULL,
+                             ctxs ? *ctxs : OriginContextSetPtr(),
+                             curOriginLog, 0, 0};
+    if (curOriginLog != 0)
+      entry.begin = originLogs[curOriginLog].tuples.size();
+    return entry;
+  }
+  /// Remember the tuples logged since entry was taken. A dpm without tuples
+  /// is remembered too, it keeps no log alive
+  inline void recordOriginSubResult(const DPIm &dpm, OriginSubResult &entry) {
+    if (entry.log == 0 || entry.log != curOriginLog)
+      return;
+    entry.end = originLogs[entry.log].tuples.size();
+    eraseOriginSubResult(dpm);
+    if (entry.end == entry.begin) {
+      entry.log = 0;
+      entry.begin = entry.end = 0;
+    } else {
+      originLogs[entry.log].refs++;
+    }
+    originSubResults[dpm] = entry;
+  }
+  /// A cached dpm is reached with the same origin store and contexts again,
+  /// so it adds the same tuples. In the query that computed it the tuples
+  /// are logged again for the dpms that enclose this visit
+  inline void replayOriginSubResult(const DPIm &dpm) {
+    typename DPMToOriginSubResultMap::const_iterator it =
+        originSubResults.find(dpm);
+    if (it == originSubResults.end() || it->second.log == 0)
+      return;
+    const OriginSubResult &sub = it->second;
+    OriginSubResult entry = getOriginEntry(dpm);
+    if (entry.store != sub.store ||
+        !(entry.ctxs == sub.ctxs ||
+          (entry.ctxs && sub.ctxs && *entry.ctxs == *sub.ctxs)))
+      return;
+    const OriginTupleLog &log = originLogs[sub.log].tuples;
+    for (u32_t i = sub.begin; i < sub.end; i++) {
+      OriginSensitiveTuple tuple = log[i];
+      addOriginTuple(tuple);
+    }
+  }
+  /// Close the slice of the current query
+  inline void finishQuerySlice() {
+    querySlices[getCurCandidate()] |= curSlice;
+    if (incompleteSlice)
+      incompleteSlices.set(getCurCandidate());
+  }
+  //@}
   /// Reset visited map if the current query is out-of-budget
   inline void OOBResetVisited() {
     for (typename LocToDPMVecMap::const_iterator it = locToDpmSetMap.begin(),
@@ -742,9 +1134,9 @@ protected:
     NodeID obj = oldDpm.getCurNodeID();
     if (_pag->isConstantObj(obj) || _pag->isNonPointerObj(obj))
       return;
-    const SVFGEdgeSet edgeSet(node->getInEdges());
-    for (SVFGNode::const_iterator it = edgeSet.begin(), eit = edgeSet.end();
-         it != eit; ++it) {
+    SVFGSnapshot::SVFGEdgeVec liveEdges;
+    SVFGSnapshot::EdgeRange edges = getIndirectInEdges(node, liveEdges);
+    for (SVFGEdge *const *it = edges.first; it != edges.second; ++it) {
       if (const IndirectSVFGEdge *indirEdge =
               llvm::dyn_cast<IndirectSVFGEdge>(*it)) {
         PointsTo &guard = const_cast<PointsTo &>(indirEdge->getPointsTo());
@@ -759,10 +1151,9 @@ protected:
 
           backwardPropDpm(pts, oldDpm.getCurNodeID(), oldDpm, indirEdge);
 
-          if (setCallStack.size() > 0 &&
-              setCallStack.top().first == oldDpm.getLoc()->getId()) {
-            CallSwitchPair tmp = setCallStack.top();
-            setCallStack.pop();
+          if (!isCallStackEmpty() &&
+              topCallStack().first == oldDpm.getLoc()->getId()) {
+            popCallStack();
             dumpCallStack();
           }
         }
@@ -773,9 +1164,9 @@ protected:
   /// Backward traverse along direct value flows
   void backtraceAlongDirectVF(CPtSet &pts, const DPIm &oldDpm) {
     const SVFGNode *node = oldDpm.getLoc();
-    const SVFGEdgeSet edgeSet(node->getInEdges());
-    for (SVFGNode::const_iterator it = edgeSet.begin(), eit = edgeSet.end();
-         it != eit; ++it) {
+    SVFGSnapshot::SVFGEdgeVec liveEdges;
+    SVFGSnapshot::EdgeRange edges = getDirectInEdges(node, liveEdges);
+    for (SVFGEdge *const *it = edges.first; it != edges.second; ++it) {
       if (const DirectSVFGEdge *dirEdge = llvm::dyn_cast<DirectSVFGEdge>(*it)) {
         DBOUT(DDDA, llvm::outs() << "\t\t==backtrace directVF svfgNode "
                                  << dirEdge->getDstID() << " --> "
@@ -786,10 +1177,9 @@ protected:
 
         backwardPropDpm(pts, getSVFG()->getLHSTopLevPtr(srcNode)->getId(),
                         oldDpm, dirEdge);
-        if (setCallStack.size() > 0 &&
-            setCallStack.top().first == oldDpm.getLoc()->getId()) {
-          CallSwitchPair tmp = setCallStack.top();
-          setCallStack.pop();
+        if (!isCallStackEmpty() &&
+            topCallStack().first == oldDpm.getLoc()->getId()) {
+          popCallStack();
           dumpCallStack();
         }
       }
@@ -815,8 +1205,7 @@ protected:
       }
     }
 
-    if (mapTOrgCtx.count(loadSrc->getId()) > 0) {
-      mapTOrgCtx[load->getId()] = mapTOrgCtx[loadSrc->getId()];
+    if (copyOriginContext(loadSrc->getId(), load->getId())) {
       if (DEBUG_SOLVER)
         llvm::outs() << "[oCFG] mapTOrgCtx[" << load->getId()
                      << "] = mapTOrgCtx[" << loadSrc->getId() << "]\n";
@@ -843,8 +1232,7 @@ protected:
                      << "] = mapNodeStore[" << storeDst->getId() << "]\n";
     }
 
-    if (mapTOrgCtx.count(storeDst->getId()) > 0) {
-      mapTOrgCtx[store->getId()] = mapTOrgCtx[storeDst->getId()];
+    if (copyOriginContext(storeDst->getId(), store->getId())) {
       if (DEBUG_SOLVER)
         llvm::outs() << "[oCFG] <OriginContext> mapTOrgCtx[" << store->getId()
                      << "] = mapTOrgCtx[" << storeDst->getId() << "]\n";
@@ -885,8 +1273,7 @@ protected:
       }
     }
 
-    if (mapTOrgCtx.count(store->getId()) > 0) {
-      mapTOrgCtx[storeSrc->getId()] = mapTOrgCtx[store->getId()];
+    if (copyOriginContext(store->getId(), storeSrc->getId())) {
       if (DEBUG_SOLVER)
         llvm::outs() << "[oCFG] mapTOrgCtx[" << storeSrc->getId()
                      << "] = mapTOrgCtx[" << store->getId() << "]\n";
@@ -1184,6 +1571,10 @@ protected:
       return true;
     if (++ddaStat->_NumOfStep > DPIm::getMaxBudget())
       outOfBudgetQuery = true;
+    // [OS-CFI] the clock is only read every 1024 steps
+    else if (queryTimeout >= 0 && (ddaStat->_NumOfStep & 1023) == 0 &&
+             std::chrono::steady_clock::now() > queryDeadline)
+      outOfBudgetQuery = true;
     return isOutOfBudgetDpm(dpm) || outOfBudgetQuery;
   }
   inline bool isOutOfBudgetQuery() const { return outOfBudgetQuery; }
@@ -1218,6 +1609,9 @@ protected:
   }
 
   bool outOfBudgetQuery;    ///< Whether the current query is out of step limits
+  bool incompleteSlice;     // [OS-CFI] current answer leaves the SVFG slice
+  double queryTimeout;      // [OS-CFI] seconds per query, negative if none
+  std::chrono::steady_clock::time_point queryDeadline; // [OS-CFI] of a query
   PAG *_pag;                ///< PAG
   SVFG *_svfg;              ///< SVFG
   AndersenWaveDiff *_ander; ///< Andersen's analysis
@@ -1240,13 +1634,28 @@ protected:
                                  ///< stong updated there
   DDAStat *ddaStat;              ///< DDA stat
   SVFGBuilder svfgBuilder;       ///< SVFG Builder
+  SVFGSnapshot *svfgSnapshot;    // [OS-CFI] frozen SVFG in-edges, optional
+  DDAMemGovernor *memGovernor;   // [OS-CFI] bounds the dpm caches, optional
+  DPMToEpochMap dpmLastUse;      // [OS-CFI] query that last used a dpm
+  DPMToSpillMap spilledDpms;     // [OS-CFI] dpms evicted to the spill file
+  u32_t queryEpoch;              // [OS-CFI] queries solved so far
   NodeID curCandidate;           // [OS-CFI] hold current candidate node id
   NodeToStoreMap mapNodeStore;   // [OS-CFI] ToDo
   TargetToOriginContextMap mapTOrgCtx;               // [OS-CFI] ToDo
   SinkToOriginSensitiveTupleSetMap mapSOrgSenTupSet; // [OS-CFI] ToDo
-  CallSwitchPairStack setCallStack;                  // [OS-CFI] ToDo
+  CallStrNodeVec callStrNodes;                       // [OS-CFI] call strings
+  CallStrInternMap callStrIds;                       // [OS-CFI] interned ids
+  u32_t curCallStr;                                  // [OS-CFI] call-stack
+  std::set<std::pair<NodeID, u32_t>> csEntryCreated; // [OS-CFI] emitted stacks
   SinkToCallStackMap mapCSSen;                       // [OS-CFI] ToDo
   NodeToSVFGMap candidateSVFG;                       // [OS-CFI] ToDo
+  QueryToOriginLogMap originLogs; // [OS-CFI] new tuples of recent queries
+  u32_t curOriginLog;             // [OS-CFI] log of the current query
+  DPMToOriginSubResultMap originSubResults; // [OS-CFI] tuples of every dpm
+  NodeBS curSlice;                  // [OS-CFI] SVFG slice of current query
+  DPMToQueryMap dpmToSliceQuery;    // [OS-CFI] query that computed a dpm
+  QueryToSliceMap querySlices;      // [OS-CFI] slice of every finished query
+  NodeBS incompleteSlices;          // [OS-CFI] queries that left their slice
 };
 
 #endif /* VALUEFLOWDDA_H_ */
@@ -0,0 +1,56 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef ECSELECTOR_H_
+#define ECSELECTOR_H_
+
+#include "DDA/CFGStream.h"
+#include <unordered_map>
+
+/*!
+ * [OS-CFI] Selection of the CFG policy of every indirect call-site (ICT).
+ *
+ * The streamed CFG entries are grouped by ICT once. An equivalence class
+ * (EC) is the set of targets an ICT may reach under one key: its target type
+ * for CI, the origin and origin context for OS, the call-site context for
+ * CS. The policy whose ECs of the ICT are the smallest on average wins; CI
+ * wins ties, then CS. The tables of the chosen policies are written in the
+ * text layout INSTCFG reads.
+ */
+class ECSelector {
+public:
+  typedef enum { CI = 1, OS = 2, CS = 3 } Policy;
+  typedef std::set<u64_t> TargetSet;
+  typedef std::pair<u32_t, std::vector<u64_t>> ECKey;
+  typedef std::map<ECKey, TargetSet> KeyToECMap;
+  typedef std::map<u32_t, TargetSet> TypeToECMap;
+  typedef std::map<u32_t, Policy> TypeToPolicyMap;
+
+  /// ECs of an ICT, the OS and CS keys start with the target type
+  struct ICTClasses {
+    TypeToECMap ciECs;
+    KeyToECMap osECs;
+    KeyToECMap csECs;
+    TypeToPolicyMap policies;
+  };
+  typedef std::unordered_map<u64_t, ICTClasses> ICTToClassesMap;
+
+  /// Group a streamed entry, SUPA entries are not used by any policy
+  void add(const CFGRecord &rec);
+  /// Pick the policy of every ICT and target type with a CI EC
+  void select();
+  /// Write the tables of the chosen policies into a directory
+  bool write(const std::string &dir) const;
+  /// Print the number of ICTs per policy and the EC size distributions
+  void printSummary(llvm::raw_ostream &os) const;
+
+private:
+  static double getAvgECSize(const KeyToECMap &ecs);
+  std::vector<u64_t> getSortedICTs() const;
+
+  ICTToClassesMap icts; ///< ECs grouped by ICT
+};
+
+#endif /* ECSELECTOR_H_ */
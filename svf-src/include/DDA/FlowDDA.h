@@ -36,6 +36,9 @@ public:
   /// Compute points-to set for all top variable
   void computeDDAPts(NodeID id);
 
+  /// [OS-CFI] Step budget of a flow-sensitive query
+  static u64_t getFlowBudget();
+
   /// Handle out-of-budget dpm
   void handleOutOfBudgetDpm(const LocDPItem &dpm);
 
@@ -50,6 +53,8 @@ public:
   inline virtual void initialize(SVFModule module) {
     BVDataPTAImpl::initialize(module);
     buildSVFG(module);
+    if (SVFGSnapshot::isSelected(getAnalysisTy()))
+      buildSVFGSnapshot();
     setCallGraph(getPTACallGraph());
     setCallGraphSCC(getCallGraphSCC());
     stat = setDDAStat(new DDAStat(this));
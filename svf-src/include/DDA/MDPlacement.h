@@ -0,0 +1,66 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef MDPLACEMENT_H_
+#define MDPLACEMENT_H_
+
+#include "MemoryModel/PointerAnalysis.h"
+#include "Util/SVFModule.h"
+
+/*!
+ * [OS-CFI] Placement of the origin metadata of function pointers.
+ *
+ * The metadata of a pointer is written by update_mpx_table under an origin
+ * id and read by the reference monitors under a call-point id, both keyed by
+ * the address the pointer is stored at. An object is non-local when it is
+ * reachable from a global, from the argument of a thread fork or from the
+ * argument of an unknown external function. The metadata of an origin or a
+ * call-point only goes to the per-thread store when every object its
+ * addresses may point to is local; an object accessed through any id left
+ * shared is shared as well, so both sides of a pointer always use the same
+ * store. The objects on both sides of an oscfi_memcpy, oscfi_memmove or
+ * oscfi_realloc are placed together too, so the runtime moves the metadata
+ * of a copied pointer within the store it finds it in.
+ */
+class MDPlacement {
+public:
+  typedef enum { ORIGIN = 1, CALLPOINT = 2 } AccessKind;
+  typedef std::pair<u32_t, u64_t> AccessKey;
+  typedef std::map<AccessKey, PointsTo> AccessToPtsMap;
+  typedef std::set<AccessKey> AccessSet;
+
+  /// Constructor
+  MDPlacement(SVFModule m, PointerAnalysis *p)
+      : module(m), pta(p), pag(p->getPAG()), unknownAddr(false) {}
+
+  /// Classify the metadata accesses of the module
+  void classify();
+  /// Write the thread-local accesses, one "kind id" line each
+  bool write(const std::string &path) const;
+
+  inline u32_t getNumOfAccesses() const { return accesses.size(); }
+  inline u32_t getNumOfLocalAccesses() const { return localAccesses.size(); }
+
+private:
+  void collectAccesses();
+  void collectNonLocalObjs();
+  /// Points-to set of the address of an access, false if it is unknown
+  bool getAddrPts(const llvm::Value *addr, PointsTo &pts);
+  void addPts(const llvm::Value *val, PointsTo &objs);
+
+  SVFModule module;
+  PointerAnalysis *pta;
+  PAG *pag;
+  bool unknownAddr;        ///< an address has no PAG node
+  AccessToPtsMap accesses; ///< objects every id may access
+  PointsTo sharedObjs;     ///< objects accessed through a non-constant id
+  PointsTo nonLocalObjs;   ///< objects reachable by other threads
+  AccessSet localAccesses; ///< ids accessing thread-local objects only
+
+  /// objects each metadata copy moves between
+  std::vector<PointsTo> copies;
+};
+
+#endif /* MDPLACEMENT_H_ */
@@ -31,6 +31,7 @@
 #define MSSAMUCHI_H_
 
 #include "MSSA/MemRegion.h"
+#include <atomic>
 
 
 class MSSADEF;
@@ -44,7 +45,7 @@ public:
     typedef MSSADEF MSSADef;
 private:
     /// ver ID 0 is reserved
-    static Size_t totalVERNum;
+    static std::atomic<Size_t> totalVERNum;	///< [OS-CFI] shared by MSSA threads
     const MemRegion* mr;
     VERSION version;
     MRVERID vid;
@@ -381,6 +381,14 @@ public:
     /// Start generating memory regions
     virtual void generateMRs();
 
+    /// [OS-CFI] Store the regions and the region sets of functions, loads,
+    /// stores and call sites, a later run on the same pointer analysis results
+    /// reads them back instead of generating them
+    //@{
+    void writeToFile(const std::string& filename);
+    bool readFromFile(const std::string& filename);
+    //@}
+
     /// Get the function which PAG Edge located
     const llvm::Function* getFunction(const PAGEdge* pagEdge) const {
         PAGEdgeToFunMap::const_iterator it = pagEdgeToFunMap.find(pagEdge);
@@ -61,9 +61,17 @@ public:
     typedef MSSAPHI<Condition> PHI;
     typedef MSSADEF MDEF;
 
-    typedef std::set<MU*> MUSet;
-    typedef std::set<CHI*> CHISet;
-    typedef std::set<PHI*> PHISet;
+    /// [OS-CFI] mus/chis/phis of a set are ordered by their memory regions
+    /// rather than by the addresses the building threads allocated them at
+    template<class T>
+    struct MRIDLess {
+        inline bool operator()(const T* lhs, const T* rhs) const {
+            return lhs->getMR()->getMRID() < rhs->getMR()->getMRID();
+        }
+    };
+    typedef std::set<MU*, MRIDLess<MU> > MUSet;
+    typedef std::set<CHI*, MRIDLess<CHI> > CHISet;
+    typedef std::set<PHI*, MRIDLess<PHI> > PHISet;
 
     ///Define mem region set
     typedef MRGenerator::MRSet MRSet;
@@ -93,6 +101,9 @@ public:
     typedef llvm::DenseMap<const MemRegion*, std::vector<MRVer*> > MemRegToVerStackMap;
     typedef llvm::DenseMap<const MemRegion*, VERSION> MemRegToCounterMap;
 
+    /// Functions without a reachable return
+    typedef std::set<const llvm::Function*> FunctionSet;
+
     /// PAG edge list
     typedef PAG::PAGEdgeList PAGEdgeList;
 
@@ -110,6 +121,7 @@ protected:
     llvm::DominanceFrontier* df;
     llvm::DominatorTree* dt;
     MemSSAStat* stat;
+    MemSSA* parent;	///< [OS-CFI] the MemSSA a shard builds for, NULL if not a shard
 
     /// Create mu chi for candidate regions in a function
     virtual void createMUCHI(const llvm::Function& fun);
@@ -143,6 +155,21 @@ private:
     MRSet varKills;
     //@}
 
+    /// [OS-CFI] Parallel construction
+    ///@{
+    /// Functions without a reachable return, computed before the shards start
+    FunctionSet noRetFuns;
+    /// Phase times of a shard, handed to the statistics when it is released
+    double shardTimeOfCreateMUCHI;
+    double shardTimeOfInsertingPHI;
+    double shardTimeOfSSARenaming;
+    ///@}
+
+    /// Clock of the phase timers, the CPU time of its own thread for a shard
+    double getClk() const;
+    /// Whether a function does not have a reachable return
+    bool doesNotRet(const llvm::Function* fun) const;
+
     /// Release the memory
     void destroy();
 
@@ -277,6 +304,9 @@ private:
 public:
     /// Constructor
     MemSSA(BVDataPTAImpl* p);
+    /// [OS-CFI] Constructor of a shard building the memory SSA of some
+    /// functions in a thread of its own, it shares the regions of its parent
+    MemSSA(MemSSA* p);
 
     /// Destructor
     virtual ~MemSSA() {
@@ -297,6 +327,14 @@ public:
     /// We start from here
     virtual void buildMemSSA(const llvm::Function& fun,llvm::DominanceFrontier*, llvm::DominatorTree*);
 
+    /// [OS-CFI] Parallel construction
+    //@{
+    /// Look up everything the shards read but would otherwise create lazily
+    void prepareShards(const std::vector<const llvm::Function*>& funs);
+    /// Move the mus/chis/phis a shard built for a function into this MemSSA
+    void mergeShard(MemSSA* shard, const llvm::Function& fun);
+    //@}
+
     /// Perform statistics
     void performStat();
 
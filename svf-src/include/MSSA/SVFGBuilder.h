@@ -94,6 +94,8 @@ public:
 protected:
     /// We start from here
     virtual bool build(SVFG* graph,BVDataPTAImpl* pta);
+    /// [OS-CFI] Build memory SSA of the functions with -mssa-jobs threads
+    void buildMemSSAInParallel(MemSSA* mssa, BVDataPTAImpl* pta);
     /// Can be rewritten by subclasses
     virtual void createSVFG(MemSSA* mssa, SVFG* graph);
     /// Release global SVFG
@@ -0,0 +1,68 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef SVFGSNAPSHOT_H_
+#define SVFGSNAPSHOT_H_
+
+#include "MSSA/SVFG.h"
+
+/*!
+ * [OS-CFI] Frozen compressed-sparse-row copy of the SVFG in-edges.
+ *
+ * The in-edges of every node are stored contiguously, the direct edges
+ * before the indirect ones. Within a group the edges keep the order of the
+ * node's edge set, which is the order the solver visited them in when it
+ * filtered the set by edge kind. A node that gained or lost edges after the snapshot was taken is
+ * detected by its edge count and read from the SVFG instead.
+ */
+class SVFGSnapshot {
+public:
+    typedef std::vector<SVFGEdge*> SVFGEdgeVec;
+    typedef std::pair<SVFGEdge* const*, SVFGEdge* const*> EdgeRange;
+
+    /// Edge groups of a node, in storage order
+    enum EdgeGroup {
+        Direct,
+        Indirect,
+        NumOfGroups
+    };
+
+    /// Constructor, takes the snapshot
+    SVFGSnapshot(const SVFG* svfg);
+
+    /// In-edges of a node, scratch holds them if the node is no longer frozen
+    //@{
+    inline EdgeRange getDirectInEdges(const SVFGNode* node, SVFGEdgeVec& scratch) const {
+        return getInEdges(node, Direct, Indirect, scratch);
+    }
+    inline EdgeRange getIndirectInEdges(const SVFGNode* node, SVFGEdgeVec& scratch) const {
+        return getInEdges(node, Indirect, NumOfGroups, scratch);
+    }
+    //@}
+
+    /// Copy the in-edges of the groups [first, last) of a node from the SVFG
+    static EdgeRange collectInEdges(const SVFGNode* node, EdgeGroup first, EdgeGroup last,
+                                    SVFGEdgeVec& scratch);
+
+    /// Whether the snapshot is used by an analysis
+    static bool isSelected(PointerAnalysis::PTATY ty);
+
+    /// Compare edge iteration over the SVFG and over the snapshot
+    void benchmark() const;
+
+    inline u32_t getNumOfEdges() const {
+        return edges.size();
+    }
+
+private:
+    EdgeRange getInEdges(const SVFGNode* node, EdgeGroup first, EdgeGroup last, SVFGEdgeVec& scratch) const;
+    static EdgeGroup getEdgeGroup(const SVFGEdge* edge);
+
+    const SVFG* svfg;			///< SVFG the snapshot was taken of
+    std::vector<u32_t> offsets;	///< start of every group of every node
+    SVFGEdgeVec edges;			///< in-edges of all nodes
+};
+
+#endif /* SVFGSNAPSHOT_H_ */
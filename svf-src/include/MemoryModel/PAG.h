@@ -406,6 +406,15 @@ public:
     NodeID getGepObjNode(const MemObj* obj, const LocationSet& ls);
     /// Get a field obj PAG node according to a mem obj and a given offset
     NodeID getGepObjNode(NodeID id, const LocationSet& ls) ;
+    /// [OS-CFI] Whether the field obj node of a base obj and a modulus offset
+    /// exists already, without creating it
+    inline bool hasGepObjNode(NodeID base, const LocationSet& ls, NodeID& id) const {
+        NodeLocationSetMap::const_iterator it = GepObjNodeMap.find(std::make_pair(base, ls));
+        if (it == GepObjNodeMap.end())
+            return false;
+        id = it->second;
+        return true;
+    }
     /// Get a field-insensitive obj PAG node according to a mem obj
     //@{
     inline NodeID getFIObjNode(const MemObj* obj) const {
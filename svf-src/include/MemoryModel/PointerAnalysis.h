@@ -26,6 +26,7 @@ class SVFModule;
 class PTAStat;
 
 // [OS-CFI] added SVFGNode and StoreSVFGNode access
+class SVFG;
 class SVFGNode;
 class StoreSVFGNode;
 
@@ -178,6 +179,30 @@ public:
   }
   // [OS-CFI] it is originally implemented in derived classes
   virtual CallStackSet *getCSSensitiveSet(NodeID id) { return nullptr; }
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual void getDDAQueryPts(NodeID id, PointsTo &pts) {}
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual void setDDAQueryResult(NodeID id, const SVFGNode *node,
+                                 const PointsTo &pts,
+                                 OriginSensitiveTupleSet *opts,
+                                 CallStackSet *cspts) {}
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual bool getDDAQuerySlice(NodeID id, NodeBS &slice) { return false; }
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual void setDDAQuerySlice(NodeID id, const NodeBS &slice,
+                                bool complete) {}
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual SVFG *getDDASVFG() { return nullptr; }
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual const PointsTo *getDDAPreAnalysisPts(NodeID id) { return nullptr; }
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual void setDDAQueryTimeout(double seconds) {}
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual bool isDDAQueryOutOfBudget() { return false; }
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual void resetDDAQueryResult(NodeID id) {}
+  // [OS-CFI] it is originally implemented in derived classes
+  virtual void resetDDAPass() {}
 
   /// Interface exposed to users of our pointer analysis, given Location infos
   virtual llvm::AliasResult alias(const llvm::MemoryLocation &LocA,
@@ -426,6 +451,16 @@ public:
   virtual bool readFromFile(const std::string &filename);
   //@}
 
+  /// [OS-CFI] Snapshot the results were read from or written to, empty if none
+  inline const std::string &getSnapshotFile() const { return snapshotFile; }
+
+private:
+  /// [OS-CFI] Binary storage of the analysis results
+  //@{
+  void writeBinaryFile(llvm::raw_ostream &os);
+  bool readBinaryFile(const char *buf, size_t size);
+  //@}
+
 protected:
   /// Update callgraph. This should be implemented by its subclass.
   virtual inline bool updateCallGraph(const CallSiteToFunPtrMap &callsites) {
@@ -460,6 +495,9 @@ protected:
   /// Clear all data
   virtual inline void clearPts() { ptD->clear(); }
 
+  /// [OS-CFI] Snapshot of this analysis, later stages store theirs next to it
+  std::string snapshotFile;
+
   /// On the fly call graph construction
   virtual void onTheFlyCallGraphSolve(const CallSiteToFunPtrMap &callsites,
                                       CallEdgeMap &newEdges,
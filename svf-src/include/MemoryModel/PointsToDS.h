@@ -33,6 +33,7 @@
 #define POINTSTO_H_
 
 #include "MemoryModel/ConditionalPT.h"
+#include "MemoryModel/PointsToTable.h"
 #include "Util/AnalysisUtil.h"
 
 /// Overloading operator << for dumping conditional variable
@@ -169,27 +170,41 @@ public:
  * This is an optimisation version on top of base points-to data.
  * The points-to information is propagated incrementally only for the different parts.
  * CahcePtsMap is an additional map which maintains cached points-to.
+ * [OS-CFI] The propagated and cached sets are only replaced as a whole, so they
+ * are hash-consed in the PointsToTable and shared between nodes and edges.
+ * The handles stored here are the table's holders, a replaced set is released.
  */
 template<class Key, class Data, class CacheKey>
 class DiffPTData : public PTData<Key,Data> {
 public:
     typedef typename PTData<Key,Data>::PtsMap PtsMap;
-    typedef typename PTData<CacheKey,Data>::PtsMap CahcePtsMap;
+    typedef std::map<const Key, PointsToID> PropaPtsMap;
+    typedef std::map<const CacheKey, PointsToID> CahcePtsMap;
     typedef typename PTData<Key,Data>::PTDataTY PTDataTy;
     /// Constructor
-    DiffPTData(PTDataTy ty = (PTData<Key,Data>::DiffPTD)): PTData<Key,Data>(ty) {
+    DiffPTData(PTDataTy ty = (PTData<Key,Data>::DiffPTD)): PTData<Key,Data>(ty),
+        table(PointsToTable::getTable()) {
     }
 
     /// Destructor
-    ~DiffPTData() {}
+    ~DiffPTData() {
+        releaseHandles();
+    }
+
+    /// Clear maps
+    virtual void clear() {
+        PTData<Key,Data>::clear();
+        releaseHandles();
+        diffPtsMap.clear();
+    }
 
     /// Get diff points to.
     inline Data & getDiffPts(Key& var) {
         return diffPtsMap[var];
     }
     /// Get propagated points to.
-    inline Data & getPropaPts(Key& var) {
-        return propaPtsMap[var];
+    inline const Data & getPropaPts(Key& var, Data& scratch) {
+        return table->getPts(propaPtsMap[var], scratch);
     }
 
     /**
@@ -202,9 +217,13 @@ public:
         Data& diff = getDiffPts(var);
         diff.clear();
         /// get all pts
-        Data& propa = getPropaPts(var);
-        diff.intersectWithComplement(all, propa);
-        propa = all;
+        PointsToID& propa = propaPtsMap[var];
+        Data scratch;
+        const Data& propaPts = table->getPts(propa, scratch);
+        diff.intersectWithComplement(all, propaPts);
+        /// [OS-CFI] an unchanged set keeps its handle, nothing is interned
+        if (!diff.empty() || all.count() != propaPts.count())
+            table->assign(propa, table->intern(all));
         return (diff.empty() == false);
     }
 
@@ -213,24 +232,39 @@ public:
      * The final result is the intersection of these two sets.
      */
     inline void updatePropaPtsMap(Key& src, Key&dst) {
-        Data& srcPropa = getPropaPts(src);
-        Data& dstPropa = getPropaPts(dst);
-        dstPropa &= srcPropa;
+        PointsToID srcPropa = propaPtsMap[src];
+        PointsToID& dstPropa = propaPtsMap[dst];
+        table->assign(dstPropa, table->intersectPts(dstPropa, srcPropa));
     }
 
     /// Clear propagated pts
     inline void clearPropaPts(Key& var) {
-        getPropaPts(var).clear();
+        table->assign(propaPtsMap[var], PointsToTable::EmptyPts);
     }
 
     /// Get cached points-to
-    inline Data& getCachePts(CacheKey& cache) {
-        return CacheMap[cache];
+    inline const Data& getCachePts(CacheKey& cache, Data& scratch) {
+        return table->getPts(CacheMap[cache], scratch);
+    }
+
+    /// [OS-CFI] Compute the part of all not cached yet into newPts and add it
+    /// to the cached points-to
+    inline void computeCacheDiffPts(CacheKey& cache, const Data& all, Data& newPts) {
+        PointsToID& cached = CacheMap[cache];
+        Data scratch;
+        const Data& cachedPts = table->getPts(cached, scratch);
+        newPts.intersectWithComplement(all, cachedPts);
+        if (!newPts.empty())
+            table->assign(cached, table->intern(newPts | cachedPts));
     }
 
     /// Add cached points-to
     inline void addCachePts(CacheKey& cache, Data& data) {
-        CacheMap[cache] |= data;
+        PointsToID& cached = CacheMap[cache];
+        Data scratch;
+        Data merged = table->getPts(cached, scratch);
+        if (merged |= data)
+            table->assign(cached, table->intern(merged));
     }
 
     /// Methods for support type inquiry through isa, cast, and dyn_cast:
@@ -244,10 +278,23 @@ public:
     //@}
 
 private:
+    /// [OS-CFI] Let go of the propagated and cached sets
+    inline void releaseHandles() {
+        for (typename PropaPtsMap::iterator it = propaPtsMap.begin(),
+                eit = propaPtsMap.end(); it != eit; ++it)
+            table->release(it->second);
+        for (typename CahcePtsMap::iterator it = CacheMap.begin(),
+                eit = CacheMap.end(); it != eit; ++it)
+            table->release(it->second);
+        propaPtsMap.clear();
+        CacheMap.clear();
+    }
+
     PtsMap diffPtsMap;	///< diff points-to to be propagated
-    PtsMap propaPtsMap;	///< points-to already propagated
+    PropaPtsMap propaPtsMap;	///< points-to already propagated
 
     CahcePtsMap CacheMap;	///< points-to processed at load/store edge
+    PointsToTable* table;	///< [OS-CFI] interned propagated and cached sets
 };
 
 #endif /* POINTSTO_H_ */
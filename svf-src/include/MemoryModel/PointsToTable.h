@@ -0,0 +1,114 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef POINTSTOTABLE_H_
+#define POINTSTOTABLE_H_
+
+#include "Util/BasicTypes.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+
+/// [OS-CFI] Handle of an interned points-to set
+typedef u64_t PointsToID;
+
+/*!
+ * [OS-CFI] Hash-consed points-to sets.
+ *
+ * A set is immutable once interned and is referred to by a PointsToID, so
+ * equal sets are stored once however many variables hold them. Sets of up to
+ * three small objects are encoded in the handle itself and never reach the
+ * table. Intersections of two handles, which merge the propagated sets of
+ * DiffPTData, are memoized.
+ *
+ * Table sets are reference counted: a holder retains the handles it stores
+ * (see assign) and a set is freed when its last holder lets go. A freed slot
+ * is only reused once the memo cache, which refers to handles weakly, has
+ * been flushed; it is flushed when it grows past a bound.
+ */
+class PointsToTable {
+public:
+    /// The empty set
+    static const PointsToID EmptyPts = 0;
+
+    /// Global table shared by all points-to data
+    static PointsToTable* getTable();
+
+    /// Intern a set and return its handle
+    PointsToID intern(const PointsTo& pts);
+
+    /// Return the set of a handle, inline sets are decoded into scratch
+    const PointsTo& getPts(PointsToID id, PointsTo& scratch) const;
+
+    /// Reference counting of the handles stored by a holder
+    //@{
+    void retain(PointsToID id);
+    void release(PointsToID id);
+    /// Store id into a holder's slot, releasing the handle it held
+    inline void assign(PointsToID& slot, PointsToID id) {
+        retain(id);
+        release(slot);
+        slot = id;
+    }
+    //@}
+
+    /// Memoized intersection of two handles
+    PointsToID intersectPts(PointsToID lhs, PointsToID rhs);
+
+    /// Statistics
+    //@{
+    inline u32_t getNumOfSets() const {
+        return sets.size() - freeSlots.size() - releasedSlots.size();
+    }
+    inline u32_t getNumOfInlineSets() const {
+        return inlineSets.size();
+    }
+    //@}
+
+private:
+    typedef std::pair<PointsToID, PointsToID> PointsToIDPair;
+    typedef llvm::DenseMap<PointsToIDPair, PointsToID> OpCacheMap;
+    typedef llvm::DenseMap<u64_t, llvm::SmallVector<u32_t, 1>> HashToSetsMap;
+
+    /// Reference count of a freed slot
+    static const u32_t FreedSet = ~0U;
+
+    PointsToTable() {
+        sets.push_back(PointsTo());
+        refCounts.push_back(0);
+    }
+
+    /// Whether a handle refers to a table slot rather than encoding its set
+    bool isTableSet(PointsToID id) const;
+    /// Whether a memoized result still refers to its set
+    inline bool isLive(PointsToID id) const {
+        return !isTableSet(id) || refCounts[id] != FreedSet;
+    }
+
+    /// Hash of a set, with the top bit cleared to stay clear of DenseMap's
+    /// reserved keys
+    static u64_t hashPts(const PointsTo& pts);
+
+    /// Free a set nobody holds
+    void freeSet(PointsToID id);
+
+    /// Look up and record memoized results, flushing the cache when full
+    bool lookup(const PointsToIDPair& key, PointsToID& id) const;
+    void memoize(const PointsToIDPair& key, PointsToID id);
+    void flushOpCache();
+
+    /// Encode a set of at most three small objects in its handle
+    bool encodeInline(const PointsTo& pts, PointsToID& id);
+    void decodeInline(PointsToID id, PointsTo& pts) const;
+
+    std::vector<PointsTo> sets;	///< interned sets, indexed by handle
+    std::vector<u32_t> refCounts;	///< holders of each interned set
+    std::vector<u32_t> freeSlots;	///< freed slots no memo entry refers to
+    std::vector<u32_t> releasedSlots;	///< freed since the last flush
+    HashToSetsMap hashToSets;	///< set hash to the handles sharing it
+    OpCacheMap intersectCache;	///< memoized intersections
+    llvm::DenseSet<PointsToID> inlineSets;	///< distinct sets encoded in their handle
+};
+
+#endif /* POINTSTOTABLE_H_ */
@@ -201,6 +201,10 @@ public:
     static inline void setMaxCxtLen(u32_t max) {
         maximumCxtLen = max;
     }
+    /// get max context limit
+    static inline u32_t getMaxCxtLen() {
+        return maximumCxtLen;
+    }
     /// Push context
     inline virtual bool pushContext(NodeID ctx) {
 
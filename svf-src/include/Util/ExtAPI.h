@@ -195,8 +195,11 @@ public:
             res= 1;
         } else {
             extf_t t= get_type(F);
+            // [OS-CFI] the runtime copy wrappers are linked in, yet they are
+            // modelled per call like the libc functions they wrap
             res= t==EFT_ALLOC || t==EFT_REALLOC || t==EFT_NOSTRUCT_ALLOC
-                 || t==EFT_NOOP || t==EFT_FREE;
+                 || t==EFT_NOOP || t==EFT_FREE
+                 || (t==EFT_L_A0__A0R_A1R && F->getName().startswith("oscfi_"));
         }
         isext_cache[F]= res;
         return res;
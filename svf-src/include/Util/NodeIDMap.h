@@ -0,0 +1,80 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#ifndef NODEIDMAP_H_
+#define NODEIDMAP_H_
+
+#include "Util/BasicTypes.h"
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+/*!
+ * [OS-CFI] Map indexed directly by a NodeID.
+ *
+ * Every slot is stamped with the generation it was written in and only the
+ * slots of the current generation are present, so clear() just starts a new
+ * generation. Stale values are overwritten the next time their slot is
+ * written. Growing the map keeps references to present values valid, as
+ * std::map does.
+ */
+template<class Data>
+class NodeIDMap {
+public:
+    /// Constructor
+    NodeIDMap(): generation(1) {
+    }
+
+    /// Whether id is present
+    inline u32_t count(NodeID id) const {
+        return (id < stamps.size() && stamps[id] == generation) ? 1 : 0;
+    }
+
+    /// Value of id, default constructed if it is not present
+    inline Data& operator[](NodeID id) {
+        if (id >= stamps.size()) {
+            stamps.resize(id + 1, 0);
+            values.resize(id + 1);
+        }
+        if (stamps[id] != generation) {
+            stamps[id] = generation;
+            values[id] = Data();
+        }
+        return values[id];
+    }
+
+    /// Value of id, NULL if it is not present
+    //@{
+    inline Data* find(NodeID id) {
+        return count(id) ? &values[id] : NULL;
+    }
+    inline const Data* find(NodeID id) const {
+        return count(id) ? &values[id] : NULL;
+    }
+    //@}
+
+    /// Make room for ids below num
+    inline void reserve(u32_t num) {
+        if (num > stamps.size()) {
+            stamps.resize(num, 0);
+            values.resize(num);
+        }
+    }
+
+    /// Remove all ids in O(1)
+    inline void clear() {
+        if (++generation == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            generation = 1;
+        }
+    }
+
+private:
+    std::deque<Data> values;	///< value of every id
+    std::vector<u32_t> stamps;	///< generation every value was written in
+    u32_t generation;			///< current generation, 0 is never current
+};
+
+#endif /* NODEIDMAP_H_ */
@@ -290,9 +290,10 @@ private:
 
     static AndersenWaveDiff* diffWave; // static instance
 
-    PointsTo & getCachePts(const ConstraintEdge* edge) {
+    /// [OS-CFI] Compute the points-to of node not yet processed at edge
+    void computeCacheDiffPts(const ConstraintEdge* edge, NodeID node, PointsTo& newPts) {
         EdgeID edgeId = edge->getEdgeID();
-        return getDiffPTDataTy()->getCachePts(edgeId);
+        getDiffPTDataTy()->computeCacheDiffPts(edgeId, getPts(node), newPts);
     }
 
     /// Handle diff points-to set.
@@ -365,6 +366,14 @@ protected:
     virtual void processCast(const ConstraintEdge *edge) {
         return;
     }
+
+    /// [OS-CFI] Wave propagation with the copy edges of a wave level solved
+    /// by parallel threads
+    //@{
+    virtual void solve();
+    bool isParallelCopyNode(NodeID nodeId);
+    void propagateCopiesInParallel(const NodeVector& nodes);
+    //@}
 };
 
 
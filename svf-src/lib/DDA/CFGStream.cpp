@@ -0,0 +1,148 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "DDA/CFGStream.h"
+#include "Util/AnalysisUtil.h"
+#include <cstring>
+#include <llvm/Support/FileSystem.h>
+
+using namespace llvm;
+using namespace analysisUtil;
+
+// [OS-CFI] the version is raised whenever the record layout changes, a
+// reader never guesses at a stream of another version
+static const char CFGMagic[8] = {'O', 'S', 'C', 'F', 'I', 'C', 'F', 'G'};
+static const u32_t CFGVersion = 1;
+
+struct CFGStreamHeader {
+  char magic[8];
+  u32_t version;
+  u32_t reserved;
+};
+
+struct CFGRecordHead {
+  u32_t kind;
+  u32_t target;
+  u64_t iCallID;
+  u64_t iCallTargetID;
+};
+
+/*!
+ * Constructor
+ */
+CFGStreamWriter::CFGStreamWriter(const std::string &path)
+    : os(NULL), numOfRecords(0) {
+  std::error_code err;
+  os = new raw_fd_ostream(path, err, sys::fs::F_None);
+  if (err) {
+    wrnMsg("cannot create the CFG stream '" + path + "': " + err.message());
+    delete os;
+    os = NULL;
+    return;
+  }
+  CFGStreamHeader header;
+  memcpy(header.magic, CFGMagic, sizeof(CFGMagic));
+  header.version = CFGVersion;
+  header.reserved = 0;
+  os->write((const char *)&header, sizeof(header));
+}
+
+/*!
+ * Destructor
+ */
+CFGStreamWriter::~CFGStreamWriter() {
+  if (os == NULL)
+    return;
+  os->close();
+  if (os->has_error()) {
+    wrnMsg("the CFG stream could not be written completely");
+    os->clear_error();
+  }
+  delete os;
+}
+
+void CFGStreamWriter::write(const CFGRecord &rec) {
+  if (os == NULL)
+    return;
+  CFGRecordHead head;
+  head.kind = rec.kind;
+  head.target = rec.target;
+  head.iCallID = rec.iCallID;
+  head.iCallTargetID = rec.iCallTargetID;
+  u32_t length = sizeof(head) + rec.context.size() * sizeof(u64_t);
+  os->write((const char *)&length, sizeof(length));
+  os->write((const char *)&head, sizeof(head));
+  os->write((const char *)rec.context.data(),
+            rec.context.size() * sizeof(u64_t));
+  numOfRecords++;
+}
+
+void CFGStreamWriter::flush() {
+  if (os)
+    os->flush();
+}
+
+/*!
+ * Constructor
+ */
+CFGStreamReader::CFGStreamReader(const std::string &path)
+    : pos(NULL), truncated(false) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> file =
+      MemoryBuffer::getFile(path, -1, false);
+  if (!file) {
+    wrnMsg("cannot open the CFG stream '" + path + "'");
+    return;
+  }
+  const CFGStreamHeader *header =
+      (const CFGStreamHeader *)(*file)->getBufferStart();
+  if ((*file)->getBufferSize() < sizeof(CFGStreamHeader) ||
+      memcmp(header->magic, CFGMagic, sizeof(CFGMagic)) != 0 ||
+      header->version != CFGVersion) {
+    wrnMsg("'" + path + "' is not a CFG stream of version " +
+           std::to_string(CFGVersion));
+    return;
+  }
+  buf = std::move(*file);
+  pos = buf->getBufferStart() + sizeof(CFGStreamHeader);
+}
+
+/*!
+ * Records are copied out of the mapping since the stream keeps no alignment
+ */
+bool CFGStreamReader::next(CFGRecord &rec) {
+  if (buf == nullptr)
+    return false;
+  const char *end = buf->getBufferEnd();
+  u32_t length = 0;
+  while (pos < end) {
+    if ((size_t)(end - pos) < sizeof(length)) {
+      truncated = true;
+      return false;
+    }
+    memcpy(&length, pos, sizeof(length));
+    if (length < sizeof(CFGRecordHead) ||
+        (length - sizeof(CFGRecordHead)) % sizeof(u64_t) != 0 ||
+        (size_t)(end - pos - sizeof(length)) < length) {
+      truncated = true;
+      return false;
+    }
+    const char *body = pos + sizeof(length);
+    pos = body + length;
+    CFGRecordHead head;
+    memcpy(&head, body, sizeof(head));
+    if (head.kind < SUPA_CFG || head.kind > ATCFG)
+      continue;
+    rec.kind = head.kind;
+    rec.target = head.target;
+    rec.iCallID = head.iCallID;
+    rec.iCallTargetID = head.iCallTargetID;
+    rec.context.resize((length - sizeof(head)) / sizeof(u64_t));
+    if (!rec.context.empty())
+      memcpy(rec.context.data(), body + sizeof(head),
+             rec.context.size() * sizeof(u64_t));
+    return true;
+  }
+  return false;
+}
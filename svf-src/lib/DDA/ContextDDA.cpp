@@ -13,6 +13,9 @@ using namespace llvm;
 static cl::opt<unsigned long long>
     cxtBudget("cxtbg", cl::init(10000),
               cl::desc("Maximum step budget of context-sensitive traversing"));
+
+u64_t ContextDDA::getCxtBudget() { return cxtBudget; }
+
 /*!
  * Constructor
  */
@@ -37,6 +40,8 @@ ContextDDA::~ContextDDA() {
 void ContextDDA::initialize(SVFModule module) {
   CondPTAImpl<ContextCond>::initialize(module);
   buildSVFG(module);
+  if (SVFGSnapshot::isSelected(getAnalysisTy()))
+    buildSVFGSnapshot();
   setCallGraph(getPTACallGraph());
   setCallGraphSCC(getCallGraphSCC());
   stat = setDDAStat(new DDAStat(this));
@@ -58,6 +63,40 @@ OriginSensitiveTupleSet *ContextDDA::getOriginSensitiveTupleSet(NodeID id) {
 // candidate node id
 CallStackSet *ContextDDA::getCSSensitiveSet(NodeID id) { return mapCSSen[id]; }
 
+// [OS-CFI] getDDAQueryPts(): return the points-to set of a solved query
+// without its contexts, it is what computeCFG() reads after finalize()
+void ContextDDA::getDDAQueryPts(NodeID id, PointsTo &pts) {
+  ContextCond cxt;
+  CxtVar var(cxt, id);
+  pts |= getBVPointsTo(getPts(var));
+}
+
+// [OS-CFI] setDDAQueryResult(): install a query answered by a query worker,
+// targets are recorded under the empty context
+void ContextDDA::setDDAQueryResult(NodeID id, const SVFGNode *node,
+                                   const PointsTo &pts,
+                                   OriginSensitiveTupleSet *opts,
+                                   CallStackSet *cspts) {
+  ContextCond cxt;
+  CxtPtSet cpts;
+  for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it) {
+    CxtVar obj(cxt, *it);
+    cpts.set(obj);
+  }
+  CxtVar var(cxt, id);
+  unionPts(var, cpts);
+  setCandidateResult(id, node, opts, cspts);
+}
+
+// [OS-CFI] resetDDAQueryResult(): forget the answer of a solved query, the
+// anytime analysis solves it again under a deeper context limit
+void ContextDDA::resetDDAQueryResult(NodeID id) {
+  ContextCond cxt;
+  CxtVar var(cxt, id);
+  getPts(var).clear();
+  resetCandidateResult(id);
+}
+
 /*!
  * Compute points-to set for a context-sensitive pointer
  */
@@ -94,6 +133,7 @@ const CxtPtSet &ContextDDA::computeDDAPts(const CxtVar &var) {
     unionPts(var, cpts);
   else
     handleOutOfBudgetDpm(dpm);
+  finishQuerySlice();
 
   if (this->printStat())
     DOSTAT(stat->performStatPerQuery(id));
@@ -121,6 +161,9 @@ void ContextDDA::handleOutOfBudgetDpm(const CxtLocDPItem &dpm) {
           << "~~~Out of budget query, downgrade to flow sensitive analysis \n");
   flowDDA->computeDDAPts(dpm.getCurNodeID());
   const PointsTo &flowPts = flowDDA->getPts(dpm.getCurNodeID());
+  // [OS-CFI] the downgraded answer depends on the flow-sensitive slice
+  if (!flowDDA->getQuerySlice(dpm.getCurNodeID(), curSlice))
+    markSliceIncomplete();
   CxtPtSet cxtPts;
   for (PointsTo::iterator it = flowPts.begin(), eit = flowPts.end(); it != eit;
        ++it) {
@@ -196,12 +239,14 @@ CxtPtSet ContextDDA::processGepPts(const GepSVFGNode *gep,
                          << *(mapNodeStore[src.get_id()]->getInst()) << "\n";
           }
         }
-        if (mapTOrgCtx.count(src.get_id()) > 0) {
-          for (InstructionSetIt it = mapTOrgCtx[src.get_id()].begin();
-               it != mapTOrgCtx[src.get_id()].end(); it++) {
+        const OriginContextSetPtr *ctxs = mapTOrgCtx.find(src.get_id());
+        if (ctxs) {
+          const InstructionSet &orgCtxs = **ctxs;
+          for (InstructionSet::const_iterator it = orgCtxs.begin();
+               it != orgCtxs.end(); it++) {
             if (*it != nullptr) {
-              mapSOrgSenTupSet[getCurCandidate()]->insert(std::make_tuple(
-                  dst.get_id(), mapNodeStore[src.get_id()], *it));
+              addOriginTuple(std::make_tuple(dst.get_id(),
+                                             mapNodeStore[src.get_id()], *it));
               if (DEBUG_SOLVER) {
                 llvm::outs()
                     << "[OS-CFI] mapSOrgSenTupSet[" << getCurCandidate()
@@ -211,7 +256,7 @@ CxtPtSet ContextDDA::processGepPts(const GepSVFGNode *gep,
                     << ">\n";
               }
             } else {
-              mapSOrgSenTupSet[getCurCandidate()]->insert(std::make_tuple(
+              addOriginTuple(std::make_tuple(
                   dst.get_id(), mapNodeStore[src.get_id()], nullptr));
               if (DEBUG_SOLVER) {
                 llvm::outs()
@@ -224,8 +269,8 @@ CxtPtSet ContextDDA::processGepPts(const GepSVFGNode *gep,
             }
           }
         } else {
-          mapSOrgSenTupSet[getCurCandidate()]->insert(std::make_tuple(
-              dst.get_id(), mapNodeStore[src.get_id()], nullptr));
+          addOriginTuple(std::make_tuple(dst.get_id(),
+                                         mapNodeStore[src.get_id()], nullptr));
           if (DEBUG_SOLVER) {
             llvm::outs() << "[oCFG-Count] mapSOrgSenTupSet["
                          << getCurCandidate() << "] <= <" << dst.get_id()
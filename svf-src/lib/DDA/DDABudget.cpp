@@ -0,0 +1,84 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "DDA/DDABudget.h"
+#include "Util/AnalysisUtil.h"
+#include <algorithm>
+
+using namespace analysisUtil;
+
+/*!
+ * Constructor
+ */
+DDABudget::DDABudget(double s, u32_t mb, u32_t firstCxt, u32_t lastCxt)
+    : seconds(s), megabytes(mb),
+      cxt(std::min(std::max(firstCxt, 1u), lastCxt)), maxCxt(lastCxt),
+      numOfPasses(0), passEnd(0), passValue(0), exhausted(false),
+      start(Clock::now()) {}
+
+double DDABudget::getElapsed() const {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/*!
+ * Passes left including the current one, the context limit doubles from pass
+ * to pass until it reaches the deepest one
+ */
+u32_t DDABudget::getNumOfPassesLeft() const {
+  u32_t passes = 1;
+  for (u32_t d = cxt; d < maxCxt; d = std::min(2 * d, maxCxt))
+    passes++;
+  return passes;
+}
+
+/*!
+ * Start the next pass, the time it leaves unused is shared by the later ones
+ */
+bool DDABudget::nextPass(u64_t value) {
+  if (numOfPasses > 0) {
+    if (isFinalPass() || isExhausted())
+      return false;
+    cxt = std::min(2 * cxt, maxCxt);
+  }
+  numOfPasses++;
+  double elapsed = getElapsed();
+  passEnd = elapsed + (seconds - elapsed) / getNumOfPassesLeft();
+  passValue = value;
+  return true;
+}
+
+/*!
+ * Slice of the current pass in proportion to the value of the query. A pass
+ * that overran its share goes on with an even share of what is left overall
+ */
+double DDABudget::getQueryTimeout(u32_t value) {
+  if (isExhausted())
+    return 0;
+  if (seconds <= 0)
+    return -1;
+  double elapsed = getElapsed();
+  double left = passEnd - elapsed;
+  if (left <= 0)
+    left = (seconds - elapsed) / getNumOfPassesLeft();
+  double timeout = passValue > value ? left * value / passValue : left;
+  passValue = passValue > value ? passValue - value : 0;
+  return std::max(timeout, 0.0);
+}
+
+/*!
+ * The resident set size is read from /proc, the budget stays used up once
+ * it was
+ */
+bool DDABudget::isExhausted() {
+  if (exhausted)
+    return true;
+  if (seconds > 0 && getElapsed() >= seconds)
+    exhausted = true;
+  u32_t vmrss = 0, vmsize = 0;
+  if (megabytes > 0 && getMemoryUsageKB(&vmrss, &vmsize) &&
+      vmrss / 1024 >= megabytes)
+    exhausted = true;
+  return exhausted;
+}
@@ -4,10 +4,16 @@
  * Affliation: Florida State University
  */
 #include "DDA/DDAClient.h"
+#include "DDA/DDABudget.h"
+#include "DDA/DDAQueryCache.h"
 #include "DDA/FlowDDA.h"
+#include <algorithm>
+#include <cstdio>
 #include <iomanip> // for std::setw
 #include <iostream>
 #include <llvm/Support/CommandLine.h> // for tool output file
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace llvm;
 using namespace analysisUtil;
@@ -43,26 +49,627 @@ static cl::opt<bool>
     TaintUninitStack("uninit-stack", cl::init(true),
                      cl::desc("detect uninitialized stack variables"));
 
+// [OS-CFI] number of query workers, 0 solves the candidates in oscfg itself.
+// Every shard is solved from the same solver image, so the results do not
+// depend on the number of workers, only on the shard size
+static cl::opt<unsigned>
+    DDAJobs("dda-jobs", cl::init(0),
+            cl::desc("Number of forked workers solving candidate queries, 0 "
+                     "if solved in place"));
+
+static cl::opt<unsigned>
+    DDAShardSize("dda-shard-size", cl::init(64),
+                 cl::desc("Candidate queries a query worker solves"));
+
+// [OS-CFI] candidates reaching a common SVFG node are clustered, a cluster is
+// solved in one go so that its queries reuse each other's cached dpms
+static cl::opt<bool>
+    DDASchedule("dda-schedule", cl::init(true),
+                cl::desc("Solve candidates sharing SVFG ancestors together"));
+
+static cl::opt<unsigned> DDAScheduleNodes(
+    "dda-schedule-nodes", cl::init(64),
+    cl::desc("SVFG ancestors of a candidate visited by the query scheduler"));
+
+// [OS-CFI] anytime analysis, the budget covers all candidate queries
+static cl::opt<double>
+    DDATimeBudget("dda-time-budget", cl::init(0),
+                  cl::desc("Seconds all candidate queries may take, 0 if "
+                           "unlimited"));
+
+static cl::opt<unsigned>
+    DDAMemBudget("dda-mem-budget", cl::init(0),
+                 cl::desc("Megabytes of resident memory the candidate queries "
+                          "may grow to, 0 if unlimited"));
+
+static cl::opt<bool>
+    DDADeepen("dda-deepen", cl::init(true),
+              cl::desc("Deepen the context limit from pass to pass up to "
+                       "maxcxt in an anytime analysis"));
+
+// [OS-CFI] a worker writes one record per solved candidate of its shard:
+// query id, candidate SVFG node, points-to targets, origin sensitive tuples,
+// call-site stacks, the SVFG slice of the query and whether it ran out of
+// budget. Every field is a 64-bit word. The workers are forked after the SVFG
+// is built, so SVFG nodes and instructions are plain addresses shared with
+// the parent. Field objects created inside a worker are sent as (base object,
+// location set) and re-created in the parent.
+static bool writeWord(FILE *fp, u64_t word) {
+  return fwrite(&word, sizeof(word), 1, fp) == 1;
+}
+
+static bool readWord(FILE *fp, u64_t &word) {
+  return fread(&word, sizeof(word), 1, fp) == 1;
+}
+
+static void writeObj(FILE *fp, PAG *pag, NodeID id, NodeID lastID) {
+  if (id < lastID) {
+    writeWord(fp, id);
+    return;
+  }
+  const GepObjPN *gep = llvm::cast<GepObjPN>(pag->getPAGNode(id));
+  const LocationSet &ls = gep->getLocationSet();
+  writeWord(fp, lastID + (u64_t)pag->getBaseObjNode(id));
+  writeWord(fp, ls.getOffset());
+  writeWord(fp, ls.getByteOffset());
+  writeWord(fp, ls.getNumStridePair().size());
+  for (LocationSet::ElemNumStridePairVec::const_iterator
+           it = ls.getNumStridePair().begin(),
+           eit = ls.getNumStridePair().end();
+       it != eit; ++it) {
+    writeWord(fp, it->first);
+    writeWord(fp, it->second);
+  }
+}
+
+static bool readObj(FILE *fp, PAG *pag, NodeID lastID, NodeID &id) {
+  u64_t word = 0;
+  if (!readWord(fp, word))
+    return false;
+  if (word < lastID) {
+    id = word;
+    return true;
+  }
+  u64_t fldIdx = 0, byteOffset = 0, num = 0;
+  if (!readWord(fp, fldIdx) || !readWord(fp, byteOffset) || !readWord(fp, num))
+    return false;
+  LocationSet ls(fldIdx);
+  ls.setByteOffset(byteOffset);
+  for (u64_t i = 0; i < num; i++) {
+    u64_t elemNum = 0, stride = 0;
+    if (!readWord(fp, elemNum) || !readWord(fp, stride))
+      return false;
+    ls.addElemNumStridePair(std::make_pair(elemNum, stride));
+  }
+  id = pag->getGepObjNode(word - lastID, ls);
+  return true;
+}
+
+static void writeQueryResult(FILE *fp, PointerAnalysis *pta, NodeID query,
+                             NodeID lastID, bool truncated) {
+  PAG *pag = pta->getPAG();
+  PointsTo pts;
+  pta->getDDAQueryPts(query, pts);
+  writeWord(fp, query);
+  writeWord(fp, (u64_t)pta->getSVFGForCandidateNode(query));
+  writeWord(fp, pts.count());
+  for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it)
+    writeObj(fp, pag, *it, lastID);
+
+  const OriginSensitiveTupleSet *opts = pta->getOriginSensitiveTupleSet(query);
+  writeWord(fp, opts ? opts->size() : 0);
+  if (opts) {
+    for (OriginSensitiveTupleSetIt it = opts->begin(), eit = opts->end();
+         it != eit; ++it) {
+      writeObj(fp, pag, std::get<0>(*it), lastID);
+      writeWord(fp, (u64_t)std::get<1>(*it));
+      writeWord(fp, (u64_t)std::get<2>(*it));
+    }
+  }
+
+  const CallStackSet *cspts = pta->getCSSensitiveSet(query);
+  writeWord(fp, cspts ? cspts->size() : 0);
+  if (cspts) {
+    for (CallStackSetIt it = cspts->begin(), eit = cspts->end(); it != eit;
+         ++it) {
+      writeObj(fp, pag, it->first, lastID);
+      CallSwitchPairStack stack(it->second);
+      writeWord(fp, stack.size());
+      while (!stack.empty()) {
+        writeWord(fp, stack.top().first);
+        writeWord(fp, (u64_t)stack.top().second);
+        stack.pop();
+      }
+    }
+  }
+
+  NodeBS slice;
+  bool complete = pta->getDDAQuerySlice(query, slice);
+  writeWord(fp, complete);
+  writeWord(fp, slice.count());
+  for (NodeBS::iterator it = slice.begin(), eit = slice.end(); it != eit; ++it)
+    writeWord(fp, *it);
+  writeWord(fp, truncated);
+}
+
+// [OS-CFI] readQueryResult(): install the answer of a query solved by a
+// worker, it replaces the answer the query had if replace is set
+static bool readQueryResult(FILE *fp, PointerAnalysis *pta, NodeID query,
+                            NodeID lastID, bool replace, bool &truncated) {
+  PAG *pag = pta->getPAG();
+  u64_t word = 0, node = 0, num = 0;
+  if (!readWord(fp, word) || word != query || !readWord(fp, node) ||
+      !readWord(fp, num))
+    return false;
+
+  PointsTo pts;
+  for (u64_t i = 0; i < num; i++) {
+    NodeID obj = 0;
+    if (!readObj(fp, pag, lastID, obj))
+      return false;
+    pts.set(obj);
+  }
+
+  OriginSensitiveTupleSet *opts = new OriginSensitiveTupleSet();
+  CallStackSet *cspts = new CallStackSet();
+  bool complete = readWord(fp, num);
+  for (u64_t i = 0; complete && i < num; i++) {
+    NodeID target = 0;
+    u64_t store = 0, ctx = 0;
+    complete = readObj(fp, pag, lastID, target) && readWord(fp, store) &&
+               readWord(fp, ctx);
+    if (complete)
+      opts->insert(std::make_tuple(target, (const StoreSVFGNode *)store,
+                                   (const llvm::Instruction *)ctx));
+  }
+  complete = complete && readWord(fp, num);
+  for (u64_t i = 0; complete && i < num; i++) {
+    NodeID target = 0;
+    u64_t depth = 0;
+    complete = readObj(fp, pag, lastID, target) && readWord(fp, depth);
+    // entries were written from the top, rebuild the stack from the bottom
+    std::vector<CallSwitchPair> entries;
+    for (u64_t d = 0; complete && d < depth; d++) {
+      u64_t id = 0, inst = 0;
+      complete = readWord(fp, id) && readWord(fp, inst);
+      entries.push_back(
+          std::make_pair((NodeID)id, (const llvm::Instruction *)inst));
+    }
+    if (complete) {
+      CallSwitchPairStack stack;
+      for (std::vector<CallSwitchPair>::reverse_iterator
+               rit = entries.rbegin(),
+               reit = entries.rend();
+           rit != reit; ++rit)
+        stack.push(*rit);
+      cspts->insert(std::make_pair(target, stack));
+    }
+  }
+  u64_t sliceComplete = 0;
+  NodeBS slice;
+  complete = complete && readWord(fp, sliceComplete) && readWord(fp, num);
+  for (u64_t i = 0; complete && i < num; i++) {
+    u64_t id = 0;
+    complete = readWord(fp, id);
+    slice.set(id);
+  }
+  complete = complete && readWord(fp, word);
+  if (!complete) {
+    delete opts;
+    delete cspts;
+    return false;
+  }
+
+  truncated = word;
+  if (replace)
+    pta->resetDDAQueryResult(query);
+  pta->setDDAQueryResult(query, (const SVFGNode *)node, pts, opts, cspts);
+  pta->setDDAQuerySlice(query, slice, sliceComplete);
+  return true;
+}
+
 void DDAClient::answerQueries(PointerAnalysis *pta) {
 
   collectCandidateQueries(pta->getPAG());
 
+  std::vector<NodeID> queries;
+  std::vector<u32_t> clusterOf;
+  scheduleQueries(pta, queries, clusterOf);
+
+  // [OS-CFI] only the context-sensitive solver can forget an answer
+  if ((DDATimeBudget > 0 || DDAMemBudget > 0) &&
+      pta->getAnalysisTy() == PointerAnalysis::Cxt_DDA) {
+    answerQueriesAnytime(pta, queries, clusterOf);
+    return;
+  }
+
+  solveQueries(pta, queries, clusterOf);
+}
+
+void DDAClient::solveQueries(PointerAnalysis *pta,
+                             const std::vector<NodeID> &queries,
+                             const std::vector<u32_t> &clusterOf) {
+  // [OS-CFI] only the context-sensitive solver can hand its results back
+  if (DDAJobs > 0 && queries.size() > 1 &&
+      pta->getAnalysisTy() == PointerAnalysis::Cxt_DDA) {
+    answerQueriesInWorkers(pta, queries, clusterOf, DDAJobs);
+    return;
+  }
+
+  for (u32_t count = 0; count < queries.size(); ++count) {
+    NodeID id = queries[count];
+    DBOUT(DGENERAL, outs() << "\n@@Computing PointsTo for :" << id << " ["
+                           << count + 1 << "/" << queries.size() << "]"
+                           << " \n");
+    DBOUT(DDDA, outs() << "\n@@Computing PointsTo for :" << id << " ["
+                       << count + 1 << "/" << queries.size() << "]"
+                       << " \n");
+    setCurrentQueryPtr(id);
+    if (lookupQuery(id))
+      continue;
+    bool truncated = solveQuery(pta, id);
+    finishQuery(pta, id, truncated);
+  }
+}
+
+// [OS-CFI] predicted reduction of the equivalence class of a query: the
+// targets its answer still allows, the pre-analysis ones before it is solved
+static u32_t getQueryValue(PointerAnalysis *pta, NodeID id, bool solved) {
   u32_t count = 0;
+  if (solved) {
+    PointsTo pts;
+    pta->getDDAQueryPts(id, pts);
+    count = pts.count();
+  } else if (const PointsTo *pts = pta->getDDAPreAnalysisPts(id)) {
+    count = pts->count();
+  }
+  return std::max(count, (u32_t)1);
+}
+
+// [OS-CFI] answerQueriesAnytime(): the first pass answers every candidate
+// under the smallest context limit, every further pass doubles the limit and
+// solves again the candidates whose answer still allows more than one
+// target. A candidate that runs out of budget keeps the answer of the pass
+// before, so stopping early always leaves a sound answer. Final answers are
+// recorded in the query cache as soon as they are known and the cache is
+// checkpointed on the way, so a stopped run resumes from the last checkpoint.
+void DDAClient::answerQueriesAnytime(PointerAnalysis *pta,
+                                     std::vector<NodeID> queries,
+                                     std::vector<u32_t> clusterOf) {
+  u32_t maxCxt = ContextCond::getMaxCxtLen();
+  DDABudget budget(DDATimeBudget, DDAMemBudget, DDADeepen ? 1 : maxCxt,
+                   maxCxt);
+  anytimeBudget = &budget;
+  bool solved = false;
+  while (!queries.empty()) {
+    u64_t value = 0;
+    for (u32_t q = 0; q < queries.size(); q++)
+      value += getQueryValue(pta, queries[q], solved);
+    if (!budget.nextPass(value))
+      break;
+    ContextCond::setMaxCxtLen(budget.getCxtLimit());
+    if (solved)
+      pta->resetDDAPass();
+    solveQueries(pta, queries, clusterOf);
+    solved = true;
+
+    std::vector<NodeID> next;
+    std::vector<u32_t> nextClusters;
+    for (u32_t q = 0; q < queries.size(); q++) {
+      if (improvableQueries.test(queries[q])) {
+        next.push_back(queries[q]);
+        nextClusters.push_back(clusterOf[q]);
+      }
+    }
+    queries.swap(next);
+    clusterOf.swap(nextClusters);
+  }
+  llvm::outs() << "[OS-CFI] Anytime analysis ran " << budget.getNumOfPasses()
+               << " passes up to context limit " << budget.getCxtLimit()
+               << " in " << budget.getElapsed() << "s, "
+               << truncatedQueries.count() << " queries ran out of budget\n";
+  ContextCond::setMaxCxtLen(maxCxt);
+  pta->setDDAQueryTimeout(-1);
+  anytimeBudget = NULL;
+}
+
+// [OS-CFI] getAnytimeMode(): an anytime analysis only caches final answers,
+// which the context limit of a deepening pass may still change
+std::string DDAClient::getAnytimeMode() {
+  if (DDATimeBudget <= 0 && DDAMemBudget == 0)
+    return "off";
+  return DDADeepen ? "deepen" : "fixed";
+}
+
+// [OS-CFI] lookupQuery(): a deepening pass refines answers that were not
+// cached, so only the first pass consults the cache
+bool DDAClient::lookupQuery(NodeID id) {
+  if (queryCache == NULL || (anytimeBudget && anytimeBudget->isDeepening()))
+    return false;
+  return queryCache->lookup(id);
+}
+
+// [OS-CFI] solveQuery(): a query of an anytime analysis is limited to its
+// slice of the budget. A deepening pass keeps the answer of the pass before
+// if the query runs out of budget again.
+bool DDAClient::solveQuery(PointerAnalysis *pta, NodeID id) {
+  if (anytimeBudget == NULL) {
+    pta->computeDDAPts(id);
+    return pta->isDDAQueryOutOfBudget();
+  }
+  bool deepening = anytimeBudget->isDeepening();
+  pta->setDDAQueryTimeout(
+      anytimeBudget->getQueryTimeout(getQueryValue(pta, id, deepening)));
+  if (!deepening) {
+    pta->computeDDAPts(id);
+    return pta->isDDAQueryOutOfBudget();
+  }
+
+  PointsTo pts;
+  pta->getDDAQueryPts(id, pts);
+  const OriginSensitiveTupleSet *opts = pta->getOriginSensitiveTupleSet(id);
+  const CallStackSet *cspts = pta->getCSSensitiveSet(id);
+  OriginSensitiveTupleSet *prevOpts =
+      opts ? new OriginSensitiveTupleSet(*opts) : new OriginSensitiveTupleSet();
+  CallStackSet *prevCspts =
+      cspts ? new CallStackSet(*cspts) : new CallStackSet();
+  NodeBS slice;
+  bool complete = pta->getDDAQuerySlice(id, slice);
+  const SVFGNode *node = pta->getSVFGForCandidateNode(id);
+
+  pta->resetDDAQueryResult(id);
+  pta->computeDDAPts(id);
+  if (!pta->isDDAQueryOutOfBudget()) {
+    delete prevOpts;
+    delete prevCspts;
+    return false;
+  }
+  pta->resetDDAQueryResult(id);
+  pta->setDDAQueryResult(id, node, pts, prevOpts, prevCspts);
+  pta->setDDAQuerySlice(id, slice, complete);
+  return true;
+}
+
+// [OS-CFI] finishQuery(): outside an anytime analysis every answer is
+// cached. An anytime answer is cached once it is final, that is neither cut
+// short by the budget nor open to a deeper context limit.
+void DDAClient::finishQuery(PointerAnalysis *pta, NodeID id, bool truncated) {
+  if (anytimeBudget) {
+    bool improvable = !truncated && !anytimeBudget->isFinalPass() &&
+                      getQueryValue(pta, id, true) > 1;
+    if (improvable)
+      improvableQueries.set(id);
+    else
+      improvableQueries.reset(id);
+    if (truncated)
+      truncatedQueries.set(id);
+    if (truncated || improvable)
+      return;
+  }
+  if (queryCache) {
+    queryCache->record(id);
+    queryCache->checkpoint();
+  }
+}
+
+static u32_t findCluster(std::vector<u32_t> &parent, u32_t q) {
+  while (parent[q] != q) {
+    parent[q] = parent[parent[q]];
+    q = parent[q];
+  }
+  return q;
+}
+
+// [OS-CFI] scheduleQueries(): every candidate visits a bounded number of its
+// SVFG ancestors breadth first, and two candidates reaching a common ancestor
+// join one cluster. Clusters keep the position of their first candidate and
+// a cluster's candidates keep their relative order, so the schedule is
+// deterministic. A cluster is named by its first candidate in the schedule.
+void DDAClient::scheduleQueries(PointerAnalysis *pta,
+                                std::vector<NodeID> &queries,
+                                std::vector<u32_t> &clusterOf) {
+  PAG *pag = pta->getPAG();
+  queries.clear();
   for (NodeSet::iterator nIter = candidateQueries.begin();
-       nIter != candidateQueries.end(); ++nIter, ++count) {
-    PAGNode *node = pta->getPAG()->getPAGNode(*nIter);
-    if (pta->getPAG()->isValidTopLevelPtr(node)) {
-      DBOUT(DGENERAL, outs() << "\n@@Computing PointsTo for :" << node->getId()
-                             << " [" << count + 1 << "/"
-                             << candidateQueries.size() << "]"
-                             << " \n");
-      DBOUT(DDDA, outs() << "\n@@Computing PointsTo for :" << node->getId()
-                         << " [" << count + 1 << "/" << candidateQueries.size()
-                         << "]"
-                         << " \n");
-      setCurrentQueryPtr(node->getId());
-      pta->computeDDAPts(node->getId());
+       nIter != candidateQueries.end(); ++nIter) {
+    if (pag->isValidTopLevelPtr(pag->getPAGNode(*nIter)))
+      queries.push_back(*nIter);
+  }
+
+  std::vector<u32_t> parent(queries.size());
+  for (u32_t q = 0; q < queries.size(); q++)
+    parent[q] = q;
+
+  SVFG *svfg = pta->getDDASVFG();
+  if (DDASchedule && svfg) {
+    llvm::DenseMap<NodeID, u32_t> ancestorOwner;
+    for (u32_t q = 0; q < queries.size(); q++) {
+      std::vector<const SVFGNode *> worklist(
+          1, svfg->getDefSVFGNode(pag->getPAGNode(queries[q])));
+      NodeBS visited;
+      visited.set(worklist[0]->getId());
+      for (u32_t i = 0; i < worklist.size() && i < DDAScheduleNodes; i++) {
+        const SVFGNode *cur = worklist[i];
+        std::pair<llvm::DenseMap<NodeID, u32_t>::iterator, bool> owner =
+            ancestorOwner.insert(std::make_pair(cur->getId(), q));
+        if (!owner.second) {
+          u32_t lhs = findCluster(parent, q);
+          u32_t rhs = findCluster(parent, owner.first->second);
+          parent[std::max(lhs, rhs)] = std::min(lhs, rhs);
+        }
+        for (SVFGNode::const_iterator it = cur->InEdgeBegin(),
+                                      eit = cur->InEdgeEnd();
+             it != eit; ++it) {
+          if (visited.test_and_set((*it)->getSrcID()))
+            worklist.push_back((*it)->getSrcNode());
+        }
+      }
+    }
+  }
+
+  std::vector<std::pair<u32_t, u32_t>> order(queries.size());
+  for (u32_t q = 0; q < queries.size(); q++)
+    order[q] = std::make_pair(findCluster(parent, q), q);
+  std::sort(order.begin(), order.end());
+
+  std::vector<NodeID> scheduled(queries.size());
+  clusterOf.resize(queries.size());
+  for (u32_t q = 0; q < order.size(); q++) {
+    scheduled[q] = queries[order[q].second];
+    clusterOf[q] = (q > 0 && order[q].first == order[q - 1].first)
+                       ? clusterOf[q - 1]
+                       : q;
+  }
+  queries.swap(scheduled);
+}
+
+// [OS-CFI] answerQueriesInWorkers(): the solver grows the PAG, the SVFG and
+// the call graph while it answers a query, so the workers are processes
+// rather than threads. The candidates are cut into shards in schedule order:
+// a shard takes whole clusters while they fit and a larger cluster is cut
+// into full shards. Each shard is solved by a worker forked from the same
+// copy-on-write image of the solver, at most jobs of them at a time, which
+// spills its results into an anonymous file. The parent installs the results
+// in schedule order once every worker is done, so the CFGs only depend on the
+// candidate set and the shard size. A shard whose worker could not be forked,
+// or which ended early, is solved in the parent. Candidates answered by the
+// query cache are installed before forking.
+void DDAClient::answerQueriesInWorkers(PointerAnalysis *pta,
+                                       const std::vector<NodeID> &candidates,
+                                       const std::vector<u32_t> &clusterOf,
+                                       u32_t jobs) {
+  PAG *pag = pta->getPAG();
+  NodeID lastID = pag->getPAGNodeNum();
+  std::vector<NodeID> queries;
+  std::vector<u32_t> clusters;
+  for (u32_t c = 0; c < candidates.size(); c++) {
+    setCurrentQueryPtr(candidates[c]);
+    if (!lookupQuery(candidates[c])) {
+      queries.push_back(candidates[c]);
+      clusters.push_back(clusterOf[c]);
+    }
+  }
+  if (queries.empty())
+    return;
+
+  // shards in schedule order, at most MaxShards of them stay open at once
+  const u32_t MaxShards = 256;
+  u32_t shardSize = std::max<u32_t>(
+      std::max<u32_t>(DDAShardSize, 1),
+      (queries.size() + MaxShards - 1) / MaxShards);
+  std::vector<u32_t> clusterEnd(queries.size());
+  for (u32_t q = queries.size(); q-- > 0;) {
+    bool last = q + 1 == queries.size() || clusters[q + 1] != clusters[q];
+    clusterEnd[q] = last ? q + 1 : clusterEnd[q + 1];
+  }
+  std::vector<u32_t> shardOf(queries.size());
+  u32_t numShards = 0;
+  u32_t size = 0;
+  for (u32_t q = 0; q < queries.size(); q++) {
+    bool newCluster = q == 0 || clusters[q] != clusters[q - 1];
+    if (q == 0 || size == shardSize ||
+        (newCluster && size + clusterEnd[q] - q > shardSize)) {
+      numShards++;
+      size = 0;
+    }
+    shardOf[q] = numShards - 1;
+    size++;
+  }
+
+  llvm::outs().flush();
+  llvm::errs().flush();
+
+  std::vector<FILE *> shards(numShards, (FILE *)NULL);
+  std::vector<pid_t> workers(numShards, -1);
+  std::vector<bool> solved(numShards, false);
+  u32_t running = 0;
+  for (u32_t shard = 0; shard < numShards || running > 0;) {
+    if (shard < numShards && running < jobs) {
+      shards[shard] = tmpfile();
+      if (shards[shard] != NULL)
+        workers[shard] = fork();
+      if (workers[shard] == 0) {
+        if (anytimeBudget) {
+          u64_t value = 0;
+          for (u32_t q = 0; q < queries.size(); q++) {
+            if (shardOf[q] == shard)
+              value += getQueryValue(pta, queries[q],
+                                     anytimeBudget->isDeepening());
+          }
+          anytimeBudget->setPassValue(value);
+        }
+        NodeBS truncated;
+        for (u32_t q = 0; q < queries.size(); q++) {
+          if (shardOf[q] != shard)
+            continue;
+          setCurrentQueryPtr(queries[q]);
+          if (solveQuery(pta, queries[q]))
+            truncated.set(queries[q]);
+        }
+        for (u32_t q = 0; q < queries.size(); q++) {
+          if (shardOf[q] == shard)
+            writeQueryResult(shards[shard], pta, queries[q], lastID,
+                             truncated.test(queries[q]));
+        }
+        llvm::outs().flush();
+        _exit(fflush(shards[shard]) == 0 ? 0 : 1);
+      }
+      if (workers[shard] > 0)
+        running++;
+      shard++;
+      continue;
+    }
+
+    // all jobs are busy, or every shard has been handed out
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0)
+      break;
+    std::vector<pid_t>::iterator it =
+        std::find(workers.begin(), workers.end(), pid);
+    if (it == workers.end())
+      continue;
+    running--;
+    solved[it - workers.begin()] =
+        WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+
+  for (u32_t shard = 0; shard < numShards; shard++) {
+    if (solved[shard]) {
+      rewind(shards[shard]);
+      continue;
     }
+    wrnMsg("query worker " + std::to_string(shard) +
+           " failed, solving its shard in place");
+    if (shards[shard])
+      fclose(shards[shard]);
+    shards[shard] = NULL;
+  }
+
+  for (u32_t q = 0; q < queries.size(); q++) {
+    FILE *fp = shards[shardOf[q]];
+    DBOUT(DGENERAL, outs() << "\n@@Merging PointsTo for :" << queries[q] << " ["
+                           << q + 1 << "/" << queries.size() << "]"
+                           << " \n");
+    setCurrentQueryPtr(queries[q]);
+    bool replace = anytimeBudget && anytimeBudget->isDeepening();
+    bool truncated = false;
+    if (fp &&
+        readQueryResult(fp, pta, queries[q], lastID, replace, truncated)) {
+      finishQuery(pta, queries[q], truncated);
+      continue;
+    }
+    if (fp) {
+      fclose(fp);
+      shards[shardOf[q]] = NULL;
+    }
+    truncated = solveQuery(pta, queries[q]);
+    finishQuery(pta, queries[q], truncated);
+  }
+
+  for (u32_t shard = 0; shard < numShards; shard++) {
+    if (shards[shard])
+      fclose(shards[shard]);
   }
 }
 
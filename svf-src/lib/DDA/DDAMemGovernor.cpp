@@ -0,0 +1,228 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "DDA/DDAMemGovernor.h"
+#include "Util/AnalysisUtil.h"
+#include <algorithm>
+#include <llvm/Support/CommandLine.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace analysisUtil;
+
+// [OS-CFI] the solver caches are cut down to keep the process under the
+// ceiling, the SVFG itself is never evicted
+static cl::opt<unsigned> DDARSSLimit(
+    "dda-rss-limit", cl::init(0),
+    cl::desc("Megabytes of resident memory the DDA solver caches are kept "
+             "under, 0 if unlimited"));
+
+static cl::opt<bool>
+    DDASpill("dda-spill", cl::init(false),
+             cl::desc("Spill evicted DDA solver cache entries to a temporary "
+                      "file instead of dropping them"));
+
+/// Fewest cached dpms the solver is limited to
+static const u32_t MinCacheLimit = 1024;
+/// Smallest spill file worth compacting
+static const u64_t MinCompactSize = 64 << 20;
+
+/*!
+ * Constructor
+ */
+DDAMemGovernor::DDAMemGovernor()
+    : limited(false), cacheLimit(0), spillFile(NULL), spillPid(getpid()),
+      spillSize(0), liveWords(0), mapping(NULL), mappedSize(0) {
+  if (DDASpill) {
+    spillFile = tmpfile();
+    if (spillFile == NULL)
+      wrnMsg("cannot create the DDA spill file, evicted dpms are dropped");
+  }
+}
+
+/*!
+ * Destructor
+ */
+DDAMemGovernor::~DDAMemGovernor() {
+  if (mapping)
+    munmap(mapping, mappedSize);
+  if (spillFile)
+    fclose(spillFile);
+}
+
+bool DDAMemGovernor::isEnabled() { return DDARSSLimit > 0; }
+
+/*!
+ * The limit shrinks to half of the cached dpms every time the ceiling is
+ * found exceeded, never below MinCacheLimit, and doubles every time the
+ * resident set is under three quarters of the ceiling until it no longer
+ * limits anything
+ */
+bool DDAMemGovernor::getCacheLimit(u32_t numOfCached, u32_t &limit) {
+  u32_t vmrss = 0, vmsize = 0;
+  if (!getMemoryUsageKB(&vmrss, &vmsize)) {
+    // keep the last limit
+  } else if (vmrss / 1024 >= DDARSSLimit) {
+    u32_t half = std::max(numOfCached / 2, MinCacheLimit);
+    cacheLimit = limited ? std::min(cacheLimit, half) : half;
+    limited = true;
+  } else if (limited && vmrss / 1024 < DDARSSLimit / 4 * 3) {
+    if (cacheLimit >= numOfCached)
+      limited = false;
+    else
+      cacheLimit = std::min<u64_t>((u64_t)cacheLimit * 2, numOfCached);
+  }
+  if (!limited || numOfCached <= cacheLimit)
+    return false;
+  limit = cacheLimit;
+  return true;
+}
+
+void DDAMemGovernor::release() { malloc_trim(0); }
+
+/*!
+ * A forked worker shares the file offset bookkeeping of its parent as of the
+ * fork, so its appends would overwrite those of its siblings
+ */
+bool DDAMemGovernor::isSpilling() const {
+  return spillFile != NULL && spillPid == getpid();
+}
+
+bool DDAMemGovernor::spill(const Words &words, u64_t &offset) {
+  size_t bytes = words.size() * sizeof(u64_t);
+  if (!isSpilling() ||
+      pwrite(fileno(spillFile), words.data(), bytes, spillSize) !=
+          (ssize_t)bytes)
+    return false;
+  offset = spillSize / sizeof(u64_t);
+  spillSize += bytes;
+  liveWords += words.size();
+  return true;
+}
+
+void DDAMemGovernor::discardAll() {
+  if (!isSpilling())
+    return;
+  if (mapping)
+    munmap(mapping, mappedSize);
+  mapping = NULL;
+  mappedSize = 0;
+  spillSize = 0;
+  liveWords = 0;
+}
+
+bool DDAMemGovernor::needsCompaction() const {
+  return isSpilling() && spillSize >= MinCompactSize &&
+         spillSize / sizeof(u64_t) > 2 * liveWords;
+}
+
+/*!
+ * The entries are copied one by one, the old file is kept if anything fails
+ */
+bool DDAMemGovernor::compact(const std::vector<Entry *> &entries) {
+  if (!isSpilling())
+    return false;
+  FILE *file = tmpfile();
+  if (file == NULL)
+    return false;
+  std::vector<u64_t> offsets;
+  offsets.reserve(entries.size());
+  u64_t size = 0;
+  for (u32_t i = 0; i < entries.size(); i++) {
+    size_t bytes = entries[i]->second * sizeof(u64_t);
+    const u64_t *words = load(entries[i]->first, entries[i]->second);
+    if (words == NULL ||
+        pwrite(fileno(file), words, bytes, size) != (ssize_t)bytes) {
+      fclose(file);
+      return false;
+    }
+    offsets.push_back(size / sizeof(u64_t));
+    size += bytes;
+  }
+  for (u32_t i = 0; i < entries.size(); i++)
+    entries[i]->first = offsets[i];
+  if (mapping)
+    munmap(mapping, mappedSize);
+  mapping = NULL;
+  mappedSize = 0;
+  fclose(spillFile);
+  spillFile = file;
+  spillSize = size;
+  liveWords = size / sizeof(u64_t);
+  return true;
+}
+
+/*!
+ * The mapping is widened to the whole file when an entry lies beyond it,
+ * which invalidates the words returned before
+ */
+const u64_t *DDAMemGovernor::load(u64_t offset, u64_t num) {
+  if ((offset + num) * sizeof(u64_t) > mappedSize) {
+    if (mapping)
+      munmap(mapping, mappedSize);
+    mapping = mmap(NULL, spillSize, PROT_READ, MAP_SHARED, fileno(spillFile),
+                   0);
+    mappedSize = spillSize;
+    if (mapping == MAP_FAILED) {
+      mapping = NULL;
+      mappedSize = 0;
+      return NULL;
+    }
+  }
+  return (const u64_t *)mapping + offset;
+}
+
+void DDAMemGovernor::encode(const PointsTo &pts, Words &words) {
+  words.push_back(pts.count());
+  for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it)
+    words.push_back(*it);
+}
+
+/*!
+ * A conditional variable is spilled as its id, whether its context is
+ * concrete, and the call-sites of its context
+ */
+void DDAMemGovernor::encode(const CxtPtSet &pts, Words &words) {
+  words.push_back(pts.count());
+  for (CxtPtSet::const_iterator it = pts.begin(), eit = pts.end(); it != eit;
+       ++it) {
+    const CallStrCxt &cxt = it->get_cond().getContexts();
+    words.push_back(it->get_id());
+    words.push_back(it->get_cond().isConcreteCxt());
+    words.push_back(cxt.size());
+    words.insert(words.end(), cxt.begin(), cxt.end());
+  }
+}
+
+bool DDAMemGovernor::decode(const u64_t *words, u64_t num, PointsTo &pts) {
+  if (num == 0 || words[0] != num - 1)
+    return false;
+  for (u64_t i = 1; i < num; i++)
+    pts.set(words[i]);
+  return true;
+}
+
+bool DDAMemGovernor::decode(const u64_t *words, u64_t num, CxtPtSet &pts) {
+  if (num == 0)
+    return false;
+  u64_t pos = 1;
+  for (u64_t i = 0; i < words[0]; i++) {
+    if (pos + 3 > num)
+      return false;
+    const u64_t *cxt = words + pos + 3;
+    u64_t cxtSize = words[pos + 2];
+    if (pos + 3 + cxtSize > num)
+      return false;
+    ContextCond cond;
+    if (!words[pos + 1])
+      cond.setNonConcreteCxt();
+    cond.getContexts().assign(cxt, cxt + cxtSize);
+    pts.set(CxtVar(cond, words[pos]));
+    pos += 3 + cxtSize;
+  }
+  return pos == num;
+}
@@ -6,8 +6,11 @@
 #include "DDA/DDAPass.h"
 #include "DDA/ContextDDA.h"
 #include "DDA/DDAClient.h"
+#include "DDA/DDAQueryCache.h"
 #include "DDA/FlowDDA.h"
+#include "DDA/MDPlacement.h"
 #include "MemoryModel/PointerAnalysis.h"
+#include "WPA/Andersen.h"
 #include <limits.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/Support/CommandLine.h>
@@ -43,6 +46,21 @@ static cl::opt<bool>
     printQueryPts("print-query-pts", cl::init(false),
                   cl::desc("Dump queries' conditional points-to set "));
 
+// [OS-CFI] answers of unchanged queries are reused across runs
+static cl::opt<std::string>
+    DDACache("dda-cache", cl::init(""),
+             cl::desc("File caching SUPA query results between runs"));
+
+// [OS-CFI] the CFGs are streamed to this file as they are computed
+static cl::opt<std::string>
+    CFGOut("cfg-out", cl::init("cfg.bin"),
+           cl::desc("File the computed CFGs are streamed to"));
+
+// [OS-CFI] origins and call-points whose metadata stays in its thread
+static cl::opt<std::string>
+    TLOut("tl-out", cl::init("tlMD.bin"),
+          cl::desc("File the thread-local metadata accesses are written to"));
+
 static cl::opt<bool> WPANUM("wpanum", cl::init(false),
                             cl::desc("collect WPA FS number only "));
 
@@ -61,6 +79,8 @@ static cl::bits<PointerAnalysis::PTATY> DDASelected(
 
 DDAPass::~DDAPass() {
   // _pta->dumpStat();
+  if (cfgStream != NULL)
+    delete cfgStream;
   if (_client != NULL)
     delete _client;
 }
@@ -90,6 +110,12 @@ bool DDAPass::runOnModule(SVFModule module) {
       }
     }
   }
+  // [OS-CFI] index them by signature once, a fallback is a single lookup
+  for (FuncSetIt it = setAddrFunc.begin(); it != setAddrFunc.end(); ++it) {
+    mapSigAddrFunc[getSignature(*it)].push_back(*it);
+    if ((*it)->arg_size() == 0)
+      mapSigAddrFunc[nullptr].push_back(*it);
+  }
 
   selectClient(module);
 
@@ -168,18 +194,30 @@ void DDAPass::runPointerAnalysis(SVFModule module, u32_t kind) {
     if (printQueryPts)
       printQueryPTS();
 
-    // [OS-CFI] SUPA completes process and it is time to compute our CFGs
+    // [OS-CFI] SUPA completes process and it is time to compute our CFGs,
+    // every query's entries are streamed out as soon as they are computed
+    cfgStream = new CFGStreamWriter(CFGOut);
     computeCFG(module);
+    outs() << "[OS-CFI] Streamed " << cfgStream->getNumOfRecords()
+           << " CFG entries to '" << CFGOut << "'\n";
+    delete cfgStream;
+    cfgStream = NULL;
+
+    // [OS-CFI] the metadata of pointers stored in thread-local objects does
+    // not have to go through the shared MPX table
+    MDPlacement placement(module,
+                          AndersenWaveDiff::createAndersenWaveDiff(module));
+    placement.classify();
+    if (!placement.write(TLOut))
+      analysisUtil::wrnMsg("cannot write the thread-local metadata to '" +
+                           TLOut + "'");
+    outs() << "[OS-CFI] " << placement.getNumOfLocalAccesses() << " of "
+           << placement.getNumOfAccesses()
+           << " metadata accesses are thread-local\n";
 
     // [OS-CFI] Process the labeling
     createLabelForCS();
     createLabelForValue(module);
-
-    // [OS-CFI] print out our CFGs
-    dumpSUPACFG();
-    dumpoCFG();
-    dumpcCFG();
-    dumpatCFG();
   }
 }
 
@@ -194,8 +232,34 @@ void DDAPass::answerQueries(PointerAnalysis *pta) {
   analysisUtil::getMemoryUsageKB(&vmrss, &vmsize);
   stat->setMemUsageBefore(vmrss, vmsize);
 
+  DDAQueryCache *cache = NULL;
+  if (!DDACache.empty() && pta->getAnalysisTy() == PointerAnalysis::Cxt_DDA) {
+    // [OS-CFI] the answers depend on every limit the solver ran under
+    std::string settings =
+        "maxcxt=" + std::to_string(maxContextLen) +
+        " maxpath=" + std::to_string(maxPathLen) +
+        " cxtbg=" + std::to_string(ContextDDA::getCxtBudget()) +
+        " flowbg=" + std::to_string(FlowDDA::getFlowBudget()) +
+        " inrecur=" + std::to_string(insenRecur) +
+        " incycle=" + std::to_string(insenCycle) +
+        " anytime=" + DDAClient::getAnytimeMode();
+    cache = new DDAQueryCache(DDACache, settings, pta,
+                              static_cast<ContextDDA *>(pta)->getSVFG());
+    cache->load();
+    _client->setQueryCache(cache);
+  }
+
   _client->answerQueries(pta);
 
+  if (cache) {
+    cache->save();
+    llvm::outs() << "[OS-CFI] Query cache answered " << cache->getNumOfHits()
+                 << " queries and recorded " << cache->getNumOfRecords()
+                 << "\n";
+    _client->setQueryCache(NULL);
+    delete cache;
+  }
+
   vmrss = vmsize = 0;
   analysisUtil::getMemoryUsageKB(&vmrss, &vmsize);
   stat->setMemUsageAfter(vmrss, vmsize);
@@ -388,66 +452,45 @@ void DDAPass::labelForCSite(const llvm::Instruction *callInst,
   mapInstID[iInst] = id;
 }
 
-// [OS-CFI] ToDo
+// [OS-CFI] createLabelForCS(): the label of a context call-site is its return
+// address. The call carries !oscfi.cs.label with a hidden declaration the
+// code generator defines right after the call, so the label survives any
+// optimization and needs no block of its own. A labeled call is never a tail
+// call. The (tag, label) pairs still go to <function>@labelTracker.
 void DDAPass::createLabelForCS() {
-  std::hash<std::string> hash_fn;
   for (FuncToInstSetMapIt fit = mapFnCSite.begin(); fit != mapFnCSite.end();
        ++fit) {
-    Function *FN = fit->first;
-    for (Function::iterator b = FN->begin(), be = FN->end(); b != be; ++b) {
-      BasicBlock &iBB = *b;
-      for (BasicBlock::reverse_iterator i = b->rbegin(), ie = b->rend();
-           i != ie; ++i) {
-        Instruction &inst = *i;
-        if (fit->second.find(&inst) != fit->second.end()) {
-          BasicBlock *nBB = BasicBlock::Create(FN->getContext(), "", FN, &iBB);
-          iBB.replaceSuccessorsPhiUsesWith(nBB);
-          mapFnBB[FN].insert(nBB);
-
-          mapBBID[nBB] = mapInstID[&inst];
-
-          // create branch instruction to new basic block
-          IRBuilder<> iBuilder(&iBB);
-          BranchInst *iBr = iBuilder.CreateBr(nBB);
-
-          // move the branch instruction before the next instruction of call
-          // instruction
-          iBr->moveAfter(&inst);
-
-          nBB->moveAfter(&iBB);
-        }
-      }
-    }
-  }
-
-  for (FuncToBBSetMapIt fit = mapFnBB.begin(); fit != mapFnBB.end(); ++fit) {
     Function *fn = fit->first;
-
-    BasicBlock *nBB = BasicBlock::Create(fn->getContext(), "", fn, nullptr);
-    IRBuilder<> iBuilder(nBB);
-
-    unsigned int nBr = fit->second.size();
+    Module *M = fn->getParent();
+    LLVMContext &C = fn->getContext();
+    NamedMDNode *labels = M->getOrInsertNamedMetadata("oscfi.cs.labels");
 
     // integer pointet type
-    PointerType *int8PtTy = Type::getInt8PtrTy(fn->getContext());
-    IntegerType *int64Ty = Type::getInt64Ty(fn->getContext());
+    PointerType *int8PtTy = Type::getInt8PtrTy(C);
+    IntegerType *int64Ty = Type::getInt64Ty(C);
 
-    // create the indirect branch
-    Value *udef = llvm::UndefValue::get(int8PtTy);
-    IndirectBrInst *iBr = iBuilder.CreateIndirectBr(udef, nBr);
-
-    // list the BlockAddress from BasicBlock
     std::vector<Constant *> listBA;
-    for (std::set<llvm::BasicBlock *>::iterator it = fit->second.begin();
+    for (std::set<Instruction *>::iterator it = fit->second.begin();
          it != fit->second.end(); ++it) {
-      iBr->addDestination(*it);
-      BlockAddress *bba = BlockAddress::get(fn, *it);
-
-      Constant *tag_id = ConstantInt::get(int64Ty, mapBBID[*it], false);
+      Instruction *inst = *it;
+      unsigned long id = mapInstID[inst];
+
+      GlobalVariable *label = new GlobalVariable(
+          *M, Type::getInt8Ty(C), true, GlobalValue::ExternalLinkage, nullptr,
+          "__oscfi_cs_" + std::to_string(id));
+      label->setVisibility(GlobalValue::HiddenVisibility);
+      MDNode *md = MDNode::get(C, ConstantAsMetadata::get(label));
+      inst->setMetadata("oscfi.cs.label", md);
+      labels->addOperand(md);
+      if (CallInst *call = dyn_cast<CallInst>(inst))
+        if (!call->isMustTailCall())
+          call->setTailCallKind(CallInst::TCK_NoTail);
+
+      Constant *tag_id = ConstantInt::get(int64Ty, id, false);
       Constant *tag = ConstantFolder().CreateIntToPtr(tag_id, int8PtTy);
 
       listBA.push_back(tag);
-      listBA.push_back(bba);
+      listBA.push_back(label);
     }
     ArrayRef<Constant *> blockArray(listBA);
 
@@ -457,12 +500,11 @@ void DDAPass::createLabelForCS() {
 
     // Global Variable Declarations
     GlobalVariable *gvar_ptr_abc =
-        new GlobalVariable(*fn->getParent(), blockItems->getType(), true,
+        new GlobalVariable(*M, blockItems->getType(), true,
                            GlobalValue::InternalLinkage, blockItems,
                            fn->getName().str() + "@labelTracker");
     gvar_ptr_abc->setAlignment(16);
     gvar_ptr_abc->setSection("cfg_label_tracker");
-    gvar_ptr_abc->addAttribute(llvm::Attribute::OptimizeNone);
   }
 }
 
@@ -502,78 +544,69 @@ void DDAPass::createLabelForValue(SVFModule SM) {
   gvar_target_data->setSection("cfg_label_tracker");
 }
 
+// [OS-CFI] getSignature(): the parameter and return types of a function, as a
+// non-variadic function type uniqued by the context
+const FunctionType *DDAPass::getSignature(const Function *fn) {
+  FunctionType *fnTy = fn->getFunctionType();
+  if (!fnTy->isVarArg())
+    return fnTy;
+  return FunctionType::get(fnTy->getReturnType(), fnTy->params(), false);
+}
+
+// [OS-CFI] getSignature(): the return type of a call and the types of its
+// arguments, variadic ones included, computed once per sink
+const FunctionType *DDAPass::getSignature(const Instruction *sink) {
+  InstToSigMap::iterator it = mapInstSig.find(sink);
+  if (it != mapInstSig.end())
+    return it->second;
+
+  const FunctionType *sig = nullptr;
+  vector<Type *> argList;
+  if (const CallInst *cBase = dyn_cast<CallInst>(sink)) {
+    for (unsigned i = 0; i < cBase->getNumArgOperands(); i++)
+      argList.push_back(cBase->getArgOperand(i)->getType());
+    sig = FunctionType::get(cBase->getFunctionType()->getReturnType(),
+                            argList, false);
+  } else if (const InvokeInst *cBase = dyn_cast<InvokeInst>(sink)) {
+    for (unsigned i = 0; i < cBase->getNumArgOperands(); i++)
+      argList.push_back(cBase->getArgOperand(i)->getType());
+    sig = FunctionType::get(cBase->getFunctionType()->getReturnType(),
+                            argList, false);
+  }
+  mapInstSig[sink] = sig;
+  return sig;
+}
+
 // [OS-CFI] isTypeMatch(): return true if params/args and return types matched
-// between an indirect call and a function signature
+// between an indirect call and a function signature, a sink that is not a
+// call matches the functions without parameter
 bool DDAPass::isTypeMatch(const Instruction *sink, const Value *source) {
-  int nFnArg = 0, nCallArg = 0;
-  vector<const Type *> fnArgList, callArgList;
-  if (isa<Function>(source)) {
-    const Function *fn = dyn_cast<Function>(source);
-    const Type *rTy = fn->getReturnType();
-    nFnArg = fn->arg_size();
-    for (Function::const_arg_iterator AI = fn->arg_begin(), AE = fn->arg_end();
-         AI != AE; ++AI) {
-      const Value *arg = AI;
-      const Type *argType = arg->getType();
-      fnArgList.push_back(argType);
-    }
-    if (isa<CallInst>(sink)) {
-      const CallInst *cBase = dyn_cast<CallInst>(sink);
-      if (cBase->getFunctionType()->getReturnType() != rTy) {
-        return false;
-      }
-      nCallArg = cBase->getNumArgOperands();
-      for (int i = 0; i < cBase->getNumArgOperands(); i++) {
-        const Value *arg = cBase->getArgOperand(i);
-        const Type *argType = arg->getType();
-        callArgList.push_back(argType);
-      }
-    } else if (isa<InvokeInst>(sink)) {
-      const InvokeInst *cBase = dyn_cast<InvokeInst>(sink);
-      if (cBase->getFunctionType()->getReturnType() != rTy) {
-        return false;
-      }
-      nCallArg = cBase->getNumArgOperands();
-      for (int i = 0; i < cBase->getNumArgOperands(); i++) {
-        const Value *arg = cBase->getArgOperand(i);
-        const Type *argType = arg->getType();
-        callArgList.push_back(argType);
-      }
-    }
-
-    if (nFnArg == nCallArg) {
-      for (int i = 0; i < nFnArg; i++) {
-        if (fnArgList[i] != callArgList[i]) {
-          return false;
-        }
-      }
-      return true;
-    }
-  } else {
+  if (!isa<Function>(source))
     return true;
-  }
-  return false;
+  const Function *fn = cast<Function>(source);
+  const FunctionType *sig = getSignature(sink);
+  if (sig == nullptr)
+    return fn->arg_size() == 0;
+  return sig == getSignature(fn);
 }
 
 // [OS-CFI] use address-taken type check entry for SUPA points-to set empty
 // sinks
 void DDAPass::fillEmptyPointsToSet(const Instruction *iCallInst) {
-  string str;
-  for (FuncSetIt it = setAddrFunc.begin(); it != setAddrFunc.end(); ++it) {
-    Function *val = *it;
-    if (isTypeMatch(iCallInst, val)) {
-      atCFG *atItem = (atCFG *)malloc(sizeof(atCFG));
-      atItem->type = UNDER_APPROXIMATE;
-      atItem->iCallInst = iCallInst;
-      atItem->iCallID = getHashID(iCallInst);
-      atItem->iCallTarget = val;
-      atItem->iCallTargetID = val->getValueID();
-      atCFGList.push_back(atItem);
-    }
+  SigToFuncVecMap::const_iterator it =
+      mapSigAddrFunc.find(getSignature(iCallInst));
+  if (it == mapSigAddrFunc.end())
+    return;
+  for (vector<Function *>::const_iterator fit = it->second.begin();
+       fit != it->second.end(); ++fit) {
+    Function *val = *fit;
+    emitatCFG(UNDER_APPROXIMATE, iCallInst, getHashID(iCallInst), val,
+              val->getValueID());
   }
 }
 
-// [OS-CFI] computeCFG(): prepares the CFG listings from SUPA analysis
+// [OS-CFI] computeCFG(): streams the CFG entries from SUPA analysis, one
+// query at a time
 void DDAPass::computeCFG(SVFModule M) {
   // get candidate queries
   const NodeSet &candidates = _client->getCandidateQueries();
@@ -687,23 +720,15 @@ void DDAPass::computeCFG(SVFModule M) {
                 }
               }
 
-              oCFG *oItem = (oCFG *)malloc(sizeof(oCFG));
-              oItem->iCallInst = iCallInst;
-              oItem->iCallID = iCallID;
-              oItem->iCallTarget = _pta->getValueFromNodeID(*pit);
-              oItem->iCallTargetID = *pit;
-              oItem->originID = originID;
-              if (std::get<2>(*oit)) {
-                oItem->originCTXInst = std::get<2>(*oit);
-                oItem->originCTXID = getHashID(std::get<2>(*oit));
-                labelForCSite(std::get<2>(*oit),
-                              getHashID(std::get<2>(
-                                  *oit))); // [OS-CFI] we need a label for
-                                           // origin context call-site
-              } else {
-                oItem->originCTXInst = nullptr;
+              const Instruction *originCTXInst = std::get<2>(*oit);
+              if (originCTXInst) {
+                labelForCSite(
+                    originCTXInst,
+                    getHashID(originCTXInst)); // [OS-CFI] we need a label for
+                                               // origin context call-site
               }
-              oCFGList.push_back(oItem);
+              emitoCFG(iCallInst, iCallID, _pta->getValueFromNodeID(*pit),
+                       *pit, originID, originCTXInst);
             }
           }
         }
@@ -725,21 +750,11 @@ void DDAPass::computeCFG(SVFModule M) {
               CallSwitchPairStack tcStack(csit->second);
 
               if (!tcStack.empty()) {
-                cCFG *cItem = (cCFG *)malloc(sizeof(cCFG));
-
-                cItem->iCallInst = iCallInst;
-                cItem->iCallID = iCallID;
-
-                cItem->iCallTarget = _pta->getValueFromNodeID(*pit);
-                cItem->iCallTargetID = *pit;
-
-                cItem->cInstStack = new vector<const llvm::Instruction *>();
-                cItem->cIDStack = new vector<unsigned long>();
+                CSiteInstVec cInstStack;
 
                 while (!tcStack.empty()) {
                   if (tcStack.top().second) {
-                    cItem->cInstStack->push_back(tcStack.top().second);
-                    cItem->cIDStack->push_back(getHashID(tcStack.top().second));
+                    cInstStack.push_back(tcStack.top().second);
 
                     labelForCSite(
                         tcStack.top().second,
@@ -751,7 +766,8 @@ void DDAPass::computeCFG(SVFModule M) {
                   }
                   tcStack.pop();
                 }
-                cCFGList.push_back(cItem);
+                emitcCFG(iCallInst, iCallID, _pta->getValueFromNodeID(*pit),
+                         *pit, cInstStack);
               }
             }
           }
@@ -765,26 +781,14 @@ void DDAPass::computeCFG(SVFModule M) {
       if (_pta->getValueFromNodeID(*pit) &&
           (isa<GlobalValue>(_pta->getValueFromNodeID(*pit)) ||
            isa<Function>(_pta->getValueFromNodeID(*pit)))) {
-        supaCFG *sItem = (supaCFG *)malloc(sizeof(supaCFG));
+        const Value *iCallTarget = _pta->getValueFromNodeID(*pit);
+        mapValID[iCallTarget] = *pit;
 
-        sItem->iCallInst = iCallInst;
-        sItem->iCallID = iCallID;
-        sItem->iCallTarget = _pta->getValueFromNodeID(*pit);
-        sItem->iCallTargetID = *pit;
-        mapValID[sItem->iCallTarget] = *pit;
-
-        supaCFGList.push_back(sItem);
+        emitSUPACFG(iCallInst, iCallID, iCallTarget, *pit);
         // if the points-to set is overapproximated, then type mismatch can
         // detect it
-        if (isTypeMatch(iCallInst, _pta->getValueFromNodeID(*pit))) {
-          atCFG *atItem = (atCFG *)malloc(sizeof(atCFG));
-          atItem->type = OVER_APPROXIMATE;
-          atItem->iCallInst = iCallInst;
-          atItem->iCallID = iCallID;
-
-          atItem->iCallTarget = _pta->getValueFromNodeID(*pit);
-          atItem->iCallTargetID = *pit;
-          atCFGList.push_back(atItem);
+        if (isTypeMatch(iCallInst, iCallTarget)) {
+          emitatCFG(OVER_APPROXIMATE, iCallInst, iCallID, iCallTarget, *pit);
         }
       }
     }
@@ -793,132 +797,107 @@ void DDAPass::computeCFG(SVFModule M) {
     if (pts.empty()) {
       fillEmptyPointsToSet(iCallInst);
     }
+    // [OS-CFI] the entries of this query are complete
+    cfgStream->flush();
   }
 }
 
-// [OS-CFI] dumpSUPACFG(): print CI-CFG based on SUPA only analysis
-void DDAPass::dumpSUPACFG() {
-  std::hash<std::string> hash_fn;
-  if (DUMP_CFG_DEBUG)
-    outs() << "++++++++++++++[SUPA] Dump CI-CFG [SUPA]++++++++++++++\n";
-  for (std::vector<supaCFG *>::iterator cit = supaCFGList.begin();
-       cit != supaCFGList.end(); ++cit) {
-    supaCFG *item = *cit;
-    if (DUMP_CFG_DEBUG) {
-      outs() << "iCall Instruction: " << *(item->iCallInst) << "\n";
-      outs() << "iCall Target: " << (item->iCallTarget)->getName() << "\n";
-      outs() << "\n";
-    }
-
-    int T;
-    if (isa<Function>(item->iCallTarget)) {
-      T = FUNC;
-    } else {
-      T = VT;
-    }
-
-    errs() << SUPA_CFG << "\t" << T << "\t" << item->iCallID << "\t"
-           << item->iCallTargetID << "\n";
-  }
+// [OS-CFI] getTargetType(): functions are called directly, other targets
+// through a virtual table
+static targetType getTargetType(const Value *target) {
+  return isa<Function>(target) ? FUNC : VT;
 }
 
-// [OS-CFI] dumpatCFG(): print CI-CFG based on Address Taken and Type Check CFG
-void DDAPass::dumpatCFG() {
-  std::hash<std::string> hash_fn;
-  if (DUMP_CFG_DEBUG)
-    outs() << "++++++++++++++[OS-CFG] Address Taken and Type Checked CFG "
-              "[OS-CFG]++++++++++++++\n";
-  for (std::vector<atCFG *>::iterator cit = atCFGList.begin();
-       cit != atCFGList.end(); ++cit) {
-    atCFG *item = *cit;
-    if (DUMP_CFG_DEBUG) {
-      outs() << "[" << item->type
-             << "] iCall Instruction: " << *(item->iCallInst) << "\n";
-      outs() << "iCall Target: " << (item->iCallTarget)->getName() << "\n";
-      outs() << "\n";
-    }
+// [OS-CFI] emitSUPACFG(): stream a CI-CFG entry based on SUPA only analysis
+void DDAPass::emitSUPACFG(const Instruction *iCallInst, unsigned long iCallID,
+                          const Value *iCallTarget,
+                          unsigned long iCallTargetID) {
+  if (DUMP_CFG_DEBUG) {
+    outs() << "[SUPA] iCall Instruction: " << *iCallInst << "\n";
+    outs() << "iCall Target: " << iCallTarget->getName() << "\n";
+    outs() << "\n";
+  }
 
-    int T;
-    if (isa<Function>(item->iCallTarget)) {
-      T = FUNC;
-    } else {
-      T = VT;
-    }
+  CFGRecord rec;
+  rec.kind = SUPA_CFG;
+  rec.target = getTargetType(iCallTarget);
+  rec.iCallID = iCallID;
+  rec.iCallTargetID = iCallTargetID;
+  cfgStream->write(rec);
+}
 
-    errs() << ATCFG << "\t" << T << "\t" << item->iCallID << "\t"
-           << item->iCallTargetID << "\n";
+// [OS-CFI] emitatCFG(): stream a CI-CFG entry based on Address Taken and Type
+// Check CFG
+void DDAPass::emitatCFG(fixType type, const Instruction *iCallInst,
+                        unsigned long iCallID, const Value *iCallTarget,
+                        unsigned long iCallTargetID) {
+  if (DUMP_CFG_DEBUG) {
+    outs() << "[ATCFG " << type << "] iCall Instruction: " << *iCallInst
+           << "\n";
+    outs() << "iCall Target: " << iCallTarget->getName() << "\n";
+    outs() << "\n";
   }
-}
 
-// [OS-CFI] dumpoCFG(): print origin sensitive CFG
-void DDAPass::dumpoCFG() {
-  std::hash<std::string> hash_fn;
-  if (DUMP_CFG_DEBUG)
-    outs() << "++++++++++++++[OS-CFG] Origin Sensitive CFG "
-              "[OS-CFG]++++++++++++++\n";
-  for (std::vector<oCFG *>::iterator cit = oCFGList.begin();
-       cit != oCFGList.end(); ++cit) {
-    oCFG *item = *cit;
-    if (DUMP_CFG_DEBUG) {
-      outs() << "iCall Instruction: " << *(item->iCallInst) << "\n";
-      outs() << "iCall Target: " << (item->iCallTarget)->getName() << "\n";
-      outs() << "Origin ID: " << item->originID << "\n";
-      if (item->originCTXInst) {
-        outs() << "Origin CS Instruction: " << *(item->originCTXInst) << "\n";
-      }
-      outs() << "\n";
-    }
+  CFGRecord rec;
+  rec.kind = ATCFG;
+  rec.target = getTargetType(iCallTarget);
+  rec.iCallID = iCallID;
+  rec.iCallTargetID = iCallTargetID;
+  cfgStream->write(rec);
+}
 
-    int T;
-    if (isa<Function>(item->iCallTarget)) {
-      T = FUNC;
-    } else {
-      T = VT;
+// [OS-CFI] emitoCFG(): stream an origin sensitive CFG entry, the origin
+// context can be null
+void DDAPass::emitoCFG(const Instruction *iCallInst, unsigned long iCallID,
+                       const Value *iCallTarget, unsigned long iCallTargetID,
+                       unsigned long originID,
+                       const Instruction *originCTXInst) {
+  if (DUMP_CFG_DEBUG) {
+    outs() << "[OCFG] iCall Instruction: " << *iCallInst << "\n";
+    outs() << "iCall Target: " << iCallTarget->getName() << "\n";
+    outs() << "Origin ID: " << originID << "\n";
+    if (originCTXInst) {
+      outs() << "Origin CS Instruction: " << *originCTXInst << "\n";
     }
+    outs() << "\n";
+  }
 
-    errs() << OCFG << "\t" << T << "\t" << item->iCallID << "\t"
-           << item->iCallTargetID << "\t" << item->originID;
-    if (item->originCTXInst) {
-      errs() << "\t" << item->originCTXID;
-    }
-    errs() << "\n";
+  CFGRecord rec;
+  rec.kind = OCFG;
+  rec.target = getTargetType(iCallTarget);
+  rec.iCallID = iCallID;
+  rec.iCallTargetID = iCallTargetID;
+  rec.context.push_back(originID);
+  if (originCTXInst) {
+    rec.context.push_back(getHashID(originCTXInst));
   }
+  cfgStream->write(rec);
 }
 
-// [OS-CFI] dumpcCFG(): print callsite sensitive CFG
-void DDAPass::dumpcCFG() {
-  std::hash<std::string> hash_fn;
-  if (DUMP_CFG_DEBUG)
-    outs() << "++++++++++++++[OS-CFG] Callsite Sensitive CFG "
-              "[OS-CFG]++++++++++++++\n";
-  for (std::vector<cCFG *>::iterator cit = cCFGList.begin();
-       cit != cCFGList.end(); ++cit) {
-    cCFG *item = *cit;
-    if (DUMP_CFG_DEBUG) {
-      outs() << "iCall Instruction: " << *(item->iCallInst) << "\n";
-      outs() << "iCall Target: " << (item->iCallTarget)->getName() << "\n";
-      outs() << "iCall CSites:\n";
-      for (std::vector<const llvm::Instruction *>::iterator ctxit =
-               item->cInstStack->begin();
-           ctxit != item->cInstStack->end(); ++ctxit) {
-        llvm::outs() << **ctxit << "\n";
-      }
-      llvm::outs() << "\n";
-    }
-
-    int T;
-    if (isa<Function>(item->iCallTarget)) {
-      T = FUNC;
-    } else {
-      T = VT;
+// [OS-CFI] emitcCFG(): stream a callsite sensitive CFG entry, the call-sites
+// are listed from the innermost one
+void DDAPass::emitcCFG(const Instruction *iCallInst, unsigned long iCallID,
+                       const Value *iCallTarget, unsigned long iCallTargetID,
+                       const CSiteInstVec &cInstStack) {
+  if (DUMP_CFG_DEBUG) {
+    outs() << "[CCFG] iCall Instruction: " << *iCallInst << "\n";
+    outs() << "iCall Target: " << iCallTarget->getName() << "\n";
+    outs() << "iCall CSites:\n";
+    for (CSiteInstVec::const_iterator ctxit = cInstStack.begin();
+         ctxit != cInstStack.end(); ++ctxit) {
+      llvm::outs() << **ctxit << "\n";
     }
+    llvm::outs() << "\n";
+  }
 
-    errs() << CCFG << "\t" << T << "\t" << item->iCallID << "\t"
-           << item->iCallTargetID;
-    for (std::vector<unsigned long>::iterator ctxit = item->cIDStack->begin();
-         ctxit != item->cIDStack->end(); ++ctxit) {
-      errs() << "\t" << *ctxit;
-    }
-    errs() << "\n";
+  CFGRecord rec;
+  rec.kind = CCFG;
+  rec.target = getTargetType(iCallTarget);
+  rec.iCallID = iCallID;
+  rec.iCallTargetID = iCallTargetID;
+  for (CSiteInstVec::const_iterator ctxit = cInstStack.begin();
+       ctxit != cInstStack.end(); ++ctxit) {
+    rec.context.push_back(getHashID(*ctxit));
   }
-}
\ No newline at end of file
+  cfgStream->write(rec);
+}
@@ -0,0 +1,551 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "DDA/DDAQueryCache.h"
+#include "Util/AnalysisUtil.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/MD5.h>
+#include <sstream>
+
+using namespace llvm;
+using namespace analysisUtil;
+
+#define DDA_CACHE_HEADER "OSCFI-DDA-CACHE"
+#define DDA_CACHE_VERSION 2
+
+// [OS-CFI] a long run saves the cache on the way, so it can be stopped and
+// resumed from the answers recorded so far
+static cl::opt<unsigned> DDACheckpoint(
+    "dda-checkpoint", cl::init(60),
+    cl::desc("Seconds between query cache checkpoints, 0 saves at the end"));
+
+// [OS-CFI] a name can be part of a key if it cannot clash with the key syntax
+static bool isKeyName(StringRef name) {
+  return !name.empty() && name.find_first_of(" \t\r\n+:#") == StringRef::npos;
+}
+
+// [OS-CFI] a number of a key, false rather than an exception if malformed
+static bool parseNum(const std::string &str, u64_t &num) {
+  if (str.empty() || !isdigit((unsigned char)str[0]))
+    return false;
+  char *end = NULL;
+  errno = 0;
+  num = strtoull(str.c_str(), &end, 10);
+  return errno == 0 && *end == '\0';
+}
+
+// [OS-CFI] hex MD5 digest of a string
+static std::string getDigest(StringRef str) {
+  MD5 md5;
+  md5.update(str);
+  MD5::MD5Result result;
+  md5.final(result);
+  SmallString<32> hex;
+  MD5::stringifyResult(result, hex);
+  return hex.str();
+}
+
+/*!
+ * Constructor
+ */
+DDAQueryCache::DDAQueryCache(const std::string &p, const std::string &s,
+                             PointerAnalysis *a, SVFG *g)
+    : path(p), settings(s), pta(a), pag(a->getPAG()), svfg(g), numOfHits(0),
+      numOfRecords(0), savedAt(Clock::now()) {
+  hashFunctions();
+}
+
+/*!
+ * Index instructions and objects and hash every function of the module.
+ * A function hash covers its IR and the value-flow edges entering its SVFG
+ * nodes, including the objects guarding indirect edges, so a changed
+ * pre-analysis result also changes the hash. Nodes outside any function
+ * (global initializers) fall into the "-" bucket, hashed with all globals.
+ */
+void DDAQueryCache::hashFunctions() {
+  SVFModule module = pta->getModule();
+  for (SVFModule::const_iterator it = module.begin(), eit = module.end();
+       it != eit; ++it) {
+    const Function *fun = *it;
+    if (!isKeyName(fun->getName()))
+      continue;
+    nameToFunc[fun->getName()] = fun;
+    u32_t index = 0;
+    for (const_inst_iterator I = inst_begin(fun), E = inst_end(fun); I != E;
+         ++I, ++index) {
+      std::string key =
+          "%" + fun->getName().str() + ":" + std::to_string(index);
+      instToKey[&*I] = key;
+      keyToInst[key] = &*I;
+    }
+  }
+
+  for (PAG::iterator it = pag->begin(), eit = pag->end(); it != eit; ++it) {
+    if (!isa<ObjPN>(it->second))
+      continue;
+    std::string key = getObjKey(it->first);
+    if (!key.empty())
+      objKeyToNode[key] = it->first;
+  }
+
+  std::map<std::string, std::vector<std::string>> funcEdges;
+  for (SVFG::iterator it = svfg->begin(), eit = svfg->end(); it != eit; ++it) {
+    const SVFGNode *node = it->second;
+    std::string dstFun = getFuncKey(getSVFGNodeFunction(node));
+    if (dstFun.empty())
+      continue;
+    for (SVFGNode::const_iterator iter = node->InEdgeBegin(),
+                                  eiter = node->InEdgeEnd();
+         iter != eiter; ++iter) {
+      const SVFGEdge *edge = *iter;
+      const SVFGNode *src = edge->getSrcNode();
+      std::string line;
+      raw_string_ostream rawstr(line);
+      rawstr << node->getNodeKind() << " " << getSVFGNodeKey(node) << " <- "
+             << edge->getEdgeKind() << " "
+             << getFuncKey(getSVFGNodeFunction(src)) << " "
+             << src->getNodeKind() << " " << getSVFGNodeKey(src);
+      if (const IndirectSVFGEdge *indEdge = dyn_cast<IndirectSVFGEdge>(edge)) {
+        const PointsTo &guard = indEdge->getPointsTo();
+        for (PointsTo::iterator pit = guard.begin(), peit = guard.end();
+             pit != peit; ++pit)
+          rawstr << " " << getObjKey(*pit);
+      }
+      funcEdges[dstFun].push_back(rawstr.str());
+    }
+  }
+
+  for (NameToFuncMap::const_iterator it = nameToFunc.begin(),
+                                     eit = nameToFunc.end();
+       it != eit; ++it) {
+    std::string key = getFuncKey(it->second);
+    std::string text;
+    raw_string_ostream rawstr(text);
+    it->second->print(rawstr);
+    std::vector<std::string> &edges = funcEdges[key];
+    std::sort(edges.begin(), edges.end());
+    for (u32_t i = 0; i < edges.size(); i++)
+      rawstr << "\n" << edges[i];
+    funcHashes[key] = getDigest(rawstr.str());
+  }
+
+  std::string text;
+  raw_string_ostream rawstr(text);
+  for (SVFModule::const_global_iterator it = module.global_begin(),
+                                        eit = module.global_end();
+       it != eit; ++it)
+    rawstr << **it << "\n";
+  std::vector<std::string> &edges = funcEdges["-"];
+  std::sort(edges.begin(), edges.end());
+  for (u32_t i = 0; i < edges.size(); i++)
+    rawstr << "\n" << edges[i];
+  funcHashes["-"] = getDigest(rawstr.str());
+}
+
+/*!
+ * Key helpers, an empty key means the item cannot be cached
+ */
+std::string DDAQueryCache::getFuncKey(const Function *fun) const {
+  if (fun == NULL)
+    return "-";
+  if (!isKeyName(fun->getName()))
+    return "";
+  return "@" + fun->getName().str();
+}
+
+std::string DDAQueryCache::getInstKey(const Instruction *inst) const {
+  InstToKeyMap::const_iterator it = instToKey.find(inst);
+  return it == instToKey.end() ? "" : it->second;
+}
+
+std::string DDAQueryCache::getValueKey(const Value *val) const {
+  if (val == NULL)
+    return "";
+  if (const GlobalValue *gv = dyn_cast<GlobalValue>(val))
+    return isKeyName(gv->getName()) ? "@" + gv->getName().str() : "";
+  if (const Instruction *inst = dyn_cast<Instruction>(val))
+    return getInstKey(inst);
+  if (const Argument *arg = dyn_cast<Argument>(val)) {
+    const Function *fun = arg->getParent();
+    if (!isKeyName(fun->getName()))
+      return "";
+    return "%" + fun->getName().str() + "#" + std::to_string(arg->getArgNo());
+  }
+  return "";
+}
+
+std::string DDAQueryCache::getObjKey(NodeID id) const {
+  if (pag->isBlkObjOrConstantObj(id))
+    return "#" + std::to_string(id);
+  const PAGNode *node = pag->getPAGNode(id);
+  const ObjPN *obj = dyn_cast<ObjPN>(node);
+  if (obj == NULL || obj->getMemObj() == NULL)
+    return "";
+  std::string base = getValueKey(obj->getMemObj()->getRefVal());
+  const GepObjPN *gep = dyn_cast<GepObjPN>(obj);
+  if (base.empty() || gep == NULL)
+    return base;
+  const LocationSet &ls = gep->getLocationSet();
+  std::string key = base + "+" + std::to_string(ls.getOffset()) + "+" +
+                    std::to_string(ls.getByteOffset());
+  for (LocationSet::ElemNumStridePairVec::const_iterator
+           it = ls.getNumStridePair().begin(),
+           eit = ls.getNumStridePair().end();
+       it != eit; ++it)
+    key += "+" + std::to_string(it->first) + "*" + std::to_string(it->second);
+  return key;
+}
+
+std::string DDAQueryCache::getSVFGNodeKey(const SVFGNode *node) const {
+  if (const StmtSVFGNode *stmt = dyn_cast<StmtSVFGNode>(node)) {
+    std::string key = getInstKey(stmt->getInst());
+    if (!key.empty())
+      return key;
+  }
+  return "-";
+}
+
+const Function *
+DDAQueryCache::getSVFGNodeFunction(const SVFGNode *node) const {
+  if (node->getBB())
+    return node->getBB()->getParent();
+  if (const FormalParmSVFGNode *fp = dyn_cast<FormalParmSVFGNode>(node))
+    return fp->getFun();
+  if (const FormalRetSVFGNode *fr = dyn_cast<FormalRetSVFGNode>(node))
+    return fr->getFun();
+  if (const FormalINSVFGNode *fi = dyn_cast<FormalINSVFGNode>(node))
+    return fi->getFun();
+  if (const FormalOUTSVFGNode *fo = dyn_cast<FormalOUTSVFGNode>(node))
+    return fo->getFun();
+  if (const InterPHISVFGNode *phi = dyn_cast<InterPHISVFGNode>(node))
+    return phi->getFun();
+  if (const InterMSSAPHISVFGNode *mphi = dyn_cast<InterMSSAPHISVFGNode>(node))
+    return mphi->getFun();
+  return NULL;
+}
+
+/*!
+ * Resolve keys of an earlier run in the current module
+ */
+bool DDAQueryCache::resolveInst(const std::string &key,
+                                const Instruction *&inst) {
+  if (key == "-") {
+    inst = NULL;
+    return true;
+  }
+  KeyToInstMap::const_iterator it = keyToInst.find(key);
+  if (it == keyToInst.end())
+    return false;
+  inst = it->second;
+  return true;
+}
+
+bool DDAQueryCache::resolveObj(const std::string &key, NodeID &id) {
+  KeyToNodeMap::const_iterator it = objKeyToNode.find(key);
+  if (it != objKeyToNode.end()) {
+    id = it->second;
+    return true;
+  }
+  if (key.size() > 1 && key[0] == '#') {
+    u64_t num = 0;
+    if (!parseNum(key.substr(1), num))
+      return false;
+    id = num;
+    return pag->isBlkObjOrConstantObj(id);
+  }
+  // a field object the current run has not created yet
+  std::vector<std::string> parts;
+  std::stringstream ss(key);
+  std::string part;
+  while (std::getline(ss, part, '+'))
+    parts.push_back(part);
+  if (parts.size() < 3)
+    return false;
+  KeyToNodeMap::const_iterator bit = objKeyToNode.find(parts[0]);
+  if (bit == objKeyToNode.end())
+    return false;
+  u64_t offset = 0, byteOffset = 0;
+  if (!parseNum(parts[1], offset) || !parseNum(parts[2], byteOffset))
+    return false;
+  LocationSet ls(offset);
+  ls.setByteOffset(byteOffset);
+  for (u32_t i = 3; i < parts.size(); i++) {
+    size_t star = parts[i].find('*');
+    u64_t num = 0, stride = 0;
+    if (star == std::string::npos ||
+        !parseNum(parts[i].substr(0, star), num) ||
+        !parseNum(parts[i].substr(star + 1), stride))
+      return false;
+    ls.addElemNumStridePair(std::make_pair(num, stride));
+  }
+  id = pag->getGepObjNode(bit->second, ls);
+  objKeyToNode[key] = id;
+  return true;
+}
+
+/*!
+ * Read the entries of an earlier run
+ */
+void DDAQueryCache::load() {
+  std::ifstream in(path.c_str());
+  if (!in.is_open())
+    return;
+  std::string line;
+  std::string version = std::string(DDA_CACHE_HEADER) + " " +
+                        std::to_string(DDA_CACHE_VERSION);
+  if (!std::getline(in, line) || line.compare(0, version.size(), version)) {
+    wrnMsg("ignoring query cache " + path + " with unknown format");
+    return;
+  }
+  if (line != version + " " + settings) {
+    wrnMsg("ignoring query cache " + path +
+           " computed under other solver settings");
+    return;
+  }
+  while (std::getline(in, line)) {
+    size_t space = line.find(' ');
+    if (space != std::string::npos)
+      loadedEntries[line.substr(0, space)] = line;
+  }
+}
+
+/*!
+ * Install the cached answer of a query if every function of its slice
+ * still has the same hash
+ */
+bool DDAQueryCache::lookup(NodeID query) {
+  const PAGNode *node = pag->getPAGNode(query);
+  if (!node->hasValue() || !svfg->hasDef(node))
+    return false;
+  std::string key = getValueKey(node->getValue());
+  KeyToStrMap::const_iterator it = loadedEntries.find(key);
+  if (key.empty() || it == loadedEntries.end())
+    return false;
+  std::string entry = it->second;
+  loadedEntries.erase(it);
+  if (!decode(entry, query))
+    return false;
+  validEntries[key] = entry;
+  numOfHits++;
+  return true;
+}
+
+bool DDAQueryCache::decode(const std::string &entry, NodeID query) {
+  std::istringstream in(entry);
+  std::string key, tag, name, hash;
+  u32_t num = 0;
+
+  in >> key >> tag >> num;
+  if (!in || tag != "F")
+    return false;
+  for (u32_t i = 0; i < num; i++) {
+    in >> name >> hash;
+    KeyToStrMap::const_iterator it = funcHashes.find(name);
+    if (!in || it == funcHashes.end() || it->second != hash)
+      return false;
+  }
+
+  PointsTo pts;
+  in >> tag >> num;
+  if (!in || tag != "P")
+    return false;
+  for (u32_t i = 0; i < num; i++) {
+    NodeID obj = 0;
+    in >> name;
+    if (!in || !resolveObj(name, obj))
+      return false;
+    pts.set(obj);
+  }
+
+  OriginSensitiveTupleSet opts;
+  in >> tag >> num;
+  if (!in || tag != "O")
+    return false;
+  for (u32_t i = 0; i < num; i++) {
+    NodeID obj = 0;
+    std::string store, ctx;
+    const Instruction *storeInst = NULL;
+    const Instruction *ctxInst = NULL;
+    in >> name >> store >> ctx;
+    if (!in || !resolveObj(name, obj) || !resolveInst(store, storeInst) ||
+        !resolveInst(ctx, ctxInst) || storeInst == NULL ||
+        !pag->hasPAGEdgeList(storeInst))
+      return false;
+    const StoreSVFGNode *storeNode = NULL;
+    const PAG::PAGEdgeList &edges = pag->getInstPAGEdgeList(storeInst);
+    for (PAG::PAGEdgeList::const_iterator eit = edges.begin(),
+                                          eeit = edges.end();
+         eit != eeit; ++eit) {
+      if (const StorePE *storePE = dyn_cast<StorePE>(*eit))
+        storeNode = dyn_cast<StoreSVFGNode>(svfg->getStoreSVFGNode(storePE));
+    }
+    if (storeNode == NULL)
+      return false;
+    opts.insert(std::make_tuple(obj, storeNode, ctxInst));
+  }
+
+  CallStackSet cspts;
+  in >> tag >> num;
+  if (!in || tag != "C")
+    return false;
+  for (u32_t i = 0; i < num; i++) {
+    NodeID obj = 0;
+    u32_t depth = 0;
+    in >> name >> depth;
+    if (!in || !resolveObj(name, obj))
+      return false;
+    // entries were written from the top, rebuild the stack from the bottom
+    std::vector<const Instruction *> insts(depth, NULL);
+    for (u32_t d = 0; d < depth; d++) {
+      in >> name;
+      if (!in || !resolveInst(name, insts[d]))
+        return false;
+    }
+    CallSwitchPairStack stack;
+    for (std::vector<const Instruction *>::reverse_iterator
+             rit = insts.rbegin(),
+             reit = insts.rend();
+         rit != reit; ++rit)
+      stack.push(std::make_pair(0, *rit));
+    cspts.insert(std::make_pair(obj, stack));
+  }
+
+  const PAGNode *pagNode = pag->getPAGNode(query);
+  pta->setDDAQueryResult(query, svfg->getDefSVFGNode(pagNode), pts,
+                         new OriginSensitiveTupleSet(opts),
+                         new CallStackSet(cspts));
+  return true;
+}
+
+/*!
+ * Record a solved query, queries whose answer left the SVFG slice (downgraded
+ * to Andersen's analysis) or which refer to unnamed values are not cached
+ */
+void DDAQueryCache::record(NodeID query) {
+  const PAGNode *node = pag->getPAGNode(query);
+  NodeBS slice;
+  if (!node->hasValue() || !pta->getDDAQuerySlice(query, slice))
+    return;
+  std::string key = getValueKey(node->getValue());
+  if (key.empty())
+    return;
+
+  FuncSet funcs;
+  for (NodeBS::iterator it = slice.begin(), eit = slice.end(); it != eit;
+       ++it) {
+    if (svfg->hasGNode(*it))
+      funcs.insert(getSVFGNodeFunction(svfg->getSVFGNode(*it)));
+  }
+
+  std::string entry;
+  raw_string_ostream rawstr(entry);
+  rawstr << key << " F " << funcs.size();
+  for (FuncSet::const_iterator it = funcs.begin(), eit = funcs.end();
+       it != eit; ++it) {
+    KeyToStrMap::const_iterator hit = funcHashes.find(getFuncKey(*it));
+    if (hit == funcHashes.end())
+      return;
+    rawstr << " " << hit->first << " " << hit->second;
+  }
+
+  PointsTo pts;
+  pta->getDDAQueryPts(query, pts);
+  rawstr << " P " << pts.count();
+  for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it) {
+    std::string obj = getObjKey(*it);
+    if (obj.empty())
+      return;
+    rawstr << " " << obj;
+  }
+
+  const OriginSensitiveTupleSet *opts = pta->getOriginSensitiveTupleSet(query);
+  rawstr << " O " << (opts ? opts->size() : 0);
+  if (opts) {
+    for (OriginSensitiveTupleSetIt it = opts->begin(), eit = opts->end();
+         it != eit; ++it) {
+      std::string obj = getObjKey(std::get<0>(*it));
+      std::string store =
+          std::get<1>(*it) ? getInstKey(std::get<1>(*it)->getInst()) : "";
+      std::string ctx =
+          std::get<2>(*it) ? getInstKey(std::get<2>(*it)) : std::string("-");
+      if (obj.empty() || store.empty() || ctx.empty())
+        return;
+      rawstr << " " << obj << " " << store << " " << ctx;
+    }
+  }
+
+  const CallStackSet *cspts = pta->getCSSensitiveSet(query);
+  rawstr << " C " << (cspts ? cspts->size() : 0);
+  if (cspts) {
+    for (CallStackSetIt it = cspts->begin(), eit = cspts->end(); it != eit;
+         ++it) {
+      std::string obj = getObjKey(it->first);
+      if (obj.empty())
+        return;
+      CallSwitchPairStack stack(it->second);
+      rawstr << " " << obj << " " << stack.size();
+      while (!stack.empty()) {
+        std::string inst = stack.top().second
+                               ? getInstKey(stack.top().second)
+                               : std::string("-");
+        if (inst.empty())
+          return;
+        rawstr << " " << inst;
+        stack.pop();
+      }
+    }
+  }
+
+  validEntries[key] = rawstr.str();
+  numOfRecords++;
+}
+
+/*!
+ * Write the entries of this run, stale entries of earlier runs are dropped
+ */
+void DDAQueryCache::save() { write(false); }
+
+/*!
+ * Write the entries recorded so far, entries of earlier runs that were not
+ * looked up yet are kept as they may still be valid
+ */
+void DDAQueryCache::checkpoint() {
+  if (DDACheckpoint == 0 ||
+      Clock::now() - savedAt < std::chrono::seconds(DDACheckpoint))
+    return;
+  write(true);
+}
+
+void DDAQueryCache::write(bool keepUnvisited) {
+  savedAt = Clock::now();
+  std::string tmpPath = path + ".tmp";
+  std::ofstream out(tmpPath.c_str());
+  if (!out.is_open()) {
+    wrnMsg("cannot write query cache " + tmpPath);
+    return;
+  }
+  out << DDA_CACHE_HEADER << " " << DDA_CACHE_VERSION << " " << settings
+      << "\n";
+  for (KeyToStrMap::const_iterator it = validEntries.begin(),
+                                   eit = validEntries.end();
+       it != eit; ++it)
+    out << it->second << "\n";
+  for (KeyToStrMap::const_iterator it = loadedEntries.begin(),
+                                   eit = loadedEntries.end();
+       keepUnvisited && it != eit; ++it) {
+    if (validEntries.find(it->first) == validEntries.end())
+      out << it->second << "\n";
+  }
+  out.close();
+  if (!out || std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    wrnMsg("cannot write query cache " + path);
+}
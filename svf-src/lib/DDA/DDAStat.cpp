@@ -36,6 +36,9 @@ void DDAStat::initDefault() {
   _NumOfNullPtr = 0;
   _NumOfConstantPtr = 0;
   _NumOfBlackholePtr = 0;
+  _NumOfEvictedDPM = 0;
+  _NumOfSpilledDPM = 0;
+  _NumOfRestoredDPM = 0;
   _AvgNumOfDPMAtSVFGNode = 0;
   _MaxNumOfDPMAtSVFGNode = 0;
   _TotalTimeOfQueries = 0;
@@ -226,6 +229,9 @@ void DDAStat::performStat() {
   PTNumStatMap["NumOfNullPtr"] = _NumOfNullPtr;
   PTNumStatMap["PointsToConstPtr"] = _NumOfConstantPtr;
   PTNumStatMap["PointsToBlkPtr"] = _NumOfBlackholePtr;
+  PTNumStatMap["NumOfEvictedDPM"] = _NumOfEvictedDPM;
+  PTNumStatMap["NumOfSpilledDPM"] = _NumOfSpilledDPM;
+  PTNumStatMap["NumOfRestoredDPM"] = _NumOfRestoredDPM;
   PTNumStatMap["NumOfMustAA"] = _TotalNumOfMustAliases;
   PTNumStatMap["NumOfInfePath"] = _TotalNumOfInfeasiblePath;
   PTNumStatMap["NumOfStore"] = PAG::getPAG()->getEdgeSet(PAGEdge::Store).size();
@@ -0,0 +1,215 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "DDA/ECSelector.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <llvm/Support/Format.h>
+
+using namespace llvm;
+
+// [OS-CFI] EC sizes are reported in power of two buckets: 1, 2, 3-4, ...
+static const u32_t NumOfBuckets = 7;
+static const char *BucketNames[NumOfBuckets] = {"1",    "2",     "3-4", "5-8",
+                                                "9-16", "17-32", "33+"};
+
+static u32_t getBucket(double size) {
+  u32_t bucket = 0;
+  for (double limit = 1; bucket + 1 < NumOfBuckets && size > limit;
+       limit *= 2)
+    bucket++;
+  return bucket;
+}
+
+/*!
+ * A CS entry without any call-site cannot be checked against a call stack,
+ * so it is not grouped
+ */
+void ECSelector::add(const CFGRecord &rec) {
+  switch (rec.kind) {
+  case ATCFG:
+    icts[rec.iCallID].ciECs[rec.target].insert(rec.iCallTargetID);
+    break;
+  case OCFG: {
+    ECKey key(rec.target, rec.context);
+    key.second.resize(2, 0);
+    icts[rec.iCallID].osECs[key].insert(rec.iCallTargetID);
+    break;
+  }
+  case CCFG:
+    if (!rec.context.empty()) {
+      ECKey key(rec.target, rec.context);
+      icts[rec.iCallID].csECs[key].insert(rec.iCallTargetID);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+/*!
+ * Average EC size of a policy, infinite if the ICT has no EC under it
+ */
+double ECSelector::getAvgECSize(const KeyToECMap &ecs) {
+  if (ecs.empty())
+    return HUGE_VAL;
+  u64_t total = 0;
+  for (KeyToECMap::const_iterator it = ecs.begin(), eit = ecs.end();
+       it != eit; ++it)
+    total += it->second.size();
+  return (double)total / ecs.size();
+}
+
+/*!
+ * The OS and CS averages are taken over every EC of the ICT whatever its
+ * target type, the CI size is the one of the target type
+ */
+void ECSelector::select() {
+  for (ICTToClassesMap::iterator it = icts.begin(), eit = icts.end();
+       it != eit; ++it) {
+    ICTClasses &classes = it->second;
+    double osSize = getAvgECSize(classes.osECs);
+    double csSize = getAvgECSize(classes.csECs);
+    for (TypeToECMap::iterator cit = classes.ciECs.begin(),
+                               ceit = classes.ciECs.end();
+         cit != ceit; ++cit) {
+      double ciSize = cit->second.size();
+      Policy policy;
+      if (ciSize <= osSize && ciSize <= csSize)
+        policy = CI;
+      else if (osSize < csSize && osSize < ciSize)
+        policy = OS;
+      else
+        policy = CS;
+      classes.policies[cit->first] = policy;
+    }
+  }
+}
+
+std::vector<u64_t> ECSelector::getSortedICTs() const {
+  std::vector<u64_t> ids;
+  ids.reserve(icts.size());
+  for (ICTToClassesMap::const_iterator it = icts.begin(), eit = icts.end();
+       it != eit; ++it)
+    ids.push_back(it->first);
+  std::sort(ids.begin(), ids.end());
+  return ids;
+}
+
+/*!
+ * Tables are written ICT by ICT in id order. CS contexts deeper than three
+ * call-sites keep the innermost three, which is what the cs3 table holds
+ */
+bool ECSelector::write(const std::string &dir) const {
+  std::ofstream ciFile((dir + "/ciCFG.bin").c_str());
+  std::ofstream osFile((dir + "/osCFG.bin").c_str());
+  std::ofstream csFiles[3];
+  for (u32_t d = 0; d < 3; d++)
+    csFiles[d].open((dir + "/cs" + std::to_string(d + 1) + "CFG.bin").c_str());
+  if (!ciFile || !osFile || !csFiles[0] || !csFiles[1] || !csFiles[2])
+    return false;
+
+  std::vector<u64_t> ids = getSortedICTs();
+  for (std::vector<u64_t>::iterator iit = ids.begin(); iit != ids.end();
+       ++iit) {
+    const ICTClasses &classes = icts.find(*iit)->second;
+    const TypeToPolicyMap &policies = classes.policies;
+
+    for (TypeToECMap::const_iterator it = classes.ciECs.begin(),
+                                     eit = classes.ciECs.end();
+         it != eit; ++it) {
+      if (policies.find(it->first)->second != CI)
+        continue;
+      for (TargetSet::const_iterator tit = it->second.begin();
+           tit != it->second.end(); ++tit)
+        ciFile << it->first << "\t" << *iit << "\t" << *tit << "\n";
+    }
+
+    for (KeyToECMap::const_iterator it = classes.osECs.begin(),
+                                    eit = classes.osECs.end();
+         it != eit; ++it) {
+      TypeToPolicyMap::const_iterator pit = policies.find(it->first.first);
+      if (pit == policies.end() || pit->second != OS)
+        continue;
+      for (TargetSet::const_iterator tit = it->second.begin();
+           tit != it->second.end(); ++tit)
+        osFile << it->first.first << "\t" << *iit << "\t" << it->first.second[0]
+               << "\t" << it->first.second[1] << "\t" << *tit << "\n";
+    }
+
+    for (KeyToECMap::const_iterator it = classes.csECs.begin(),
+                                    eit = classes.csECs.end();
+         it != eit; ++it) {
+      TypeToPolicyMap::const_iterator pit = policies.find(it->first.first);
+      if (pit == policies.end() || pit->second != CS)
+        continue;
+      const std::vector<u64_t> &cxt = it->first.second;
+      u32_t depth = std::min<u32_t>(cxt.size(), 3);
+      for (TargetSet::const_iterator tit = it->second.begin();
+           tit != it->second.end(); ++tit) {
+        std::ofstream &csFile = csFiles[depth - 1];
+        csFile << it->first.first << "\t" << *iit;
+        for (u32_t d = 0; d < depth; d++)
+          csFile << "\t" << cxt[d];
+        csFile << "\t" << *tit << "\n";
+      }
+    }
+  }
+
+  bool good = ciFile.good() && osFile.good();
+  for (u32_t d = 0; d < 3; d++)
+    good = good && csFiles[d].good();
+  return good;
+}
+
+void ECSelector::printSummary(raw_ostream &os) const {
+  u32_t numOfChosen[4] = {0, 0, 0, 0};
+  u32_t numOfUnchecked = 0;
+  // per row: CI, OS and CS ECs, then the chosen average EC sizes
+  u32_t histogram[4][NumOfBuckets] = {};
+
+  for (ICTToClassesMap::const_iterator it = icts.begin(), eit = icts.end();
+       it != eit; ++it) {
+    const ICTClasses &classes = it->second;
+    if (classes.ciECs.empty())
+      numOfUnchecked++;
+    for (TypeToECMap::const_iterator cit = classes.ciECs.begin();
+         cit != classes.ciECs.end(); ++cit)
+      histogram[0][getBucket(cit->second.size())]++;
+    for (KeyToECMap::const_iterator oit = classes.osECs.begin();
+         oit != classes.osECs.end(); ++oit)
+      histogram[1][getBucket(oit->second.size())]++;
+    for (KeyToECMap::const_iterator cit = classes.csECs.begin();
+         cit != classes.csECs.end(); ++cit)
+      histogram[2][getBucket(cit->second.size())]++;
+    for (TypeToPolicyMap::const_iterator pit = classes.policies.begin();
+         pit != classes.policies.end(); ++pit) {
+      numOfChosen[pit->second]++;
+      double size = classes.ciECs.find(pit->first)->second.size();
+      if (pit->second == OS)
+        size = getAvgECSize(classes.osECs);
+      else if (pit->second == CS)
+        size = getAvgECSize(classes.csECs);
+      histogram[3][getBucket(size)]++;
+    }
+  }
+
+  os << "[OS-CFI] EC selection over " << icts.size() << " ICTs: CI "
+     << numOfChosen[CI] << ", OS " << numOfChosen[OS] << ", CS "
+     << numOfChosen[CS] << ", unchecked (no CI EC) " << numOfUnchecked << "\n";
+  const char *header = "EC size";
+  os << format("%-8s", header);
+  for (u32_t b = 0; b < NumOfBuckets; b++)
+    os << format("%8s", BucketNames[b]);
+  os << "\n";
+  const char *rows[4] = {"CI", "OS", "CS", "chosen"};
+  for (u32_t r = 0; r < 4; r++) {
+    os << format("%-8s", rows[r]);
+    for (u32_t b = 0; b < NumOfBuckets; b++)
+      os << format("%8u", histogram[r][b]);
+    os << "\n";
+  }
+}
@@ -16,6 +16,8 @@ static cl::opt<unsigned long long>
     flowBudget("flowbg", cl::init(10000),
                cl::desc("Maximum step budget of flow-sensitive traversing"));
 
+u64_t FlowDDA::getFlowBudget() { return flowBudget; }
+
 /*!
  * Compute points-to set for queries
  */
@@ -41,6 +43,7 @@ void FlowDDA::computeDDAPts(NodeID id) {
     unionPts(node->getId(), pts);
   else
     handleOutOfBudgetDpm(dpm);
+  finishQuerySlice();
 
   if (this->printStat())
     DOSTAT(stat->performStatPerQuery(node->getId()));
@@ -58,6 +61,8 @@ void FlowDDA::handleOutOfBudgetDpm(const LocDPItem &dpm) {
   updateCachedPointsTo(dpm, anderPts);
   unionPts(dpm.getCurNodeID(), anderPts);
   addOutOfBudgetDpm(dpm);
+  // [OS-CFI] Andersen's answer is not bound to any SVFG slice
+  markSliceIncomplete();
 }
 
 bool FlowDDA::testIndCallReachability(LocDPItem &dpm,
@@ -157,12 +162,13 @@ PointsTo FlowDDA::processGepPts(const GepSVFGNode *gep,
                          << *(mapNodeStore[src]->getInst()) << "\n";
           }
         }
-        if (mapTOrgCtx.count(src) > 0) {
-          for (InstructionSetIt it = mapTOrgCtx[src].begin();
-               it != mapTOrgCtx[src].end(); it++) {
+        const OriginContextSetPtr *ctxs = mapTOrgCtx.find(src);
+        if (ctxs) {
+          const InstructionSet &orgCtxs = **ctxs;
+          for (InstructionSet::const_iterator it = orgCtxs.begin();
+               it != orgCtxs.end(); it++) {
             if (*it != nullptr) {
-              mapSOrgSenTupSet[getCurCandidate()]->insert(
-                  std::make_tuple(dst, mapNodeStore[src], *it));
+              addOriginTuple(std::make_tuple(dst, mapNodeStore[src], *it));
               if (DEBUG_SOLVER) {
                 llvm::outs() << "[OS-CFI] mapSOrgSenTupSet["
                              << getCurCandidate() << "] <= <" << dst << ", "
@@ -171,8 +177,7 @@ PointsTo FlowDDA::processGepPts(const GepSVFGNode *gep,
                              << ">\n";
               }
             } else {
-              mapSOrgSenTupSet[getCurCandidate()]->insert(
-                  std::make_tuple(dst, mapNodeStore[src], nullptr));
+              addOriginTuple(std::make_tuple(dst, mapNodeStore[src], nullptr));
               if (DEBUG_SOLVER) {
                 llvm::outs() << "[oCFG-Count] mapSOrgSenTupSet["
                              << getCurCandidate() << "] <= <" << dst << ", "
@@ -183,8 +188,7 @@ PointsTo FlowDDA::processGepPts(const GepSVFGNode *gep,
             }
           }
         } else {
-          mapSOrgSenTupSet[getCurCandidate()]->insert(
-              std::make_tuple(dst, mapNodeStore[src], nullptr));
+          addOriginTuple(std::make_tuple(dst, mapNodeStore[src], nullptr));
           if (DEBUG_SOLVER) {
             llvm::outs() << "[oCFG-Count] mapSOrgSenTupSet["
                          << getCurCandidate() << "] <= <" << dst << ", "
@@ -0,0 +1,228 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "DDA/MDPlacement.h"
+#include "Util/AnalysisUtil.h"
+#include "Util/ExtAPI.h"
+#include "Util/ThreadAPI.h"
+#include <fstream>
+#include <llvm/IR/InstIterator.h>
+
+using namespace llvm;
+using namespace analysisUtil;
+
+/*!
+ * An id that is not a constant cannot be routed by INSTCFG, the objects it
+ * accesses are shared right away
+ */
+void MDPlacement::collectAccesses() {
+  const Function *update = module.getFunction("update_mpx_table");
+  const Function *pRef = module.getFunction("pcall_reference_monitor");
+  const Function *vRef = module.getFunction("vcall_reference_monitor");
+  const Function *copy = module.getFunction("oscfi_memcpy");
+  const Function *move = module.getFunction("oscfi_memmove");
+  const Function *realloc = module.getFunction("oscfi_realloc");
+
+  for (SVFModule::iterator fit = module.begin(), efit = module.end();
+       fit != efit; ++fit) {
+    for (inst_iterator iit = inst_begin(*fit), eiit = inst_end(*fit);
+         iit != eiit; ++iit) {
+      const CallInst *call = dyn_cast<CallInst>(&*iit);
+      if (call == NULL || call->getCalledFunction() == NULL)
+        continue;
+      const Function *callee = call->getCalledFunction();
+      if (callee == copy || callee == move || callee == realloc) {
+        // a reallocated block moves to the object the call returns
+        PointsTo pts;
+        const Value *to = callee == realloc ? call : call->getArgOperand(1);
+        if (getAddrPts(call->getArgOperand(0), pts) && getAddrPts(to, pts))
+          copies.push_back(pts);
+        else
+          unknownAddr = true;
+        continue;
+      }
+      u32_t kind = 0, idArg = 0, addrArg = 0;
+      if (callee == update && call->getNumArgOperands() == 4) {
+        kind = ORIGIN;
+        idArg = 2;
+      } else if (callee == pRef || callee == vRef) {
+        kind = CALLPOINT;
+        addrArg = 1;
+      } else {
+        continue;
+      }
+
+      PointsTo pts;
+      if (!getAddrPts(call->getArgOperand(addrArg), pts)) {
+        unknownAddr = true;
+        continue;
+      }
+      const ConstantInt *id = dyn_cast<ConstantInt>(call->getArgOperand(idArg));
+      if (id == NULL)
+        sharedObjs |= pts;
+      else
+        accesses[AccessKey(kind, id->getZExtValue())] |= pts;
+    }
+  }
+}
+
+/*!
+ * Same closure as the thread-local pruning of MTA: everything transitively
+ * pointed by a global, a thread fork or join argument, or the pointer
+ * argument of an unknown external function, together with all its fields
+ */
+void MDPlacement::collectNonLocalObjs() {
+  PointsTo worklist;
+
+  PAGEdge::PEDGEK threadKinds[2] = {PAGEdge::ThreadFork, PAGEdge::ThreadJoin};
+  for (u32_t k = 0; k < 2; k++) {
+    const PAGEdge::PAGEdgeSetTy &edges = pag->getEdgeSet(threadKinds[k]);
+    for (PAGEdge::PAGEdgeSetTy::const_iterator it = edges.begin(),
+                                               eit = edges.end();
+         it != eit; ++it) {
+      worklist |= pta->getPts((*it)->getDstID());
+      worklist |= pta->getPts((*it)->getSrcID());
+    }
+  }
+
+  const PAG::PAGEdgeSet &globalEdges = pag->getGlobalPAGEdgeSet();
+  for (PAG::PAGEdgeSet::const_iterator it = globalEdges.begin(),
+                                       eit = globalEdges.end();
+       it != eit; ++it) {
+    if ((*it)->getEdgeKind() == PAGEdge::Addr)
+      worklist.set((*it)->getSrcID());
+  }
+
+  ThreadAPI *tdAPI = ThreadAPI::getThreadAPI();
+  ExtAPI *extAPI = ExtAPI::getExtAPI();
+  for (SVFModule::iterator fit = module.begin(), efit = module.end();
+       fit != efit; ++fit) {
+    for (inst_iterator iit = inst_begin(*fit), eiit = inst_end(*fit);
+         iit != eiit; ++iit) {
+      const Instruction *inst = &*iit;
+      if (!isa<CallInst>(inst) && !isa<InvokeInst>(inst))
+        continue;
+      if (tdAPI->isTDFork(inst)) {
+        addPts(tdAPI->getActualParmAtForkSite(inst), worklist);
+        continue;
+      }
+      const Function *callee = getCallee(inst);
+      if (callee == NULL || !callee->isDeclaration() || callee->isIntrinsic() ||
+          extAPI->get_type(callee) != ExtAPI::EFT_OTHER)
+        continue;
+      for (User::const_op_iterator oit = inst->op_begin(),
+                                   eoit = inst->op_end();
+           oit != eoit; ++oit) {
+        if (*oit != callee)
+          addPts(*oit, worklist);
+      }
+    }
+  }
+
+  while (!worklist.empty()) {
+    NodeID obj = worklist.find_first();
+    worklist.reset(obj);
+    if (nonLocalObjs.test(obj))
+      continue;
+    nonLocalObjs.set(obj);
+    worklist |= pta->getPts(obj);
+    worklist |= pag->getAllFieldsObjNode(obj);
+    worklist.intersectWithComplement(nonLocalObjs);
+  }
+}
+
+void MDPlacement::addPts(const Value *val, PointsTo &objs) {
+  if (val->getType()->isPointerTy() && pag->hasValueNode(val))
+    objs |= pta->getPts(pag->getValueNode(val));
+}
+
+/*!
+ * The address is handed to the runtime as an integer, the pointer is the
+ * operand of that cast
+ */
+bool MDPlacement::getAddrPts(const Value *addr, PointsTo &pts) {
+  if (const PtrToIntInst *cast = dyn_cast<PtrToIntInst>(addr))
+    addr = cast->getOperand(0);
+  else if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(addr))
+    if (ce->getOpcode() == Instruction::PtrToInt)
+      addr = ce->getOperand(0);
+  if (!addr->getType()->isPointerTy())
+    return false;
+  if (!pag->hasValueNode(addr))
+    addr = addr->stripPointerCasts();
+  if (!pag->hasValueNode(addr))
+    return false;
+  pts |= pta->getPts(pag->getValueNode(addr));
+  return true;
+}
+
+/*!
+ * Every object sharing its memory with a shared object is shared too, a
+ * field and its base may be accessed under different nodes, and so is every
+ * object a metadata copy moves from or to a shared one. An id without
+ * any object is left shared, and nothing is thread-local once an address
+ * escaped the analysis.
+ */
+void MDPlacement::classify() {
+  collectAccesses();
+  collectNonLocalObjs();
+  if (unknownAddr)
+    return;
+
+  PointsTo shared;
+  PointsTo seeds = sharedObjs;
+  seeds |= nonLocalObjs;
+  for (PointsTo::iterator it = seeds.begin(), eit = seeds.end(); it != eit;
+       ++it)
+    shared |= pag->getAllFieldsObjNode(*it);
+
+  AccessSet sharedAccesses;
+  std::vector<bool> sharedCopies(copies.size(), false);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (u32_t i = 0; i < copies.size(); i++) {
+      if (sharedCopies[i] || !copies[i].intersects(shared))
+        continue;
+      sharedCopies[i] = true;
+      for (PointsTo::iterator pit = copies[i].begin(), epit = copies[i].end();
+           pit != epit; ++pit)
+        shared |= pag->getAllFieldsObjNode(*pit);
+      changed = true;
+    }
+    for (AccessToPtsMap::const_iterator it = accesses.begin(),
+                                        eit = accesses.end();
+         it != eit; ++it) {
+      if (sharedAccesses.count(it->first))
+        continue;
+      if (!it->second.empty() && !it->second.intersects(shared))
+        continue;
+      sharedAccesses.insert(it->first);
+      for (PointsTo::iterator pit = it->second.begin(),
+                              epit = it->second.end();
+           pit != epit; ++pit)
+        shared |= pag->getAllFieldsObjNode(*pit);
+      changed = true;
+    }
+  }
+
+  for (AccessToPtsMap::const_iterator it = accesses.begin(),
+                                      eit = accesses.end();
+       it != eit; ++it) {
+    if (!sharedAccesses.count(it->first))
+      localAccesses.insert(it->first);
+  }
+}
+
+bool MDPlacement::write(const std::string &path) const {
+  std::ofstream file(path.c_str());
+  if (!file)
+    return false;
+  for (AccessSet::const_iterator it = localAccesses.begin(),
+                                 eit = localAccesses.end();
+       it != eit; ++it)
+    file << it->first << "\t" << it->second << "\n";
+  return file.good();
+}
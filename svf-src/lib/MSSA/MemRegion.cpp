@@ -34,12 +34,17 @@
 
 #include <llvm/Support/raw_ostream.h>	// for output
 #include <llvm/Support/CommandLine.h>	// for cl::opt
+#include <llvm/IR/InstIterator.h>	// for inst iteration
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/ToolOutputFile.h>
+#include <cstring>
 
 using namespace llvm;
 using namespace analysisUtil;
 
 Size_t MemRegion::totalMRNum = 0;
-Size_t MRVer::totalVERNum = 0;
+std::atomic<Size_t> MRVer::totalVERNum(0);
 
 static cl::opt<bool> IgnoreDeadFun("mssa-ignoreDeadFun", cl::init(false),
                                    cl::desc("Don't construct memory SSA for deadfunction"));
@@ -532,3 +537,246 @@ void MRGenerator::modRefAnalysis(PTACallGraphNode* callGraphNode, WorkList& work
         }
     }
 }
+
+// [OS-CFI] region snapshot: a header, the points-to set of every region in id
+// order, then the region sets of functions, loads, stores, call-site refs and
+// call-site mods. Each set is keyed by the function or call site number in
+// module order, or by the PAG edge id of the load or store, and lists regions
+// by their position in the file. All numbers are 32-bit words.
+static const char MRMagic[8] = {'O', 'S', 'C', 'F', 'I', 'M', 'R', 'S'};
+static const u32_t MRVersion = 1;
+
+struct MRFileHeader {
+    char magic[8];
+    u32_t version;
+    u32_t ignoreDeadFun;
+    u32_t numOfNodes;	///< PAG nodes and edges the regions were built on
+    u32_t numOfEdges;
+};
+
+/// A region set of a function, load, store or call site in the snapshot
+typedef std::pair<u32_t, std::vector<u32_t> > MRSetEntry;
+typedef std::vector<MRSetEntry> MRSetEntries;
+
+/*!
+ * Functions and call sites in module order
+ */
+static void collectFunsAndCallSites(SVFModule svfModule,
+                                    std::vector<const Function*>& funs,
+                                    std::vector<const Instruction*>& callSites) {
+    for (SVFModule::iterator fi = svfModule.begin(), efi = svfModule.end(); fi != efi; ++fi) {
+        const Function* fun = *fi;
+        funs.push_back(fun);
+        for (const_inst_iterator it = inst_begin(fun), eit = inst_end(fun); it != eit; ++it) {
+            if (analysisUtil::isCallSite(&*it))
+                callSites.push_back(&*it);
+        }
+    }
+}
+
+static void putWord(std::string& data, u32_t word) {
+    data.append((const char*)&word, sizeof(word));
+}
+
+static bool getWord(StringRef buf, size_t& pos, u32_t& word) {
+    if (buf.size() - pos < sizeof(word))
+        return false;
+    memcpy(&word, buf.data() + pos, sizeof(word));
+    pos += sizeof(word);
+    return true;
+}
+
+/*!
+ * Read a section of region sets, false if a key reaches numOfKeys or a region
+ * numOfMRs
+ */
+static bool getMRSets(StringRef buf, size_t& pos, u32_t numOfKeys, u32_t numOfMRs,
+                      MRSetEntries& entries) {
+    u32_t num = 0;
+    if (!getWord(buf, pos, num))
+        return false;
+    for (u32_t i = 0; i < num; i++) {
+        u32_t key = 0, size = 0;
+        if (!getWord(buf, pos, key) || key >= numOfKeys || !getWord(buf, pos, size) ||
+                size > (buf.size() - pos) / sizeof(u32_t))
+            return false;
+        entries.push_back(MRSetEntry(key, std::vector<u32_t>(size)));
+        for (u32_t j = 0; j < size; j++) {
+            if (!getWord(buf, pos, entries.back().second[j]) ||
+                    entries.back().second[j] >= numOfMRs)
+                return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * [OS-CFI] Write the regions, a region set whose key cannot be numbered
+ * leaves the file unwritten
+ */
+void MRGenerator::writeToFile(const std::string& filename) {
+    std::vector<const Function*> funs;
+    std::vector<const Instruction*> callSites;
+    collectFunsAndCallSites(pta->getModule(), funs, callSites);
+    llvm::DenseMap<const Function*, u32_t> funToNum;
+    for (u32_t i = 0; i < funs.size(); i++)
+        funToNum[funs[i]] = i;
+    llvm::DenseMap<const Instruction*, u32_t> csToNum;
+    for (u32_t i = 0; i < callSites.size(); i++)
+        csToNum[callSites[i]] = i;
+
+    std::vector<const MemRegion*> mrs(memRegSet.begin(), memRegSet.end());
+    std::sort(mrs.begin(), mrs.end(), [](const MemRegion* lhs, const MemRegion* rhs) {
+        return lhs->getMRID() < rhs->getMRID();
+    });
+    llvm::DenseMap<const MemRegion*, u32_t> mrToNum;
+    std::string data;
+    putWord(data, mrs.size());
+    for (u32_t i = 0; i < mrs.size(); i++) {
+        mrToNum[mrs[i]] = i;
+        const PointsTo& pts = mrs[i]->getPointsTo();
+        putWord(data, pts.count());
+        for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it)
+            putWord(data, *it);
+    }
+
+    auto putMRSet = [&](u32_t key, const MRSet& mrSet) {
+        putWord(data, key);
+        putWord(data, mrSet.size());
+        for (MRSet::const_iterator it = mrSet.begin(), eit = mrSet.end(); it != eit; ++it)
+            putWord(data, mrToNum[*it]);
+    };
+
+    putWord(data, funToMRsMap.size());
+    for (FunToMRsMap::const_iterator it = funToMRsMap.begin(), eit = funToMRsMap.end(); it != eit; ++it) {
+        if (!funToNum.count(it->first))
+            return;
+        putMRSet(funToNum[it->first], it->second);
+    }
+    putWord(data, loadsToMRsMap.size());
+    for (LoadsToMRsMap::const_iterator it = loadsToMRsMap.begin(), eit = loadsToMRsMap.end(); it != eit; ++it)
+        putMRSet(it->first->getEdgeID(), it->second);
+    putWord(data, storesToMRsMap.size());
+    for (StoresToMRsMap::const_iterator it = storesToMRsMap.begin(), eit = storesToMRsMap.end(); it != eit; ++it)
+        putMRSet(it->first->getEdgeID(), it->second);
+    CallSiteToMRsMap* csMaps[2] = {&callsiteToRefMRsMap, &callsiteToModMRsMap};
+    for (u32_t k = 0; k < 2; k++) {
+        putWord(data, csMaps[k]->size());
+        for (CallSiteToMRsMap::const_iterator it = csMaps[k]->begin(), eit = csMaps[k]->end(); it != eit; ++it) {
+            if (!csToNum.count(it->first.getInstruction()))
+                return;
+            putMRSet(csToNum[it->first.getInstruction()], it->second);
+        }
+    }
+
+    MRFileHeader header;
+    memcpy(header.magic, MRMagic, sizeof(MRMagic));
+    header.version = MRVersion;
+    header.ignoreDeadFun = IgnoreDeadFun;
+    header.numOfNodes = pta->getPAG()->getTotalNodeNum();
+    header.numOfEdges = pta->getPAG()->getTotalEdgeNum();
+
+    std::error_code err;
+    ToolOutputFile F(filename.c_str(), err, sys::fs::F_None);
+    if (err) {
+        wrnMsg("cannot write memory regions to " + filename);
+        return;
+    }
+    F.os().write((const char*)&header, sizeof(header));
+    F.os().write(data.data(), data.size());
+    F.os().close();
+    if (!F.os().has_error())
+        F.keep();
+}
+
+/*!
+ * [OS-CFI] Read the regions written by an earlier run. The whole file is
+ * checked before any region is created, false if it does not match the PAG.
+ */
+bool MRGenerator::readFromFile(const std::string& filename) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> file = MemoryBuffer::getFile(filename, -1, false);
+    if (!file || (*file)->getBufferSize() < sizeof(MRFileHeader))
+        return false;
+    StringRef buf = (*file)->getBuffer();
+    MRFileHeader header;
+    memcpy(&header, buf.data(), sizeof(header));
+    PAG* pag = pta->getPAG();
+    if (memcmp(header.magic, MRMagic, sizeof(MRMagic)) != 0 || header.version != MRVersion ||
+            header.ignoreDeadFun != IgnoreDeadFun || header.numOfNodes != pag->getTotalNodeNum() ||
+            header.numOfEdges != pag->getTotalEdgeNum())
+        return false;
+
+    // regions, each one once
+    size_t pos = sizeof(header);
+    u32_t numOfMRs = 0;
+    if (!getWord(buf, pos, numOfMRs) || numOfMRs > (buf.size() - pos) / sizeof(u32_t))
+        return false;
+    std::vector<PointsTo> mrPts(numOfMRs);
+    PointsToList distinctPts;
+    for (u32_t i = 0; i < numOfMRs; i++) {
+        u32_t size = 0, obj = 0;
+        if (!getWord(buf, pos, size))
+            return false;
+        for (u32_t j = 0; j < size; j++) {
+            if (!getWord(buf, pos, obj) || obj >= header.numOfNodes)
+                return false;
+            mrPts[i].set(obj);
+        }
+        if (!distinctPts.insert(mrPts[i]).second)
+            return false;
+    }
+
+    // region sets, their keys must name a function, load, store or call site
+    std::vector<const Function*> funs;
+    std::vector<const Instruction*> callSites;
+    collectFunsAndCallSites(pta->getModule(), funs, callSites);
+    MRSetEntries funSets, loadSets, storeSets, csRefSets, csModSets;
+    if (!getMRSets(buf, pos, funs.size(), numOfMRs, funSets) ||
+            !getMRSets(buf, pos, PAGEdge::totalEdgeNum, numOfMRs, loadSets) ||
+            !getMRSets(buf, pos, PAGEdge::totalEdgeNum, numOfMRs, storeSets) ||
+            !getMRSets(buf, pos, callSites.size(), numOfMRs, csRefSets) ||
+            !getMRSets(buf, pos, callSites.size(), numOfMRs, csModSets) ||
+            pos != buf.size())
+        return false;
+
+    llvm::DenseMap<EdgeID, const LoadPE*> loads;
+    PAGEdge::PAGEdgeSetTy& loadEdges = pag->getEdgeSet(PAGEdge::Load);
+    for (PAGEdge::PAGEdgeSetTy::iterator it = loadEdges.begin(), eit = loadEdges.end(); it != eit; ++it)
+        loads[(*it)->getEdgeID()] = cast<LoadPE>(*it);
+    llvm::DenseMap<EdgeID, const StorePE*> stores;
+    PAGEdge::PAGEdgeSetTy& storeEdges = pag->getEdgeSet(PAGEdge::Store);
+    for (PAGEdge::PAGEdgeSetTy::iterator it = storeEdges.begin(), eit = storeEdges.end(); it != eit; ++it)
+        stores[(*it)->getEdgeID()] = cast<StorePE>(*it);
+    for (u32_t i = 0; i < loadSets.size(); i++) {
+        if (!loads.count(loadSets[i].first))
+            return false;
+    }
+    for (u32_t i = 0; i < storeSets.size(); i++) {
+        if (!stores.count(storeSets[i].first))
+            return false;
+    }
+
+    std::vector<const MemRegion*> mrs(numOfMRs);
+    for (u32_t i = 0; i < numOfMRs; i++) {
+        MemRegion* mr = new MemRegion(mrPts[i]);
+        memRegSet.insert(mr);
+        mrs[i] = mr;
+    }
+    auto fillMRSet = [&](const std::vector<u32_t>& nums, MRSet& mrSet) {
+        for (u32_t i = 0; i < nums.size(); i++)
+            mrSet.insert(mrs[nums[i]]);
+    };
+    for (u32_t i = 0; i < funSets.size(); i++)
+        fillMRSet(funSets[i].second, funToMRsMap[funs[funSets[i].first]]);
+    for (u32_t i = 0; i < loadSets.size(); i++)
+        fillMRSet(loadSets[i].second, loadsToMRsMap[loads[loadSets[i].first]]);
+    for (u32_t i = 0; i < storeSets.size(); i++)
+        fillMRSet(storeSets[i].second, storesToMRsMap[stores[storeSets[i].first]]);
+    for (u32_t i = 0; i < csRefSets.size(); i++)
+        fillMRSet(csRefSets[i].second,
+                 callsiteToRefMRsMap[analysisUtil::getLLVMCallSite(callSites[csRefSets[i].first])]);
+    for (u32_t i = 0; i < csModSets.size(); i++)
+        fillMRSet(csModSets[i].second,
+                 callsiteToModMRsMap[analysisUtil::getLLVMCallSite(callSites[csModSets[i].first])]);
+    return true;
+}
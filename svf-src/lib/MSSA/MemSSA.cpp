@@ -38,6 +38,7 @@
 #include <llvm/Analysis/CFG.h>	// for CFG
 #include <llvm/Support/raw_ostream.h>	// for output
 #include <llvm/Support/CommandLine.h>
+#include <time.h>
 
 using namespace llvm;
 using namespace analysisUtil;
@@ -63,13 +64,14 @@ double MemSSA::timeOfSSARenaming  = 0;	///< Time for SSA rename
 /*!
  * Constructor
  */
-MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL) {
+MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL),parent(NULL) {
     pta = p;
     assert((pta->getAnalysisTy()!=PointerAnalysis::Default_PTA)
            && "please specify a pointer analysis");
 
+    std::string strategy = kIntraDisjointMemPar;
     if (!MemPar.getValue().empty()) {
-        std::string strategy = MemPar.getValue();
+        strategy = MemPar.getValue();
         if (strategy == kDistinctMemPar)
             mrGen = new DistinctMRG(pta);
         else if (strategy == kIntraDisjointMemPar)
@@ -87,11 +89,116 @@ MemSSA::MemSSA(BVDataPTAImpl* p) : df(NULL),dt(NULL) {
 
     /// Generate whole program memory regions
     double mrStart = stat->getClk();
-    mrGen->generateMRs();
+    /// [OS-CFI] Regions of an earlier run on the same snapshot are read back
+    std::string snapshot;
+    if (!pta->getSnapshotFile().empty())
+        snapshot = pta->getSnapshotFile() + "." + strategy + ".mr";
+    if (snapshot.empty() || !mrGen->readFromFile(snapshot)) {
+        mrGen->generateMRs();
+        if (!snapshot.empty())
+            mrGen->writeToFile(snapshot);
+    }
     double mrEnd = stat->getClk();
     timeOfGeneratingMemRegions += (mrEnd - mrStart)/TIMEINTERVAL;
 }
 
+/*!
+ * Constructor of a shard
+ */
+MemSSA::MemSSA(MemSSA* p) : pta(p->pta), mrGen(p->mrGen), df(NULL), dt(NULL),
+    stat(p->stat), parent(p), shardTimeOfCreateMUCHI(0),
+    shardTimeOfInsertingPHI(0), shardTimeOfSSARenaming(0) {
+}
+
+/*!
+ * clock() counts the CPU time of all threads of the process
+ */
+double MemSSA::getClk() const {
+    if (parent == NULL)
+        return stat->getClk();
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * TIMEINTERVAL + (double)ts.tv_nsec / (1000000000 / TIMEINTERVAL);
+}
+
+/*!
+ * A shard never calls functionDoesNotRet, which may print a warning
+ */
+bool MemSSA::doesNotRet(const Function* fun) const {
+    if (parent)
+        return parent->noRetFuns.count(fun);
+    return functionDoesNotRet(fun);
+}
+
+/*!
+ * The region sets of loads and stores are looked up with operator[], which
+ * inserts an empty set for a load or store without any region
+ */
+void MemSSA::prepareShards(const std::vector<const Function*>& funs) {
+    PAGEdge::PAGEdgeSetTy& loads = getPAG()->getEdgeSet(PAGEdge::Load);
+    for (PAGEdge::PAGEdgeSetTy::iterator it = loads.begin(), eit = loads.end(); it != eit; ++it)
+        mrGen->getLoadMRSet(cast<LoadPE>(*it));
+    PAGEdge::PAGEdgeSetTy& stores = getPAG()->getEdgeSet(PAGEdge::Store);
+    for (PAGEdge::PAGEdgeSetTy::iterator it = stores.begin(), eit = stores.end(); it != eit; ++it)
+        mrGen->getStoreMRSet(cast<StorePE>(*it));
+
+    for (std::vector<const Function*>::const_iterator it = funs.begin(), eit = funs.end(); it != eit; ++it) {
+        if (functionDoesNotRet(*it))
+            noRetFuns.insert(*it);
+    }
+}
+
+/*!
+ * The function is walked in a fixed order, so that the mus/chis/phis are
+ * added to the maps of this MemSSA in the same order whichever shard built
+ * them. The shard keeps empty sets, which it releases without deleting
+ * anything.
+ */
+void MemSSA::mergeShard(MemSSA* shard, const Function& fun) {
+    FunToEntryChiSetMap::iterator chiIt = shard->funToEntryChiSetMap.find(&fun);
+    if (chiIt != shard->funToEntryChiSetMap.end())
+        funToEntryChiSetMap[&fun].swap(chiIt->second);
+    FunToReturnMuSetMap::iterator muIt = shard->funToReturnMuSetMap.find(&fun);
+    if (muIt != shard->funToReturnMuSetMap.end())
+        funToReturnMuSetMap[&fun].swap(muIt->second);
+
+    for (Function::const_iterator bit = fun.begin(), ebit = fun.end(); bit != ebit; ++bit) {
+        const BasicBlock* bb = &*bit;
+        BBToPhiSetMap::iterator phiIt = shard->bb2PhiSetMap.find(bb);
+        if (phiIt != shard->bb2PhiSetMap.end())
+            bb2PhiSetMap[bb].swap(phiIt->second);
+
+        for (BasicBlock::const_iterator it = bb->begin(), eit = bb->end(); it != eit; ++it) {
+            const Instruction* inst = &*it;
+            if (mrGen->hasPAGEdgeList(inst)) {
+                PAGEdgeList& pagEdgeList = mrGen->getPAGEdgesFromInst(inst);
+                for (PAGEdgeList::const_iterator pit = pagEdgeList.begin(),
+                        epit = pagEdgeList.end(); pit != epit; ++pit) {
+                    if (const LoadPE* load = dyn_cast<LoadPE>(*pit)) {
+                        LoadToMUSetMap::iterator lit = shard->load2MuSetMap.find(load);
+                        if (lit != shard->load2MuSetMap.end())
+                            load2MuSetMap[load].swap(lit->second);
+                    }
+                    else if (const StorePE* store = dyn_cast<StorePE>(*pit)) {
+                        StoreToChiSetMap::iterator sit = shard->store2ChiSetMap.find(store);
+                        if (sit != shard->store2ChiSetMap.end())
+                            store2ChiSetMap[store].swap(sit->second);
+                    }
+                }
+            }
+            if (isCallSite(inst) && isInstrinsicDbgInst(inst)==false) {
+                CallSite cs = analysisUtil::getLLVMCallSite(inst);
+                CallSiteToMUSetMap::iterator cmuIt = shard->callsiteToMuSetMap.find(cs);
+                if (cmuIt != shard->callsiteToMuSetMap.end())
+                    callsiteToMuSetMap[cs].swap(cmuIt->second);
+                CallSiteToCHISetMap::iterator cchiIt = shard->callsiteToChiSetMap.find(cs);
+                if (cchiIt != shard->callsiteToChiSetMap.end())
+                    callsiteToChiSetMap[cs].swap(cchiIt->second);
+            }
+        }
+    }
+}
+
 /*!
  * Set DF/DT
  */
@@ -114,23 +221,28 @@ void MemSSA::buildMemSSA(const Function& fun, DominanceFrontier* f, DominatorTre
 
     setCurrentDFDT(f,t);
 
+    /// [OS-CFI] a shard keeps its phase times until it is released
+    double& muchiTime = parent ? shardTimeOfCreateMUCHI : timeOfCreateMUCHI;
+    double& phiTime = parent ? shardTimeOfInsertingPHI : timeOfInsertingPHI;
+    double& renameTime = parent ? shardTimeOfSSARenaming : timeOfSSARenaming;
+
     /// Create mus/chis for loads/stores/calls for memory regions
-    double muchiStart = stat->getClk();
+    double muchiStart = getClk();
     createMUCHI(fun);
-    double muchiEnd = stat->getClk();
-    timeOfCreateMUCHI += (muchiEnd - muchiStart)/TIMEINTERVAL;
+    double muchiEnd = getClk();
+    muchiTime += (muchiEnd - muchiStart)/TIMEINTERVAL;
 
     /// Insert PHI for memory regions
-    double phiStart = stat->getClk();
+    double phiStart = getClk();
     insertPHI(fun);
-    double phiEnd = stat->getClk();
-    timeOfInsertingPHI += (phiEnd - phiStart)/TIMEINTERVAL;
+    double phiEnd = getClk();
+    phiTime += (phiEnd - phiStart)/TIMEINTERVAL;
 
     /// SSA rename for memory regions
-    double renameStart = stat->getClk();
+    double renameStart = getClk();
     SSARename(fun);
-    double renameEnd = stat->getClk();
-    timeOfSSARenaming += (renameEnd - renameStart)/TIMEINTERVAL;
+    double renameEnd = getClk();
+    renameTime += (renameEnd - renameStart)/TIMEINTERVAL;
 
 }
 
@@ -206,7 +318,7 @@ void MemSSA::createMUCHI(const Function& fun) {
 
         /// if the function does not have a reachable return instruction from function entry
         /// then we won't create return mu for it
-        if(functionDoesNotRet(&fun) == false) {
+        if(doesNotRet(&fun) == false) {
             RETMU* mu = new RETMU(&fun, mr);
             funToReturnMuSetMap[&fun].insert(mu);
         }
@@ -440,9 +552,17 @@ void MemSSA::destroy() {
         }
     }
 
-    delete mrGen;
+    /// [OS-CFI] the regions and the statistics belong to the parent of a shard
+    if (parent) {
+        timeOfCreateMUCHI += shardTimeOfCreateMUCHI;
+        timeOfInsertingPHI += shardTimeOfInsertingPHI;
+        timeOfSSARenaming += shardTimeOfSSARenaming;
+    }
+    else {
+        delete mrGen;
+        delete stat;
+    }
     mrGen = NULL;
-    delete stat;
     stat = NULL;
     pta = NULL;
 }
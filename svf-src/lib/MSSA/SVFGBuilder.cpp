@@ -31,6 +31,8 @@
 #include "MSSA/SVFG.h"
 #include "MSSA/SVFGBuilder.h"
 #include "WPA/Andersen.h"
+#include <atomic>
+#include <thread>
 
 using namespace llvm;
 using namespace analysisUtil;
@@ -41,6 +43,10 @@ static cl::opt<bool> SVFGWithIndirectCall("svfgWithIndCall", cl::init(false),
 static cl::opt<bool> SingleVFG("singleVFG", cl::init(false),
                                cl::desc("Create a single VFG shared by multiple analysis"));
 
+// [OS-CFI] threads building the memory SSA of functions
+static cl::opt<unsigned> MSSAJobs("mssa-jobs", cl::init(1),
+                                  cl::desc("Number of threads building memory SSA"));
+
 SVFGOPT* SVFGBuilder::globalSvfg = NULL;
 
 /*!
@@ -90,21 +96,25 @@ bool SVFGBuilder::build(SVFG* graph,BVDataPTAImpl* pta) {
 
     DBOUT(DGENERAL, outs() << pasMsg("Build Memory SSA \n"));
 
-    DominatorTree dt;
-    MemSSADF df;
+    if (MSSAJobs > 1)
+        buildMemSSAInParallel(mssa, pta);
+    else {
+        DominatorTree dt;
+        MemSSADF df;
 
-    SVFModule svfModule = pta->getModule();
-    for (SVFModule::iterator iter = svfModule.begin(), eiter = svfModule.end();
-            iter != eiter; ++iter) {
+        SVFModule svfModule = pta->getModule();
+        for (SVFModule::iterator iter = svfModule.begin(), eiter = svfModule.end();
+                iter != eiter; ++iter) {
 
-        llvm::Function *fun = *iter;
-        if (analysisUtil::isExtCall(fun))
-            continue;
+            llvm::Function *fun = *iter;
+            if (analysisUtil::isExtCall(fun))
+                continue;
 
-        dt.recalculate(*fun);
-        df.runOnDT(dt);
+            dt.recalculate(*fun);
+            df.runOnDT(dt);
 
-        mssa->buildMemSSA(*fun, &df, &dt);
+            mssa->buildMemSSA(*fun, &df, &dt);
+        }
     }
 
     mssa->performStat();
@@ -123,6 +133,57 @@ bool SVFGBuilder::build(SVFG* graph,BVDataPTAImpl* pta) {
     return false;
 }
 
+/*!
+ * [OS-CFI] The threads take the functions one at a time, each builds into a
+ * MemSSA shard of its own with its own dominator tree and frontier. The
+ * shards are merged function by function in module order afterwards, so the
+ * memory SSA and the SVFG built on top of it serially do not depend on the
+ * number of threads.
+ */
+void SVFGBuilder::buildMemSSAInParallel(MemSSA* mssa, BVDataPTAImpl* pta) {
+
+    std::vector<const Function*> funs;
+    SVFModule svfModule = pta->getModule();
+    for (SVFModule::iterator iter = svfModule.begin(), eiter = svfModule.end();
+            iter != eiter; ++iter) {
+        if (analysisUtil::isExtCall(*iter) == false)
+            funs.push_back(*iter);
+    }
+    if (funs.empty())
+        return;
+
+    mssa->prepareShards(funs);
+
+    u32_t jobs = std::min<u32_t>(MSSAJobs, funs.size());
+    std::vector<MemSSA*> shards;
+    for (u32_t job = 0; job < jobs; job++)
+        shards.push_back(new MemSSA(mssa));
+    std::vector<u32_t> funToShard(funs.size(), 0);
+    std::atomic<u32_t> nextFun(0);
+    auto worker = [&](u32_t job) {
+        DominatorTree dt;
+        MemSSADF df;
+        for (u32_t i = nextFun++; i < funs.size(); i = nextFun++) {
+            Function* fun = const_cast<Function*>(funs[i]);
+            dt.recalculate(*fun);
+            df.runOnDT(dt);
+            shards[job]->buildMemSSA(*fun, &df, &dt);
+            funToShard[i] = job;
+        }
+    };
+    std::vector<std::thread> threads;
+    for (u32_t job = 1; job < jobs; job++)
+        threads.push_back(std::thread(worker, job));
+    worker(0);
+    for (u32_t job = 0; job < threads.size(); job++)
+        threads[job].join();
+
+    for (u32_t i = 0; i < funs.size(); i++)
+        mssa->mergeShard(shards[funToShard[i]], *funs[i]);
+    for (u32_t job = 0; job < jobs; job++)
+        delete shards[job];
+}
+
 
 
 /// Update call graph using pre-analysis results
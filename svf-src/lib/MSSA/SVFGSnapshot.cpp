@@ -0,0 +1,137 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "MSSA/SVFGSnapshot.h"
+#include <llvm/Support/CommandLine.h>
+#include <chrono>
+
+using namespace llvm;
+
+static cl::bits<PointerAnalysis::PTATY> SVFGCSRSelected("svfg-csr", cl::CommaSeparated,
+        cl::desc("Analyses reading SVFG edges from a frozen CSR snapshot"),
+        cl::values(clEnumValN(PointerAnalysis::FlowS_DDA, "dfs", "Demand-driven flow sensitive analysis"),
+                   clEnumValN(PointerAnalysis::Cxt_DDA, "cxt", "Demand-driven context- flow- sensitive analysis")));
+
+static cl::opt<bool> SVFGCSRBench("svfg-csr-bench", cl::init(false),
+                                  cl::desc("Measure SVFG edge iteration with and without the CSR snapshot"));
+
+static cl::opt<unsigned> SVFGCSRBenchRounds("svfg-csr-bench-rounds", cl::init(20),
+        cl::desc("Passes over all SVFG edges per measurement"));
+
+/*!
+ * Take the snapshot, node by node in id order
+ */
+SVFGSnapshot::SVFGSnapshot(const SVFG* g): svfg(g) {
+    NodeID numOfIds = 0;
+    for (SVFG::SVFGNodeIDToNodeMapTy::const_iterator it = svfg->begin(), eit = svfg->end(); it != eit; ++it)
+        numOfIds = std::max(numOfIds, it->first + 1);
+
+    offsets.reserve(numOfIds * NumOfGroups + 1);
+    for (NodeID id = 0; id < numOfIds; id++) {
+        const SVFGNode* node = svfg->hasGNode(id) ? svfg->getGNode(id) : NULL;
+        for (u32_t group = Direct; group < NumOfGroups; group++) {
+            offsets.push_back(edges.size());
+            if (node == NULL)
+                continue;
+            for (SVFGNode::const_iterator edgeIt = node->InEdgeBegin(), edgeEit = node->InEdgeEnd(); edgeIt != edgeEit;
+                    ++edgeIt) {
+                if (getEdgeGroup(*edgeIt) == group)
+                    edges.push_back(*edgeIt);
+            }
+        }
+    }
+    offsets.push_back(edges.size());
+
+    if (SVFGCSRBench)
+        benchmark();
+}
+
+/*!
+ * Group of an edge
+ */
+SVFGSnapshot::EdgeGroup SVFGSnapshot::getEdgeGroup(const SVFGEdge* edge) {
+    return edge->isDirectVFGEdge() ? Direct : Indirect;
+}
+
+/*!
+ * In-edges of the groups [first, last) of a node
+ */
+SVFGSnapshot::EdgeRange SVFGSnapshot::getInEdges(const SVFGNode* node, EdgeGroup first, EdgeGroup last,
+        SVFGEdgeVec& scratch) const {
+    u32_t base = node->getId() * NumOfGroups;
+    if (base + NumOfGroups >= offsets.size() ||
+            offsets[base + NumOfGroups] - offsets[base] != node->getInEdges().size())
+        return collectInEdges(node, first, last, scratch);
+    SVFGEdge* const* data = edges.data();
+    return std::make_pair(data + offsets[base + first], data + offsets[base + last]);
+}
+
+/*!
+ * Copy the in-edges of the groups [first, last) in snapshot order
+ */
+SVFGSnapshot::EdgeRange SVFGSnapshot::collectInEdges(const SVFGNode* node, EdgeGroup first, EdgeGroup last,
+        SVFGEdgeVec& scratch) {
+    scratch.clear();
+    for (u32_t group = first; group < last; group++) {
+        for (SVFGNode::const_iterator it = node->InEdgeBegin(), eit = node->InEdgeEnd(); it != eit; ++it) {
+            if (getEdgeGroup(*it) == group)
+                scratch.push_back(*it);
+        }
+    }
+    SVFGEdge* const* data = scratch.data();
+    return std::make_pair(data, data + scratch.size());
+}
+
+bool SVFGSnapshot::isSelected(PointerAnalysis::PTATY ty) {
+    return SVFGCSRSelected.isSet(ty);
+}
+
+/*!
+ * Visit the direct and the indirect in-edges of every node, once by copying
+ * the node's edge set as the solver did before and once from the snapshot
+ */
+void SVFGSnapshot::benchmark() const {
+    typedef std::chrono::steady_clock Clock;
+    u64_t checksum = 0;
+    u64_t visited = 0;
+
+    Clock::time_point start = Clock::now();
+    for (u32_t round = 0; round < SVFGCSRBenchRounds; round++) {
+        for (SVFG::SVFGNodeIDToNodeMapTy::const_iterator it = svfg->begin(), eit = svfg->end(); it != eit; ++it) {
+            const SVFGEdge::SVFGEdgeSetTy edgeSet(it->second->getInEdges());
+            for (SVFGNode::const_iterator edgeIt = edgeSet.begin(), edgeEit = edgeSet.end(); edgeIt != edgeEit; ++edgeIt) {
+                if (const DirectSVFGEdge* edge = dyn_cast<DirectSVFGEdge>(*edgeIt))
+                    checksum += edge->getSrcID();
+            }
+            const SVFGEdge::SVFGEdgeSetTy indEdgeSet(it->second->getInEdges());
+            for (SVFGNode::const_iterator edgeIt = indEdgeSet.begin(), edgeEit = indEdgeSet.end(); edgeIt != edgeEit; ++edgeIt) {
+                if (const IndirectSVFGEdge* edge = dyn_cast<IndirectSVFGEdge>(*edgeIt))
+                    checksum += edge->getSrcID();
+            }
+            visited += edgeSet.size();
+        }
+    }
+    double setTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+    start = Clock::now();
+    SVFGEdgeVec scratch;
+    for (u32_t round = 0; round < SVFGCSRBenchRounds; round++) {
+        for (SVFG::SVFGNodeIDToNodeMapTy::const_iterator it = svfg->begin(), eit = svfg->end(); it != eit; ++it) {
+            EdgeRange range = getDirectInEdges(it->second, scratch);
+            for (SVFGEdge* const* edgeIt = range.first; edgeIt != range.second; ++edgeIt)
+                checksum -= (*edgeIt)->getSrcID();
+            range = getIndirectInEdges(it->second, scratch);
+            for (SVFGEdge* const* edgeIt = range.first; edgeIt != range.second; ++edgeIt)
+                checksum -= (*edgeIt)->getSrcID();
+        }
+    }
+    double csrTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (checksum != 0)
+        outs() << "[OS-CFI] SVFG snapshot and SVFG disagree on the in-edges\n";
+    outs() << "[OS-CFI] SVFG edge iteration over " << visited << " edges: set copy "
+           << setTime << "s (" << (setTime > 0 ? visited / setTime / 1e6 : 0) << " M edges/s), snapshot "
+           << csrTime << "s (" << (csrTime > 0 ? visited / csrTime / 1e6 : 0) << " M edges/s)\n";
+}
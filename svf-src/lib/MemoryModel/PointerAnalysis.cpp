@@ -13,7 +13,10 @@
 #include "Util/PTAStat.h"
 #include "Util/SVFModule.h"
 #include "Util/ThreadCallGraph.h"
+#include <cstring>
 #include <fstream>
+#include <llvm/Support/MemoryBuffer.h>
+#include <set>
 #include <sstream>
 
 using namespace llvm;
@@ -39,6 +42,41 @@ static cl::opt<bool>
 static cl::opt<bool> PStat("stat", cl::init(true),
                            cl::desc("Statistic for Pointer analysis"));
 
+// [OS-CFI] -write-ander stores the binary format unless text is requested,
+// -read-ander accepts both
+static cl::opt<bool>
+    AnderText("ander-text", cl::init(false),
+              cl::desc("Store pointer analysis results as text lines"));
+
+// [OS-CFI] binary points-to file: a header, a fixed-size index entry per
+// variable (id, number of objects, offset of its objects in the data area),
+// a fixed-size entry per field object (id, base object, offset) and the data
+// area, where the sorted objects of a variable are stored as LEB128 deltas.
+// The file is read in place through a memory mapped buffer.
+static const char AnderMagic[8] = {'O', 'S', 'C', 'F', 'I', 'P', 'T', 'S'};
+static const u32_t AnderVersion = 1;
+
+struct AnderFileHeader {
+  char magic[8];
+  u32_t version;
+  u32_t numOfVars;
+  u32_t numOfGepObjs;
+  u32_t reserved;
+  u64_t dataSize;
+};
+
+struct AnderVarEntry {
+  u32_t var;
+  u32_t numOfObjs;
+  u64_t offset;
+};
+
+struct AnderGepObjEntry {
+  u32_t id;
+  u32_t base;
+  u64_t offset;
+};
+
 static cl::opt<unsigned>
     statBudget("statlimit", cl::init(20),
                cl::desc("Iteration budget for On-the-fly statistics"));
@@ -324,6 +362,16 @@ void BVDataPTAImpl::writeToFile(const string &filename) {
     return;
   }
 
+  if (!AnderText) {
+    writeBinaryFile(F.os());
+    F.os().close();
+    if (!F.os().has_error()) {
+      outs() << "\n";
+      F.keep();
+    }
+    return;
+  }
+
   // Write analysis results to file
   PTDataTy *ptD = getPTDataTy();
   auto &ptsMap = ptD->getPtsMap();
@@ -378,6 +426,20 @@ void BVDataPTAImpl::writeToFile(const string &filename) {
 bool BVDataPTAImpl::readFromFile(const string &filename) {
   outs() << "Loading pointer analysis results from '" << filename << "'...";
 
+  // [OS-CFI] map the binary format and read it in place
+  ErrorOr<std::unique_ptr<MemoryBuffer>> buf =
+      MemoryBuffer::getFile(filename, -1, false);
+  if (buf && (*buf)->getBufferSize() >= sizeof(AnderMagic) &&
+      memcmp((*buf)->getBufferStart(), AnderMagic, sizeof(AnderMagic)) == 0) {
+    if (!readBinaryFile((*buf)->getBufferStart(), (*buf)->getBufferSize())) {
+      outs() << "  malformed pointer analysis results!\n";
+      return false;
+    }
+    updateCallGraph(pag->getIndirectCallsites());
+    outs() << "\n";
+    return true;
+  }
+
   ifstream F(filename.c_str());
   if (!F.is_open()) {
     outs() << "  error opening file for reading!\n";
@@ -442,6 +504,163 @@ bool BVDataPTAImpl::readFromFile(const string &filename) {
   return true;
 }
 
+/*!
+ * [OS-CFI] Store the points-to data and the PAG offset nodes in the binary
+ * format
+ */
+void BVDataPTAImpl::writeBinaryFile(raw_ostream &os) {
+  AnderFileHeader header;
+  memcpy(header.magic, AnderMagic, sizeof(AnderMagic));
+  header.version = AnderVersion;
+  header.numOfVars = 0;
+  header.numOfGepObjs = 0;
+  header.reserved = 0;
+  header.dataSize = 0;
+
+  std::vector<AnderVarEntry> vars;
+  std::string data;
+  auto &ptsMap = getPTDataTy()->getPtsMap();
+  for (auto it = ptsMap.begin(), ie = ptsMap.end(); it != ie; ++it) {
+    const PointsTo &pts = getPts(it->first);
+    AnderVarEntry entry = {it->first, 0, data.size()};
+    NodeID last = 0;
+    for (PointsTo::iterator pit = pts.begin(), pie = pts.end(); pit != pie;
+         ++pit, ++entry.numOfObjs) {
+      u32_t delta = *pit - last;
+      last = *pit;
+      do {
+        char byte = delta & 0x7f;
+        delta >>= 7;
+        data.push_back(delta ? (byte | 0x80) : byte);
+      } while (delta);
+    }
+    vars.push_back(entry);
+  }
+
+  std::vector<AnderGepObjEntry> gepObjs;
+  for (NodeID i = 0, e = pag->getTotalNodeNum(); i != e; ++i) {
+    if (GepObjPN *gepObjPN = dyn_cast<GepObjPN>(pag->getPAGNode(i))) {
+      AnderGepObjEntry entry = {i, pag->getBaseObjNode(i),
+                                gepObjPN->getLocationSet().getOffset()};
+      gepObjs.push_back(entry);
+    }
+  }
+
+  header.numOfVars = vars.size();
+  header.numOfGepObjs = gepObjs.size();
+  header.dataSize = data.size();
+  os.write((const char *)&header, sizeof(header));
+  os.write((const char *)vars.data(), vars.size() * sizeof(AnderVarEntry));
+  os.write((const char *)gepObjs.data(),
+           gepObjs.size() * sizeof(AnderGepObjEntry));
+  os.write(data.data(), data.size());
+}
+
+/*!
+ * [OS-CFI] Decode the objects of a variable entry, false if they run past the
+ * data area or name a node beyond numOfNodes. pts may be NULL to only check.
+ */
+static bool decodeObjs(const AnderVarEntry &entry, const unsigned char *data,
+                       u64_t dataSize, NodeID numOfNodes, PointsTo *pts) {
+  u64_t pos = entry.offset;
+  NodeID obj = 0;
+  for (u32_t j = 0; j < entry.numOfObjs; j++) {
+    u32_t delta = 0;
+    for (u32_t shift = 0;; shift += 7) {
+      if (pos >= dataSize || shift > 28)
+        return false;
+      unsigned char byte = data[pos++];
+      delta |= (u32_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        break;
+    }
+    obj += delta;
+    if (obj < delta || obj >= numOfNodes)
+      return false;
+    if (pts)
+      pts->set(obj);
+  }
+  return true;
+}
+
+/*!
+ * [OS-CFI] Load the binary format, false if the buffer is malformed. The whole
+ * buffer is checked before the PAG or the points-to data are touched, so a
+ * rejected file leaves the analysis as it was.
+ */
+bool BVDataPTAImpl::readBinaryFile(const char *buf, size_t size) {
+  if (size < sizeof(AnderFileHeader))
+    return false;
+  AnderFileHeader header;
+  memcpy(&header, buf, sizeof(header));
+  size_t varSize = (size_t)header.numOfVars * sizeof(AnderVarEntry);
+  size_t gepSize = (size_t)header.numOfGepObjs * sizeof(AnderGepObjEntry);
+  if (header.version != AnderVersion || header.dataSize > size ||
+      size != sizeof(header) + varSize + gepSize + header.dataSize)
+    return false;
+  const char *vars = buf + sizeof(header);
+  const char *gepObjs = vars + varSize;
+  const unsigned char *data =
+      (const unsigned char *)(gepObjs + gepSize);
+
+  // Check the PAG offset nodes: the base is an object of this PAG, and the
+  // node either exists under the same id or is the next one to be created
+  NodeID numOfNodes = pag->getTotalNodeNum();
+  std::set<std::pair<NodeID, u64_t>> newGepObjs;
+  for (u32_t i = 0; i < header.numOfGepObjs; i++) {
+    AnderGepObjEntry entry;
+    memcpy(&entry, gepObjs + i * sizeof(entry), sizeof(entry));
+    if (entry.base >= pag->getTotalNodeNum() || !pag->findPAGNode(entry.base))
+      return false;
+    const MemObj *obj = pag->getObject(entry.base);
+    if (obj == NULL || obj->isFieldInsensitive() ||
+        pag->getObjectNode(obj) != entry.base)
+      return false;
+    LocationSet ls = SymbolTableInfo::Symbolnfo()->getModulusOffset(
+        obj->getTypeInfo(), LocationSet(entry.offset));
+    if ((u64_t)ls.getOffset() != entry.offset)
+      return false;
+    NodeID id = 0;
+    if (pag->hasGepObjNode(entry.base, ls, id)) {
+      if (id != entry.id)
+        return false;
+    } else if (entry.id != numOfNodes++ ||
+               !newGepObjs.insert(std::make_pair(entry.base, entry.offset))
+                    .second) {
+      return false;
+    }
+  }
+
+  // Check the points-to sets against the PAG as it will be
+  for (u32_t i = 0; i < header.numOfVars; i++) {
+    AnderVarEntry entry;
+    memcpy(&entry, vars + i * sizeof(entry), sizeof(entry));
+    if (entry.var >= numOfNodes ||
+        !decodeObjs(entry, data, header.dataSize, numOfNodes, NULL))
+      return false;
+  }
+
+  // Read PAG offset nodes
+  for (u32_t i = 0; i < header.numOfGepObjs; i++) {
+    AnderGepObjEntry entry;
+    memcpy(&entry, gepObjs + i * sizeof(entry), sizeof(entry));
+    NodeID n = pag->getGepObjNode(pag->getObject(entry.base),
+                                  LocationSet(entry.offset));
+    assert(n == entry.id && "Error adding GepObjNode into PAG!");
+    (void)n;
+  }
+
+  // Read points-to sets
+  PTDataTy *ptD = getPTDataTy();
+  for (u32_t i = 0; i < header.numOfVars; i++) {
+    AnderVarEntry entry;
+    memcpy(&entry, vars + i * sizeof(entry), sizeof(entry));
+    decodeObjs(entry, data, header.dataSize, numOfNodes,
+               &ptD->getPts(entry.var));
+  }
+  return true;
+}
+
 /*!
  * Dump points-to of each pag node
  */
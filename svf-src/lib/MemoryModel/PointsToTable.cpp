@@ -0,0 +1,184 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "MemoryModel/PointsToTable.h"
+#include <llvm/ADT/Hashing.h>
+#include <algorithm>
+
+using namespace llvm;
+
+/// Inline handles: tag bit, 2-bit object count and three 20-bit objects
+#define INLINE_PTS_TAG (1ULL << 63)
+#define INLINE_PTS_COUNT_SHIFT 61
+#define INLINE_PTS_OBJ_BITS 20
+#define INLINE_PTS_MAX_OBJS 3
+
+/// Memo entries kept before the cache is flushed, and freed slots waiting for
+/// a flush before they force one
+#define MAX_OP_CACHE_ENTRIES (1U << 20)
+#define MAX_RELEASED_SLOTS (1U << 16)
+
+/*!
+ * Global table
+ */
+PointsToTable* PointsToTable::getTable() {
+    static PointsToTable table;
+    return &table;
+}
+
+/*!
+ * Encode a set of at most three objects below 2^20 in its handle
+ */
+bool PointsToTable::encodeInline(const PointsTo& pts, PointsToID& id) {
+    PointsToID handle = 0;
+    u32_t num = 0;
+    for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it, ++num) {
+        if (num == INLINE_PTS_MAX_OBJS || *it >= (1U << INLINE_PTS_OBJ_BITS))
+            return false;
+        handle |= (PointsToID)*it << (num * INLINE_PTS_OBJ_BITS);
+    }
+    id = INLINE_PTS_TAG | ((PointsToID)num << INLINE_PTS_COUNT_SHIFT) | handle;
+    return true;
+}
+
+void PointsToTable::decodeInline(PointsToID id, PointsTo& pts) const {
+    u32_t num = (id >> INLINE_PTS_COUNT_SHIFT) & 0x3;
+    for (u32_t i = 0; i < num; i++)
+        pts.set((id >> (i * INLINE_PTS_OBJ_BITS)) & ((1U << INLINE_PTS_OBJ_BITS) - 1));
+}
+
+bool PointsToTable::isTableSet(PointsToID id) const {
+    return id != EmptyPts && !(id & INLINE_PTS_TAG);
+}
+
+u64_t PointsToTable::hashPts(const PointsTo& pts) {
+    hash_code hash = hash_value(pts.count());
+    for (PointsTo::iterator it = pts.begin(), eit = pts.end(); it != eit; ++it)
+        hash = hash_combine(hash, *it);
+    return (size_t)hash & ~INLINE_PTS_TAG;
+}
+
+/*!
+ * Intern a set, equal sets always get the same handle.
+ * A new set has no holder until it is assigned.
+ */
+PointsToID PointsToTable::intern(const PointsTo& pts) {
+    if (pts.empty())
+        return EmptyPts;
+
+    PointsToID id = EmptyPts;
+    if (encodeInline(pts, id)) {
+        inlineSets.insert(id);
+        return id;
+    }
+
+    SmallVector<u32_t, 1>& candidates = hashToSets[hashPts(pts)];
+    for (u32_t i = 0; i < candidates.size(); i++) {
+        if (sets[candidates[i]] == pts)
+            return candidates[i];
+    }
+    if (freeSlots.empty()) {
+        id = sets.size();
+        sets.push_back(pts);
+        refCounts.push_back(0);
+    } else {
+        id = freeSlots.back();
+        freeSlots.pop_back();
+        sets[id] = pts;
+        refCounts[id] = 0;
+    }
+    candidates.push_back(id);
+    return id;
+}
+
+/*!
+ * Reference counting
+ */
+void PointsToTable::retain(PointsToID id) {
+    if (isTableSet(id))
+        refCounts[id]++;
+}
+
+void PointsToTable::release(PointsToID id) {
+    if (isTableSet(id) && --refCounts[id] == 0)
+        freeSet(id);
+}
+
+/*!
+ * Drop a set nobody holds. Memo entries may still name its handle, so the
+ * slot waits in releasedSlots until the caches are flushed.
+ */
+void PointsToTable::freeSet(PointsToID id) {
+    HashToSetsMap::iterator it = hashToSets.find(hashPts(sets[id]));
+    assert(it != hashToSets.end() && "interned set not found");
+    SmallVector<u32_t, 1>& candidates = it->second;
+    candidates.erase(std::find(candidates.begin(), candidates.end(), id));
+    if (candidates.empty())
+        hashToSets.erase(it);
+
+    sets[id].clear();
+    refCounts[id] = FreedSet;
+    releasedSlots.push_back(id);
+    if (releasedSlots.size() >= MAX_RELEASED_SLOTS)
+        flushOpCache();
+}
+
+/*!
+ * Memo cache, a result whose set has been freed is a miss
+ */
+bool PointsToTable::lookup(const PointsToIDPair& key, PointsToID& id) const {
+    OpCacheMap::const_iterator it = intersectCache.find(key);
+    if (it == intersectCache.end() || !isLive(it->second))
+        return false;
+    id = it->second;
+    return true;
+}
+
+void PointsToTable::memoize(const PointsToIDPair& key, PointsToID id) {
+    if (intersectCache.size() >= MAX_OP_CACHE_ENTRIES)
+        flushOpCache();
+    intersectCache[key] = id;
+}
+
+/*!
+ * Forget all memoized results, the freed slots can then be reused
+ */
+void PointsToTable::flushOpCache() {
+    intersectCache.clear();
+    freeSlots.insert(freeSlots.end(), releasedSlots.begin(), releasedSlots.end());
+    releasedSlots.clear();
+}
+
+/*!
+ * Return the set of a handle
+ */
+const PointsTo& PointsToTable::getPts(PointsToID id, PointsTo& scratch) const {
+    if (!(id & INLINE_PTS_TAG))
+        return sets[id];
+    scratch.clear();
+    decodeInline(id, scratch);
+    return scratch;
+}
+
+/*!
+ * lhs & rhs
+ */
+PointsToID PointsToTable::intersectPts(PointsToID lhs, PointsToID rhs) {
+    if (lhs == rhs)
+        return lhs;
+    if (lhs == EmptyPts || rhs == EmptyPts)
+        return EmptyPts;
+    PointsToIDPair key = lhs < rhs ? std::make_pair(lhs, rhs) : std::make_pair(rhs, lhs);
+    PointsToID id = EmptyPts;
+    if (lookup(key, id))
+        return id;
+
+    PointsTo lhsScratch, rhsScratch;
+    PointsTo result = getPts(lhs, lhsScratch);
+    result &= getPts(rhs, rhsScratch);
+    id = intern(result);
+    memoize(key, id);
+    return id;
+}
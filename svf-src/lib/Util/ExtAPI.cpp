@@ -293,6 +293,7 @@ static const ei_pair ei_pairs[]= {
     {"open64", ExtAPI::EFT_NOOP},
     {"openlog", ExtAPI::EFT_NOOP},
     {"openpty", ExtAPI::EFT_NOOP},
+    {"oscfi_reclaim", ExtAPI::EFT_NOOP},
     {"pathconf", ExtAPI::EFT_NOOP},
     {"pclose", ExtAPI::EFT_NOOP},
     {"perror", ExtAPI::EFT_NOOP},
@@ -653,6 +654,7 @@ static const ei_pair ei_pairs[]= {
 
     {"getcwd", ExtAPI::EFT_REALLOC},
     {"mem_realloc", ExtAPI::EFT_REALLOC},
+    {"oscfi_realloc", ExtAPI::EFT_REALLOC},
     {"realloc", ExtAPI::EFT_REALLOC},
     {"realloc_obj", ExtAPI::EFT_REALLOC},
     {"safe_realloc", ExtAPI::EFT_REALLOC},
@@ -676,6 +678,7 @@ static const ei_pair ei_pairs[]= {
     {"globfree", ExtAPI::EFT_FREE},
     {"nhfree", ExtAPI::EFT_FREE},
     {"obstack_free", ExtAPI::EFT_FREE},
+    {"oscfi_free", ExtAPI::EFT_FREE},
     {"safe_cfree", ExtAPI::EFT_FREE},
     {"safe_free", ExtAPI::EFT_FREE},
     {"safefree", ExtAPI::EFT_FREE},
@@ -735,6 +738,8 @@ static const ei_pair ei_pairs[]= {
     {"memccpy", ExtAPI::EFT_L_A0__A0R_A1R},
     {"memcpy", ExtAPI::EFT_L_A0__A0R_A1R},
     {"memmove", ExtAPI::EFT_L_A0__A0R_A1R},
+    {"oscfi_memcpy", ExtAPI::EFT_L_A0__A0R_A1R},
+    {"oscfi_memmove", ExtAPI::EFT_L_A0__A0R_A1R},
     {"bcopy", ExtAPI::EFT_A1R_A0R},
     {"iconv", ExtAPI::EFT_A3R_A1R_NS},
     {"strtod", ExtAPI::EFT_A1R_A0},
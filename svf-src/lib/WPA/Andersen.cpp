@@ -32,6 +32,11 @@
 #include "Util/AnalysisUtil.h"
 
 #include <llvm/Support/CommandLine.h> // for tool output file
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 
 using namespace llvm;
 using namespace analysisUtil;
@@ -60,6 +65,46 @@ static cl::opt<string> WriteAnder("write-ander",  cl::init(""),
 static cl::opt<string> ReadAnder("read-ander",  cl::init(""),
                                  cl::desc("Read Andersen's analysis results from a file"));
 
+// [OS-CFI] results of earlier runs on the same bitcode are found by a hash.
+// Only Andersen's results and the memory regions of MemSSA are kept, the SVFG
+// is still built in every run. Storing the SVFG is left to a follow-up.
+static cl::opt<string> AnderSnapshot("ander-snapshot",  cl::init(""),
+                                     cl::desc("Directory keeping Andersen's analysis results of every analysed bitcode"));
+
+/*!
+ * [OS-CFI] Path of the snapshot of a module in the snapshot directory. The key
+ * hashes the bitcode of all modules, the analysis type and the size of the
+ * PAG before solving, which changes with the options building the PAG. The
+ * bitcode is hashed as mapped from its file, only a module that was not read
+ * from a file is serialized.
+ */
+static std::string getSnapshotPath(SVFModule svfModule, PointerAnalysis::PTATY ty, PAG* pag) {
+    MD5 md5;
+    for (u32_t i = 0; i < svfModule.getModuleNum(); i++) {
+        Module* mod = svfModule.getModule(i);
+        ErrorOr<std::unique_ptr<MemoryBuffer>> file =
+            MemoryBuffer::getFile(mod->getModuleIdentifier(), -1, false);
+        if (file) {
+            md5.update((*file)->getBuffer());
+            continue;
+        }
+        SmallVector<char, 0> bitcode;
+        raw_svector_ostream os(bitcode);
+        WriteBitcodeToFile(*mod, os);
+        md5.update(StringRef(bitcode.data(), bitcode.size()));
+    }
+    u64_t sizes[3] = {(u64_t)ty, pag->getTotalNodeNum(), pag->getTotalEdgeNum()};
+    md5.update(ArrayRef<uint8_t>((const uint8_t*)sizes, sizeof(sizes)));
+    MD5::MD5Result result;
+    md5.final(result);
+    SmallString<32> hex;
+    MD5::stringifyResult(result, hex);
+
+    SmallString<128> path(AnderSnapshot.getValue());
+    sys::path::append(path, hex.str() + ".ander");
+    return path.str().str();
+}
+
 
 
 /*!
@@ -71,8 +116,14 @@ void Andersen::analyze(SVFModule svfModule) {
 
 
     bool readResultsFromFile = false;
+    std::string snapshot;
+    if(!AnderSnapshot.empty())
+        snapshot = getSnapshotPath(svfModule, getAnalysisTy(), pag);
+
     if(!ReadAnder.empty())
         readResultsFromFile = this->readFromFile(ReadAnder);
+    else if(!snapshot.empty() && sys::fs::exists(snapshot))
+        readResultsFromFile = this->readFromFile(snapshot);
 
     if(!readResultsFromFile) {
         DBOUT(DGENERAL, llvm::outs() << analysisUtil::pasMsg("Start Solving Constraints\n"));
@@ -107,6 +158,15 @@ void Andersen::analyze(SVFModule svfModule) {
 
     if(!WriteAnder.empty())
         this->writeToFile(WriteAnder);
+    else if(!snapshot.empty() && !readResultsFromFile) {
+        if (std::error_code err = sys::fs::create_directories(AnderSnapshot))
+            wrnMsg("cannot create the snapshot directory: " + err.message());
+        else
+            this->writeToFile(snapshot);
+    }
+
+    if(ReadAnder.empty())
+        snapshotFile = snapshot;
 }
 
 
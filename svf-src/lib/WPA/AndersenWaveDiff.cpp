@@ -28,13 +28,25 @@
  */
 
 #include "WPA/Andersen.h"
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/Support/CommandLine.h> // for tool output file
+#include <mutex>
+#include <thread>
 
 using namespace llvm;
 using namespace analysisUtil;
 
 AndersenWaveDiff* AndersenWaveDiff::diffWave = NULL;
 
+// [OS-CFI] threads propagating the copy edges of a wave level
+static cl::opt<unsigned> AnderJobs("ander-jobs", cl::init(1),
+                                   cl::desc("Number of threads solving Andersen's copy edges"));
+
+/// [OS-CFI] lock stripes guarding the destination points-to sets
+static const u32_t NumOfPtsLocks = 64;
+/// [OS-CFI] copy edges of a wave level worth one thread
+static const u32_t MinCopiesPerJob = 256;
+
 
 /*!
  * Compute diff points-to set before propagation
@@ -80,11 +92,8 @@ void AndersenWaveDiff::processGep(NodeID node, const GepCGEdge* edge) {
 bool AndersenWaveDiff::handleLoad(NodeID node, const ConstraintEdge* edge)
 {
     /// calculate diff pts.
-    PointsTo & cache = getCachePts(edge);
-    PointsTo & pts = getPts(node);
     PointsTo newPts;
-    newPts.intersectWithComplement(pts, cache);
-    cache |= newPts;
+    computeCacheDiffPts(edge, node, newPts);
 
     bool changed = false;
     for (PointsTo::iterator piter = newPts.begin(), epiter = newPts.end(); piter != epiter; ++piter) {
@@ -103,11 +112,8 @@ bool AndersenWaveDiff::handleLoad(NodeID node, const ConstraintEdge* edge)
 bool AndersenWaveDiff::handleStore(NodeID node, const ConstraintEdge* edge)
 {
     /// calculate diff pts.
-    PointsTo & cache = getCachePts(edge);
-    PointsTo & pts = getPts(node);
     PointsTo newPts;
-    newPts.intersectWithComplement(pts, cache);
-    cache |= newPts;
+    computeCacheDiffPts(edge, node, newPts);
 
     bool changed = false;
     for (PointsTo::iterator piter = newPts.begin(), epiter = newPts.end(); piter != epiter; ++piter) {
@@ -155,3 +161,151 @@ void AndersenWaveDiff::mergeNodeToRep(NodeID nodeId,NodeID newRepId) {
 
     Andersen::mergeNodeToRep(nodeId, newRepId);
 }
+
+/*!
+ * [OS-CFI] Wave propagation in parallel.
+ * Nodes are grouped into levels by the longest chain of direct edges reaching
+ * them, so no direct edge connects two nodes of the same level. Nodes whose
+ * out edges may change the graph (gep edges, PWC collapsing) are processed
+ * one by one as before, the copy edges of all other nodes of a level are
+ * unioned by parallel threads. Non-commutative steps keep a fixed order, so
+ * the result does not depend on the number of threads.
+ */
+void AndersenWaveDiff::solve()
+{
+    // processCast() of subclasses is not thread-safe
+    if (AnderJobs <= 1 || getAnalysisTy() != AndersenWaveDiff_WPA) {
+        AndersenWave::solve();
+        return;
+    }
+
+    NodeStack& nodeStack = SCCDetect();
+
+    std::vector<NodeVector> levels;
+    DenseMap<NodeID, u32_t> nodeLevel;
+    while (!nodeStack.empty()) {
+        NodeID nodeId = nodeStack.top();
+        nodeStack.pop();
+        u32_t level = nodeLevel.lookup(nodeId);
+        if (levels.size() <= level)
+            levels.resize(level + 1);
+        levels[level].push_back(nodeId);
+
+        ConstraintNode* node = consCG->getConstraintNode(nodeId);
+        for (ConstraintNode::const_iterator it = node->directOutEdgeBegin(), eit = node->directOutEdgeEnd();
+                it != eit; ++it) {
+            u32_t& dstLevel = nodeLevel[sccRepNode((*it)->getDstID())];
+            if (dstLevel < level + 1)
+                dstLevel = level + 1;
+        }
+    }
+
+    for (u32_t level = 0; level < levels.size(); level++) {
+        NodeVector copyNodes;
+        for (NodeVector::const_iterator it = levels[level].begin(), eit = levels[level].end(); it != eit; ++it) {
+            if (isParallelCopyNode(*it))
+                copyNodes.push_back(*it);
+            else
+                processNode(*it);
+        }
+        propagateCopiesInParallel(copyNodes);
+    }
+
+    while (!isWorklistEmpty()) {
+        NodeID nodeId = popFromWorklist();
+        postProcessNode(nodeId);
+    }
+}
+
+/*!
+ * [OS-CFI] A rep node whose direct out edges are all copy edges
+ */
+bool AndersenWaveDiff::isParallelCopyNode(NodeID nodeId)
+{
+    if (sccRepNode(nodeId) != nodeId || consCG->isPWCNode(nodeId))
+        return false;
+    ConstraintNode* node = consCG->getConstraintNode(nodeId);
+    for (ConstraintNode::const_iterator it = node->directOutEdgeBegin(), eit = node->directOutEdgeEnd(); it != eit;
+            ++it) {
+        if (!isa<CopyCGEdge>(*it))
+            return false;
+    }
+    return true;
+}
+
+/*!
+ * [OS-CFI] Union the diff points-to sets of the nodes into their copy
+ * successors. All map lookups happen here, so the threads only touch the
+ * sets: a destination set under its lock stripe, a reverse points-to set by
+ * the thread owning its object.
+ */
+void AndersenWaveDiff::propagateCopiesInParallel(const NodeVector& nodes)
+{
+    struct CopyTask {
+        NodeID dst;
+        const PointsTo* srcPts;
+        PointsTo* dstPts;
+    };
+
+    std::vector<CopyTask> tasks;
+    PointsTo objs;
+    for (NodeVector::const_iterator it = nodes.begin(), eit = nodes.end(); it != eit; ++it) {
+        // an earlier node of this level may have merged or extended it
+        if (!isParallelCopyNode(*it)) {
+            processNode(*it);
+            continue;
+        }
+        computeDiffPts(*it);
+        const PointsTo& diffPts = getDiffPts(*it);
+        if (diffPts.empty())
+            continue;
+        objs |= diffPts;
+        ConstraintNode* node = consCG->getConstraintNode(*it);
+        for (ConstraintNode::const_iterator eit = node->directOutEdgeBegin(), eeit = node->directOutEdgeEnd();
+                eit != eeit; ++eit) {
+            NodeID dst = (*eit)->getDstID();
+            CopyTask task = {dst, &diffPts, &getDiffPTDataTy()->getPts(dst)};
+            tasks.push_back(task);
+        }
+    }
+    if (tasks.empty())
+        return;
+    numOfProcessedCopy += tasks.size();
+
+    double propStart = stat->getClk();
+
+    DenseMap<NodeID, PointsTo*> objToRevPts;
+    for (PointsTo::iterator it = objs.begin(), eit = objs.end(); it != eit; ++it)
+        objToRevPts[*it] = &getDiffPTDataTy()->getRevPts(*it);
+    const DenseMap<NodeID, PointsTo*>& revPts = objToRevPts;
+
+    u32_t jobs = std::min<u32_t>(AnderJobs, tasks.size() / MinCopiesPerJob + 1);
+    std::vector<char> changed(tasks.size(), 0);
+    std::mutex locks[NumOfPtsLocks];
+    auto worker = [&](u32_t job) {
+        for (u32_t i = job; i < tasks.size(); i += jobs) {
+            std::lock_guard<std::mutex> guard(locks[tasks[i].dst % NumOfPtsLocks]);
+            changed[i] = (*tasks[i].dstPts |= *tasks[i].srcPts);
+        }
+        for (u32_t i = 0; i < tasks.size(); i++) {
+            for (PointsTo::iterator it = tasks[i].srcPts->begin(), eit = tasks[i].srcPts->end(); it != eit; ++it) {
+                if (*it % jobs == job)
+                    revPts.find(*it)->second->set(tasks[i].dst);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (u32_t job = 1; job < jobs; job++)
+        threads.push_back(std::thread(worker, job));
+    worker(0);
+    for (u32_t job = 0; job < threads.size(); job++)
+        threads[job].join();
+
+    for (u32_t i = 0; i < tasks.size(); i++) {
+        if (changed[i])
+            pushIntoWorklist(tasks[i].dst);
+    }
+
+    double propEnd = stat->getClk();
+    timeOfProcessCopyGep += (propEnd - propStart) / TIMEINTERVAL;
+}
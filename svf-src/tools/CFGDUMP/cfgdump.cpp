@@ -0,0 +1,42 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "DDA/CFGStream.h"
+
+#include <llvm/Support/CommandLine.h> // for cl
+#include <llvm/Support/raw_ostream.h> // for outs
+
+using namespace llvm;
+
+static cl::opt<std::string> InputFilename(cl::Positional,
+                                          cl::desc("<CFG stream>"),
+                                          cl::Required);
+
+// [OS-CFI] print the records of a CFG stream as tab-separated lines: the
+// kind, the target type, the call-site id, the target id and the context ids
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "OS-CFI CFG Stream Dump\n");
+
+  CFGStreamReader reader(InputFilename);
+  if (!reader.isOpen())
+    return 1;
+
+  CFGRecord rec;
+  while (reader.next(rec)) {
+    outs() << rec.kind << "\t" << rec.target << "\t" << rec.iCallID << "\t"
+           << rec.iCallTargetID;
+    for (std::vector<u64_t>::iterator it = rec.context.begin();
+         it != rec.context.end(); ++it) {
+      outs() << "\t" << *it;
+    }
+    outs() << "\n";
+  }
+
+  if (reader.isTruncated()) {
+    errs() << "[OS-CFI] '" << InputFilename << "' ends in a partial record\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * Origin-sensitive Control Flow Integrity
+ * Author: Mustakimur R. Khandaker (mrk15e@my.fsu.edu)
+ * Affliation: Florida State University
+ */
+#include "DDA/ECSelector.h"
+
+#include <llvm/Support/CommandLine.h> // for cl
+#include <llvm/Support/raw_ostream.h> // for outs
+
+using namespace llvm;
+
+static cl::opt<std::string> DirPath(cl::Positional,
+                                    cl::desc("<target project directory>"),
+                                    cl::Required);
+
+static cl::opt<std::string>
+    CFGIn("cfg-in", cl::init(""),
+          cl::desc("CFG stream written by oscfg, <directory>/cfg.bin if none"));
+
+// [OS-CFI] pick the CFG policy of every ICT from the CFG stream and write the
+// tables INSTCFG instruments into the target project directory
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "OS-CFI EC Selection\n");
+
+  std::string path = CFGIn.empty() ? DirPath + "/cfg.bin" : CFGIn;
+  CFGStreamReader reader(path);
+  if (!reader.isOpen())
+    return 1;
+
+  ECSelector selector;
+  CFGRecord rec;
+  while (reader.next(rec))
+    selector.add(rec);
+  if (reader.isTruncated()) {
+    errs() << "[OS-CFI] '" << path << "' ends in a partial record\n";
+    return 1;
+  }
+
+  selector.select();
+  if (!selector.write(DirPath)) {
+    errs() << "[OS-CFI] cannot write the CFG tables into '" << DirPath
+           << "'\n";
+    return 1;
+  }
+  selector.printSummary(outs());
+  return 0;
+}
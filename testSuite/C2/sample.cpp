@@ -0,0 +1,56 @@
+// llvm-check-elim cases: a dominated duplicate check, a loop invariant check
+// and a check kept across a write that may alias its slot
+
+#include <cstdio>
+#include <cstring>
+
+typedef void (*fnptr)();
+
+void CallA() { puts("Target A"); }
+
+void CallB() { puts("Target B"); }
+
+fnptr __attribute__((noinline)) pick(int a) {
+  if (a > 10)
+    return &CallA;
+  return &CallB;
+}
+
+// the second call checks the same slot under the same metadata, its check is
+// dominated by the first one and removed
+void duplicate(int a) {
+  fnptr fp = pick(a);
+  fp();
+  fp();
+}
+
+// nothing in the loop writes the slot, its check runs once before the loop
+void invariant(int a, int n) {
+  fnptr fp = pick(a);
+  for (int i = 0; i < n; i++)
+    fp();
+}
+
+// the store through p may write the slot, both checks stay
+void clobbered(int a) {
+  fnptr fp = pick(a);
+  fnptr other = NULL;
+  fnptr *p = a > 15 ? &fp : &other;
+  fp();
+  *p = &CallB;
+  fp();
+}
+
+int main() {
+  char mode[8];
+  int a = 0, n = 0;
+  if (scanf("%7s %d %d", mode, &a, &n) < 2)
+    return 1;
+  if (!strcmp(mode, "dup"))
+    duplicate(a);
+  else if (!strcmp(mode, "loop"))
+    invariant(a, n);
+  else if (!strcmp(mode, "alias"))
+    clobbered(a);
+  return 0;
+}
@@ -0,0 +1,109 @@
+// runtime cases: code pointers moved by realloc and memcpy keep their origin
+// metadata, blocks holding code pointers are freed by several threads
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+
+typedef void (*fnptr)();
+
+void CallA() { puts("Target A"); }
+
+void CallB() { puts("Target B"); }
+
+// called by the threads, they only count
+volatile long threadCalls = 0;
+
+void CallC() { __sync_fetch_and_add(&threadCalls, 1); }
+
+void CallD() { __sync_fetch_and_add(&threadCalls, 2); }
+
+typedef struct handlerStruct {
+  char name[8];
+  fnptr fp;
+} handler;
+
+// at least SHADOW_RECLAIM_SIZE, freeing it drops the metadata of the block
+typedef struct bigHandlerStruct {
+  fnptr fp;
+  char buf[32768];
+} bigHandler;
+
+// the grown table no longer fits in place, realloc moves it
+void moveByRealloc(int a) {
+  fnptr *table = (fnptr *)malloc(4 * sizeof(fnptr));
+  if (a > 10)
+    table[1] = &CallA;
+  else
+    table[1] = &CallB;
+  table = (fnptr *)realloc(table, 65536 * sizeof(fnptr));
+  table[1]();
+  // a large table grows and shrinks, the runtime moves the grown one itself
+  table = (fnptr *)realloc(table, 131072 * sizeof(fnptr));
+  table[1]();
+  table = (fnptr *)realloc(table, 8 * sizeof(fnptr));
+  table[1]();
+  free(table);
+}
+
+void moveByMemcpy(int a) {
+  handler src;
+  strcpy(src.name, "copy");
+  if (a > 10)
+    src.fp = &CallA;
+  else
+    src.fp = &CallB;
+  handler *dst = (handler *)malloc(sizeof(handler));
+  memcpy(dst, &src, sizeof(handler));
+  dst->fp();
+  free(dst);
+}
+
+// the next block of a thread often reuses the address of the one it freed or
+// deleted, the call through it must be checked against the new metadata only
+void *worker(void *arg) {
+  long id = (long)arg;
+  for (int i = 0; i < 256; i++) {
+    bigHandler *big = (bigHandler *)malloc(sizeof(bigHandler));
+    if ((id + i) % 2)
+      big->fp = &CallC;
+    else
+      big->fp = &CallD;
+    big->fp();
+    free(big);
+
+    bigHandler *obj = new bigHandler;
+    obj->fp = (id + i) % 3 ? &CallD : &CallC;
+    obj->fp();
+    delete obj;
+
+    handler *small = (handler *)malloc(sizeof(handler));
+    if ((id + i) % 2)
+      small->fp = &CallD;
+    else
+      small->fp = &CallC;
+    small->fp();
+    free(small);
+  }
+  return NULL;
+}
+
+void freeInThreads() {
+  pthread_t threads[4];
+  for (long i = 0; i < 4; i++)
+    pthread_create(&threads[i], NULL, worker, (void *)i);
+  for (int i = 0; i < 4; i++)
+    pthread_join(threads[i], NULL);
+  puts("Threads done");
+}
+
+int main() {
+  int a = 0;
+  if (scanf("%d", &a) < 1)
+    return 1;
+  moveByRealloc(a);
+  moveByMemcpy(a);
+  freeInThreads();
+  return 0;
+}
@@ -0,0 +1,43 @@
+// origin sub-results shared by queries: the pointer of the first call flows
+// from two loads of the same slot, so the second load only produces tuples
+// the first query already has. The second call reaches that load again and
+// must still get all its tuples
+
+#include <cstdio>
+#include <cstdlib>
+
+typedef void (*fnptr)();
+
+void CallA() { puts("Target A"); }
+
+void CallB() { puts("Target B"); }
+
+typedef struct handlerStruct {
+  fnptr fp;
+} handler;
+
+void __attribute__((noinline)) set(handler *h, int a) {
+  if (a > 10)
+    h->fp = &CallA;
+  else
+    h->fp = &CallB;
+}
+
+void __attribute__((noinline)) run(handler *h, handler *k, int c) {
+  fnptr x = h->fp;
+  fnptr y = c > 15 ? k->fp : x;
+  y();
+  x();
+}
+
+int main() {
+  int a = 0, c = 0;
+  if (scanf("%d %d", &a, &c) < 2)
+    return 1;
+  handler *h = (handler *)malloc(sizeof(handler));
+  handler *other = (handler *)malloc(sizeof(handler));
+  set(h, a);
+  set(other, 20 - a);
+  run(h, c > 20 ? h : other, c);
+  return 0;
+}
@@ -4,3 +4,64 @@ cd C1/run/
 ./sample_exec <<< '20 he'
 ./sample_exec <<< '20 heeeeeee'
 cd ../../
+
+# [OS-CFI] run a case, no check may fail and, when given, the number of
+# pcall checks that ran must match
+check() {
+  ./sample_exec <<< "$1" 2> errs.txt
+  passed=$(awk '$1 ~ /^(oscfi_pcall(_[0-3])?:?|ref_pcall)$/ { n += $2 }
+                END { print n + 0 }' errs.txt)
+  if grep -q "OSCFI-LOG" errs.txt || [ -n "$2" -a "$passed" != "$2" ]; then
+    echo "FAIL: $(pwd) <<< '$1', $passed pcall checks"
+    cat errs.txt
+  else
+    echo "PASS: $(pwd) <<< '$1'"
+  fi
+}
+
+# [OS-CFI] build a case with the settings of $3 and again with those of $2 in
+# the environment, the CFG the solver streams out must not change
+same_cfg() {
+  env $3 ../run.sh < "in$1"
+  cp "$1/run/cfg.bin" "$1/run/cfg.first.bin"
+  env $2 ../run.sh < "in$1"
+  if cmp -s "$1/run/cfg.first.bin" "$1/run/cfg.bin"; then
+    echo "PASS: $1 same CFG with $2"
+  else
+    echo "FAIL: $1 CFG changed with $2"
+  fi
+}
+
+# llvm-check-elim
+../run.sh < inC2
+cd C2/run/
+check 'dup 20' 1
+check 'loop 20 5' 1
+check 'loop 5 0' 0
+check 'alias 20' 2
+check 'alias 12' 2
+cd ../../
+
+# realloc, memcpy and multithreaded free
+../run.sh < inC3
+cd C3/run/
+check '20'
+check '5'
+cd ../../
+
+# origin sub-results shared by two queries
+../run.sh < inC4
+cd C4/run/
+check '20 25'
+check '5 25'
+check '20 18'
+check '20 10'
+cd ../../
+
+# the SVFG snapshot does not change the solver results
+same_cfg C1 SVFG_CSR=
+same_cfg C4 SVFG_CSR=
+
+# the number of query workers does not change the solver results
+same_cfg C1 "DDA_SHARD_SIZE=1 DDA_JOBS=1" "DDA_SHARD_SIZE=1 DDA_JOBS=4"
+same_cfg C4 "DDA_SHARD_SIZE=1 DDA_JOBS=1" "DDA_SHARD_SIZE=1 DDA_JOBS=4"